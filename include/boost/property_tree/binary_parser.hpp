@@ -0,0 +1,131 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_BINARY_PARSER_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_BINARY_PARSER_HPP_INCLUDED
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/detail/binary_parser_error.hpp>
+#include <boost/property_tree/detail/binary_parser_view.hpp>
+#include <boost/property_tree/detail/binary_parser_read.hpp>
+#include <boost/property_tree/detail/binary_parser_write.hpp>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace boost { namespace property_tree { namespace binary_parser
+{
+
+    /**
+     * Translate the property tree from the binary format in the given
+     * memory, as written by write_binary. To look up values without
+     * building a tree, use basic_binary_view on the memory instead.
+     * @note Replaces the existing contents. Strong exception guarantee.
+     * @throw binary_parser_error If the memory does not hold valid data in
+     *                            the binary format.
+     */
+    template<class Ptree>
+    void read_binary(const void *data, std::size_t size, Ptree &pt)
+    {
+        basic_binary_view<typename Ptree::key_type::value_type>
+            root(data, size);
+        Ptree local(pt.get_allocator());
+        detail::read_binary_internal(root, local);
+        pt.swap(local);
+    }
+
+    /**
+     * Read the binary format from the given stream and translate it to a
+     * property tree. The stream should be opened in binary mode.
+     * @note Replaces the existing contents. Strong exception guarantee.
+     * @throw binary_parser_error If the stream cannot be read or does not
+     *                            hold valid data in the binary format.
+     */
+    template<class Ptree>
+    void read_binary(std::istream &stream, Ptree &pt)
+    {
+        std::vector<boost::uint64_t> buffer;
+        std::size_t size;
+        detail::read_binary_stream(stream, buffer, size, std::string());
+        read_binary(buffer.empty() ? 0 : &buffer[0], size, pt);
+    }
+
+    /**
+     * Read the binary format from the given file and translate it to a
+     * property tree.
+     * @note Replaces the existing contents. Strong exception guarantee.
+     * @throw binary_parser_error If the file cannot be read or does not
+     *                            hold valid data in the binary format.
+     */
+    template<class Ptree>
+    void read_binary(const std::string &filename, Ptree &pt)
+    {
+        std::ifstream stream(filename.c_str(), std::ios_base::binary);
+        if (!stream) {
+            BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                "cannot open file for reading", filename, 0));
+        }
+        std::vector<boost::uint64_t> buffer;
+        std::size_t size;
+        detail::read_binary_stream(stream, buffer, size, filename);
+        try {
+            read_binary(buffer.empty() ? 0 : &buffer[0], size, pt);
+        } catch (binary_parser_error &e) {
+            BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                e.message(), filename, 0));
+        }
+    }
+
+    /**
+     * Translate the property tree to the binary format and write it to the
+     * given stream, which should be opened in binary mode. Keys and data
+     * are stored as characters of the tree's key type; data that is not of
+     * that type is converted to it.
+     * @throw binary_parser_error If the stream cannot be written to, or the
+     *                            tree has more than 2^32 - 1 nodes.
+     */
+    template<class Ptree>
+    void write_binary(std::ostream &stream, const Ptree &pt)
+    {
+        detail::write_binary_internal(stream, pt, std::string());
+    }
+
+    /**
+     * Translate the property tree to the binary format and write it to the
+     * given file.
+     * @throw binary_parser_error If the file cannot be written to, or the
+     *                            tree has more than 2^32 - 1 nodes.
+     */
+    template<class Ptree>
+    void write_binary(const std::string &filename, const Ptree &pt)
+    {
+        std::ofstream stream(filename.c_str(),
+                             std::ios_base::out | std::ios_base::binary);
+        if (!stream) {
+            BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                "cannot open file for writing", filename, 0));
+        }
+        detail::write_binary_internal(stream, pt, filename);
+    }
+
+} } }
+
+namespace boost { namespace property_tree
+{
+    using binary_parser::binary_parser_error;
+    using binary_parser::read_binary;
+    using binary_parser::write_binary;
+    using binary_parser::basic_binary_view;
+    using binary_parser::binary_view;
+#ifndef BOOST_NO_CWCHAR
+    using binary_parser::wbinary_view;
+#endif
+} }
+
+#endif
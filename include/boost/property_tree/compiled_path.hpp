@@ -0,0 +1,71 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_COMPILED_PATH_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_COMPILED_PATH_HPP_INCLUDED
+
+#include <boost/property_tree/ptree_fwd.hpp>
+#include <boost/property_tree/string_path.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace boost { namespace property_tree
+{
+
+    /**
+     * A path that has been split into its fragments, and the fragments
+     * translated to keys, once and for all. Paths that are used over and
+     * over can be compiled up front; basic_ptree has overloads of its
+     * path-based members that walk a compiled path key by key, without
+     * scanning for separators again.
+     *
+     * @code
+     * static const ptree::compiled_path_type port("server.net.port");
+     * int p = pt.get<int>(port);
+     * @endcode
+     */
+    template <typename Key>
+    class compiled_path
+    {
+        typedef std::vector<Key> keys_type;
+    public:
+        typedef Key key_type;
+        typedef typename path_of<Key>::type path_type;
+        typedef typename keys_type::const_iterator const_iterator;
+
+        /// Split and translate @p path.
+        explicit compiled_path(const path_type &path)
+            : m_dump(path.dump())
+        {
+            path_type p(path);
+            while (!p.empty()) {
+                m_keys.push_back(p.reduce());
+            }
+        }
+
+        /// Iterate over the keys, from the root downwards.
+        const_iterator begin() const { return m_keys.begin(); }
+        const_iterator end() const { return m_keys.end(); }
+
+        /// The number of keys in the path.
+        std::size_t size() const { return m_keys.size(); }
+
+        /// Return true if the path is empty.
+        bool empty() const { return m_keys.empty(); }
+
+        /// The path as it was written, for exception messages.
+        std::string dump() const { return m_dump; }
+
+    private:
+        keys_type m_keys;
+        std::string m_dump;
+    };
+
+} }
+
+#endif
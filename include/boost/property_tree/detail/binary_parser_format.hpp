@@ -0,0 +1,166 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_DETAIL_BINARY_PARSER_FORMAT_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_DETAIL_BINARY_PARSER_FORMAT_HPP_INCLUDED
+
+#include <boost/property_tree/ptree_fwd.hpp>
+#include <boost/property_tree/detail/binary_parser_error.hpp>
+#include <boost/cstdint.hpp>
+#include <cstddef>
+#include <cstring>
+
+namespace boost { namespace property_tree { namespace binary_parser {
+    namespace detail
+{
+
+    // The binary format. Integers are in the byte order of the machine
+    // that wrote the data; the header records it, so that other machines
+    // refuse the data rather than misread it.
+    //
+    //  offset size  header field
+    //       0    4  magic "PTRB"
+    //       4    4  byte order mark 0x01020304
+    //       8    2  format version
+    //      10    2  sizeof(Ch)
+    //      12    4  number of nodes
+    //      16    4  number of strings
+    //      20    4  reserved, zero
+    //      24    8  offset of the node table
+    //      32    8  offset of the child order table
+    //      40    8  offset of the string offset table
+    //      48    8  offset of the string data
+    //      56    8  total size
+    //
+    // Node table: per node, four 32-bit words: the key string, the data
+    // string, the first child and the number of children. Node 0 is the
+    // root. The children of each node are consecutive, in document order.
+    //
+    // Child order table: one 32-bit node number per node. At the positions
+    // of a node's children, it lists them sorted by key, equal keys in
+    // document order, so that a key can be found by binary search.
+    //
+    // String offset table: per string, its 64-bit offset in the string
+    // data. Equal keys and values share one string.
+    //
+    // String data: per string, its length in characters as a varint (seven
+    // bits per byte, least significant first), padding to a multiple of
+    // sizeof(Ch), then the characters.
+    const std::size_t header_size = 64;
+    const std::size_t node_size = 16;
+    const boost::uint32_t byte_order_mark = 0x01020304;
+    const boost::uint16_t format_version = 1;
+    const char magic[4] = { 'P', 'T', 'R', 'B' };
+
+    template<class T>
+    T load(const unsigned char *p)
+    {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+    inline void corrupt()
+    {
+        BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+            "corrupt binary data", "", 0));
+    }
+
+    // Where the parts of the data are. Checked once when the data is
+    // opened; node and string entries are checked as they are used.
+    struct layout
+    {
+        const unsigned char *base;
+        boost::uint64_t size;
+        boost::uint32_t node_count;
+        boost::uint32_t string_count;
+        boost::uint64_t nodes;
+        boost::uint64_t order;
+        boost::uint64_t strings;
+        boost::uint64_t blob;
+
+        boost::uint32_t node_field(boost::uint32_t node, int field) const
+        {
+            return load<boost::uint32_t>(
+                base + nodes + node * node_size + field * 4);
+        }
+
+        boost::uint32_t ordered_child(boost::uint32_t position) const
+        {
+            boost::uint32_t node = load<boost::uint32_t>(
+                base + order + boost::uint64_t(position) * 4);
+            if (node >= node_count)
+                corrupt();
+            return node;
+        }
+
+        template<class Ch>
+        const Ch *string(boost::uint32_t id, std::size_t &length) const
+        {
+            if (id >= string_count)
+                corrupt();
+            boost::uint64_t pos = blob +
+                load<boost::uint64_t>(base + strings + boost::uint64_t(id) * 8);
+            boost::uint64_t n = 0;
+            for (int shift = 0; ; shift += 7) {
+                if (pos >= size || shift > 63)
+                    corrupt();
+                unsigned char byte = base[pos++];
+                n |= boost::uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    break;
+            }
+            pos = (pos + sizeof(Ch) - 1) / sizeof(Ch) * sizeof(Ch);
+            if (pos > size || n > (size - pos) / sizeof(Ch))
+                corrupt();
+            length = static_cast<std::size_t>(n);
+            return reinterpret_cast<const Ch *>(base + pos);
+        }
+    };
+
+    template<class Ch>
+    layout open_layout(const void *data, std::size_t size)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        if (size < header_size || std::memcmp(p, magic, 4) != 0)
+            BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                "not binary property tree data", "", 0));
+        if (load<boost::uint32_t>(p + 4) != byte_order_mark ||
+            load<boost::uint16_t>(p + 10) != sizeof(Ch))
+            BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                "binary data has a different byte order or character size",
+                "", 0));
+        if (load<boost::uint16_t>(p + 8) != format_version)
+            BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                "unsupported binary format version", "", 0));
+        if (reinterpret_cast<std::size_t>(p) % sizeof(Ch) != 0)
+            BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                "binary data is not aligned for its characters", "", 0));
+
+        layout l;
+        l.base = p;
+        l.node_count = load<boost::uint32_t>(p + 12);
+        l.string_count = load<boost::uint32_t>(p + 16);
+        l.nodes = load<boost::uint64_t>(p + 24);
+        l.order = load<boost::uint64_t>(p + 32);
+        l.strings = load<boost::uint64_t>(p + 40);
+        l.blob = load<boost::uint64_t>(p + 48);
+        l.size = load<boost::uint64_t>(p + 56);
+        if (l.size > size || l.node_count == 0 ||
+            l.nodes > l.size ||
+            (l.size - l.nodes) / node_size < l.node_count ||
+            l.order > l.size || (l.size - l.order) / 4 < l.node_count ||
+            l.strings > l.size ||
+            (l.size - l.strings) / 8 < l.string_count ||
+            l.blob > l.size)
+            corrupt();
+        return l;
+    }
+
+} } } }
+
+#endif
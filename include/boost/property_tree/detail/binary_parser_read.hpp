@@ -0,0 +1,78 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_DETAIL_BINARY_PARSER_READ_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_DETAIL_BINARY_PARSER_READ_HPP_INCLUDED
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/detail/binary_parser_view.hpp>
+#include <boost/property_tree/detail/parser_io.hpp>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace boost { namespace property_tree { namespace binary_parser {
+    namespace detail
+{
+
+    template<class Ptree, class It>
+    struct read_frame
+    {
+        Ptree *node;
+        It next, end;
+    };
+
+    // Copy the tree under root into pt. The format has no limit on depth,
+    // so deep trees are walked with an explicit stack.
+    template<class Ptree>
+    void read_binary_internal(const basic_binary_view<
+                                  typename Ptree::key_type::value_type> &root,
+                              Ptree &pt)
+    {
+        typedef typename Ptree::key_type Str;
+        typedef basic_binary_view<typename Str::value_type> view;
+        typedef read_frame<Ptree, typename view::const_iterator> frame;
+        std::vector<frame> stack;
+        typename view::string_view_type data = root.data();
+        pt.put_value(Str(data.begin(), data.end()));
+        frame top = { &pt, root.begin(), root.end() };
+        stack.push_back(top);
+        while (!stack.empty()) {
+            frame &f = stack.back();
+            if (f.next == f.end) {
+                stack.pop_back();
+                continue;
+            }
+            view child = *f.next;
+            ++f.next;
+            typename view::string_view_type key = child.key();
+            Ptree &node = f.node->push_back(std::make_pair(
+                Str(key.begin(), key.end()), Ptree()))->second;
+            data = child.data();
+            node.put_value(Str(data.begin(), data.end()));
+            frame next = { &node, child.begin(), child.end() };
+            stack.push_back(next);
+        }
+    }
+
+    // Read the whole stream into memory, suitably aligned for the
+    // characters of the format.
+    inline void read_binary_stream(std::istream &stream,
+                                   std::vector<boost::uint64_t> &buffer,
+                                   std::size_t &size,
+                                   const std::string &filename)
+    {
+        size = property_tree::detail::read_stream(stream, buffer);
+        if (!stream.rdbuf() || stream.bad())
+            BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                "read error", filename, 0));
+        stream.setstate(std::ios_base::eofbit);
+    }
+
+} } } }
+
+#endif
@@ -0,0 +1,319 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_DETAIL_BINARY_PARSER_VIEW_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_DETAIL_BINARY_PARSER_VIEW_HPP_INCLUDED
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/detail/binary_parser_format.hpp>
+#include <boost/optional.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <typeinfo>
+
+namespace boost { namespace property_tree { namespace binary_parser
+{
+
+    /**
+     * A read-only node of a property tree in the binary format, read
+     * directly from the data, such as a mapped file. Nothing is copied or
+     * allocated to open the data or to navigate it; keys and values refer
+     * to the data, which must outlive the views.
+     *
+     * Children are iterated in document order and found by key with a
+     * binary search. Keys are compared by character value, whatever the
+     * comparison of the tree that was written.
+     */
+    template<class Ch>
+    class basic_binary_view
+    {
+    public:
+        typedef Ch char_type;
+        typedef std::basic_string<Ch> string_type;
+        typedef boost::basic_string_view<Ch> string_view_type;
+        typedef std::size_t size_type;
+
+        class const_iterator;
+        typedef const_iterator iterator;
+
+        /** A view of nothing; only assignable. */
+        basic_binary_view() : m_node(0) { m_layout.base = 0; }
+
+        /**
+         * The root of the tree in @p data, as written by write_binary. Only
+         * the header is checked, so this takes constant time.
+         * @throw binary_parser_error If the data is not in the binary
+         *                            format, or was written on a machine
+         *                            with another byte order or character
+         *                            size.
+         */
+        basic_binary_view(const void *data, std::size_t size)
+            : m_layout(detail::open_layout<Ch>(data, size)), m_node(0)
+        {
+        }
+
+        /** The key of this node in its parent. */
+        string_view_type key() const {
+            return string(field(0));
+        }
+
+        /** The data of this node. */
+        string_view_type data() const {
+            return string(field(1));
+        }
+
+        size_type size() const { return field(3); }
+        bool empty() const { return field(3) == 0; }
+
+        const_iterator begin() const {
+            return const_iterator(m_layout, first_child());
+        }
+        const_iterator end() const {
+            return const_iterator(m_layout, first_child() + field(3));
+        }
+
+        /**
+         * The first child with the given key, in document order, or end().
+         * Takes logarithmic time.
+         */
+        const_iterator find(string_view_type key) const {
+            boost::uint32_t first = first_child(), count = field(3);
+            boost::uint32_t position = lower_bound(first, count, key);
+            if (position != first + count) {
+                boost::uint32_t node = m_layout.ordered_child(position);
+                if (key == node_key(node))
+                    return const_iterator(m_layout, node);
+            }
+            return end();
+        }
+
+        /** The number of children with the given key. */
+        size_type count(string_view_type key) const {
+            boost::uint32_t first = first_child(), count = field(3);
+            boost::uint32_t position = lower_bound(first, count, key);
+            size_type n = 0;
+            for (; position != first + count &&
+                   key == node_key(m_layout.ordered_child(position));
+                 ++position)
+                ++n;
+            return n;
+        }
+
+        /**
+         * The node at the given path, with keys separated by
+         * @p separator, if there is one.
+         */
+        optional<basic_binary_view> get_child_optional(
+            string_view_type path, Ch separator = Ch('.')) const
+        {
+            basic_binary_view node(*this);
+            if (path.empty())
+                return node;
+            for (;;) {
+                typename string_view_type::size_type end =
+                    path.find(separator);
+                const_iterator it = node.find(path.substr(0, end));
+                if (it == node.end())
+                    return optional<basic_binary_view>();
+                node = *it;
+                if (end == string_view_type::npos)
+                    return node;
+                path.remove_prefix(end + 1);
+            }
+        }
+
+        /**
+         * The node at the given path.
+         * @throw ptree_bad_path If there is no such node.
+         */
+        basic_binary_view get_child(string_view_type path,
+                                    Ch separator = Ch('.')) const
+        {
+            if (optional<basic_binary_view> child =
+                    get_child_optional(path, separator))
+                return *child;
+            BOOST_PROPERTY_TREE_THROW(ptree_bad_path("No such node",
+                typename path_of<string_type>::type(
+                    string_type(path.begin(), path.end()), separator)));
+        }
+
+        /**
+         * The data of this node, translated to @c Type as basic_ptree would
+         * translate it.
+         */
+        template<class Type>
+        optional<Type> get_value_optional() const {
+            string_view_type d = data();
+            typename translator_between<string_type, Type>::type tr;
+            return tr.get_value(string_type(d.begin(), d.end()));
+        }
+
+        /**
+         * The data of this node, translated to @c Type.
+         * @throw ptree_bad_data If the conversion fails.
+         */
+        template<class Type>
+        Type get_value() const {
+            if (optional<Type> o = get_value_optional<Type>())
+                return *o;
+            string_view_type d = data();
+            BOOST_PROPERTY_TREE_THROW(ptree_bad_data(
+                std::string("conversion of data to type \"") +
+                typeid(Type).name() + "\" failed",
+                string_type(d.begin(), d.end())));
+        }
+
+        /** The data at the given path, translated to @c Type. */
+        template<class Type>
+        optional<Type> get_optional(string_view_type path) const {
+            if (optional<basic_binary_view> child = get_child_optional(path))
+                return child->template get_value_optional<Type>();
+            return optional<Type>();
+        }
+
+        /**
+         * The data at the given path, translated to @c Type.
+         * @throw ptree_bad_path If there is no such node.
+         * @throw ptree_bad_data If the conversion fails.
+         */
+        template<class Type>
+        Type get(string_view_type path) const {
+            return get_child(path).template get_value<Type>();
+        }
+
+        /**
+         * The data at the given path, translated to @c Type, or
+         * @p default_value if there is no such node or the conversion
+         * fails.
+         */
+        template<class Type>
+        Type get(string_view_type path, const Type &default_value) const {
+            if (optional<Type> o = get_optional<Type>(path))
+                return *o;
+            return default_value;
+        }
+
+    private:
+        basic_binary_view(const detail::layout &layout, boost::uint32_t node)
+            : m_layout(layout), m_node(node) {}
+
+        boost::uint32_t field(int f) const {
+            return m_layout.node_field(m_node, f);
+        }
+
+        // Children come after their parent, so that corrupt data cannot
+        // make a node its own descendant.
+        boost::uint32_t first_child() const {
+            boost::uint32_t first = field(2), count = field(3);
+            if (first > m_layout.node_count ||
+                count > m_layout.node_count - first ||
+                (count != 0 && first <= m_node))
+                detail::corrupt();
+            return first;
+        }
+
+        string_view_type string(boost::uint32_t id) const {
+            std::size_t length;
+            const Ch *chars = m_layout.template string<Ch>(id, length);
+            return string_view_type(chars, length);
+        }
+
+        string_view_type node_key(boost::uint32_t node) const {
+            return string(m_layout.node_field(node, 0));
+        }
+
+        // The first position among the ordered children whose key is not
+        // less than key.
+        boost::uint32_t lower_bound(boost::uint32_t first,
+                                    boost::uint32_t count,
+                                    string_view_type key) const {
+            while (count > 0) {
+                boost::uint32_t half = count / 2;
+                if (node_key(m_layout.ordered_child(first + half))
+                        .compare(key) < 0) {
+                    first += half + 1;
+                    count -= half + 1;
+                } else {
+                    count = half;
+                }
+            }
+            return first;
+        }
+
+        detail::layout m_layout;
+        boost::uint32_t m_node;
+    };
+
+    /**
+     * Iterates the children of a node in document order. Views are made
+     * as the iterator is dereferenced, so it yields them by value.
+     */
+    template<class Ch>
+    class basic_binary_view<Ch>::const_iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef basic_binary_view value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef basic_binary_view reference;
+
+        /** Holds the view that operator-> points to. */
+        class pointer
+        {
+        public:
+            const basic_binary_view *operator ->() const { return &m_node; }
+
+        private:
+            friend class const_iterator;
+            explicit pointer(const basic_binary_view &node) : m_node(node) {}
+
+            basic_binary_view m_node;
+        };
+
+        const_iterator() {}
+
+        reference operator *() const { return m_node; }
+        pointer operator ->() const { return pointer(m_node); }
+
+        const_iterator &operator ++() { ++m_node.m_node; return *this; }
+        const_iterator operator ++(int) {
+            const_iterator old(*this);
+            ++*this;
+            return old;
+        }
+        const_iterator &operator --() { --m_node.m_node; return *this; }
+        const_iterator operator --(int) {
+            const_iterator old(*this);
+            --*this;
+            return old;
+        }
+
+        bool operator ==(const const_iterator &other) const {
+            return m_node.m_node == other.m_node.m_node;
+        }
+        bool operator !=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class basic_binary_view<Ch>;
+        const_iterator(const detail::layout &layout, boost::uint32_t node)
+            : m_node(layout, node) {}
+
+        basic_binary_view m_node;
+    };
+
+    typedef basic_binary_view<char> binary_view;
+#ifndef BOOST_NO_CWCHAR
+    typedef basic_binary_view<wchar_t> wbinary_view;
+#endif
+
+} } }
+
+#endif
@@ -0,0 +1,182 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_DETAIL_BINARY_PARSER_WRITE_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_DETAIL_BINARY_PARSER_WRITE_HPP_INCLUDED
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/detail/binary_parser_format.hpp>
+#include <boost/property_tree/detail/parser_io.hpp>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace boost { namespace property_tree { namespace binary_parser {
+    namespace detail
+{
+
+    // Orders the children of a node by key, as the reader's binary search
+    // expects: by character value, then by length.
+    template<class Str>
+    class key_less
+    {
+    public:
+        explicit key_less(const std::vector<const Str *> &keys)
+            : m_keys(&keys) {}
+
+        bool operator ()(boost::uint32_t a, boost::uint32_t b) const
+        {
+            typedef typename Str::traits_type traits;
+            const Str &ka = *(*m_keys)[a], &kb = *(*m_keys)[b];
+            int c = traits::compare(ka.data(), kb.data(),
+                                    (std::min)(ka.size(), kb.size()));
+            return c < 0 || (c == 0 && ka.size() < kb.size());
+        }
+
+    private:
+        const std::vector<const Str *> *m_keys;
+    };
+
+    template<class T>
+    void put_raw(std::string &out, T value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    inline void put_varint(std::string &out, boost::uint64_t n)
+    {
+        while (n >= 0x80) {
+            out += static_cast<char>((n & 0x7f) | 0x80);
+            n >>= 7;
+        }
+        out += static_cast<char>(n);
+    }
+
+    template<class Ptree>
+    void write_binary_internal(std::ostream &stream, const Ptree &pt,
+                               const std::string &filename)
+    {
+        typedef typename Ptree::key_type Str;
+        typedef typename Str::value_type Ch;
+        typedef typename Ptree::const_iterator It;
+        typedef std::map<Str, boost::uint32_t> string_map;
+        const boost::uint32_t max_count =
+            (std::numeric_limits<boost::uint32_t>::max)();
+
+        // Number the nodes breadth first, so that the children of each
+        // node are consecutive. Equal strings are stored once.
+        std::vector<const Ptree *> nodes(1, &pt);
+        std::vector<const Str *> keys(1, static_cast<const Str *>(0));
+        std::vector<boost::uint32_t> words;
+        string_map ids;
+        std::vector<const Str *> strings;
+        Str empty, temp;
+        keys[0] = &empty;
+
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            const Ptree &node = *nodes[i];
+            const Str *key = keys[i];
+            const Str &data = property_tree::detail::string_data(node, temp);
+            const Str *pair[2] = { key, &data };
+            for (int s = 0; s < 2; ++s) {
+                typename string_map::iterator found = ids.lower_bound(*pair[s]);
+                if (found == ids.end() || ids.key_comp()(*pair[s], found->first)) {
+                    if (strings.size() >= max_count)
+                        BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                            "too many strings", filename, 0));
+                    found = ids.insert(found, typename string_map::value_type(
+                        *pair[s], static_cast<boost::uint32_t>(strings.size())));
+                    strings.push_back(&found->first);
+                }
+                words.push_back(found->second);
+            }
+            if (node.size() > max_count - nodes.size())
+                BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                    "too many nodes", filename, 0));
+            words.push_back(static_cast<boost::uint32_t>(nodes.size()));
+            words.push_back(static_cast<boost::uint32_t>(node.size()));
+            for (It it = node.begin(); it != node.end(); ++it) {
+                nodes.push_back(&it->second);
+                keys.push_back(&it->first);
+            }
+        }
+
+        boost::uint32_t node_count = static_cast<boost::uint32_t>(nodes.size());
+        boost::uint32_t string_count =
+            static_cast<boost::uint32_t>(strings.size());
+
+        // The children of each node, sorted by key.
+        std::vector<boost::uint32_t> order(node_count);
+        for (boost::uint32_t i = 0; i < node_count; ++i)
+            order[i] = i;
+        key_less<Str> less(keys);
+        for (boost::uint32_t i = 0; i < node_count; ++i) {
+            boost::uint32_t first = words[std::size_t(i) * 4 + 2],
+                            count = words[std::size_t(i) * 4 + 3];
+            std::stable_sort(order.begin() + first,
+                             order.begin() + first + count, less);
+        }
+
+        // Lay out the string data; the offsets are relative to its start.
+        std::string blob;
+        std::vector<boost::uint64_t> offsets(string_count);
+        for (boost::uint32_t i = 0; i < string_count; ++i) {
+            const Str &s = *strings[i];
+            offsets[i] = blob.size();
+            put_varint(blob, s.size());
+            blob.append((sizeof(Ch) - blob.size() % sizeof(Ch)) % sizeof(Ch),
+                        '\0');
+            blob.append(reinterpret_cast<const char *>(s.data()),
+                        s.size() * sizeof(Ch));
+        }
+
+        boost::uint64_t nodes_at = header_size;
+        boost::uint64_t order_at = nodes_at + node_count * node_size;
+        boost::uint64_t strings_at =
+            order_at + boost::uint64_t(node_count) * 4;
+        boost::uint64_t blob_at =
+            strings_at + boost::uint64_t(string_count) * 8;
+        std::size_t padding = static_cast<std::size_t>((8 - blob_at % 8) % 8);
+        blob_at += padding;
+        boost::uint64_t total = blob_at + blob.size();
+
+        std::string out;
+        out.reserve(static_cast<std::size_t>(blob_at));
+        out.append(magic, 4);
+        put_raw(out, byte_order_mark);
+        put_raw(out, format_version);
+        put_raw(out, static_cast<boost::uint16_t>(sizeof(Ch)));
+        put_raw(out, node_count);
+        put_raw(out, string_count);
+        put_raw(out, boost::uint32_t(0));
+        put_raw(out, nodes_at);
+        put_raw(out, order_at);
+        put_raw(out, strings_at);
+        put_raw(out, blob_at);
+        put_raw(out, total);
+        out.append(reinterpret_cast<const char *>(&words[0]),
+                   words.size() * 4);
+        out.append(reinterpret_cast<const char *>(&order[0]),
+                   order.size() * 4);
+        if (string_count)
+            out.append(reinterpret_cast<const char *>(&offsets[0]),
+                       offsets.size() * 8);
+        out.append(padding, '\0');
+
+        stream.write(out.data(), static_cast<std::streamsize>(out.size()));
+        stream.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+        if (!stream.good())
+            BOOST_PROPERTY_TREE_THROW(binary_parser_error(
+                "write error", filename, 0));
+    }
+
+} } } }
+
+#endif
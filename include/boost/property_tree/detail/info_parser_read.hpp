@@ -13,63 +13,70 @@
 #include "boost/property_tree/ptree.hpp"
 #include "boost/property_tree/detail/info_parser_error.hpp"
 #include "boost/property_tree/detail/info_parser_utils.hpp"
+#include "boost/property_tree/detail/parser_io.hpp"
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <cstddef>
 #include <iterator>
+#include <map>
 #include <string>
 #include <stack>
 #include <fstream>
-#include <cctype>
+#include <vector>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if !defined(BOOST_WINDOWS) || defined(__CYGWIN__)
+#include <unistd.h>
+#endif
 
 namespace boost { namespace property_tree { namespace info_parser
 {
 
-    // Expand known escape sequences
+    // Expand known escape sequences. Text without a backslash is returned
+    // as it is, and the runs between escapes are copied as a whole.
     template<class It>
     std::basic_string<typename std::iterator_traits<It>::value_type>
         expand_escapes(It b, It e)
     {
         typedef typename std::iterator_traits<It>::value_type Ch;
-        std::basic_string<Ch> result;
+        It run = std::find(b, e, Ch('\\'));
+        std::basic_string<Ch> result(b, run);
+        b = run;
         while (b != e)
         {
-            if (*b == Ch('\\'))
+            ++b;
+            if (b == e)
             {
-                ++b;
-                if (b == e)
-                {
-                    BOOST_PROPERTY_TREE_THROW(info_parser_error(
-                        "character expected after backslash", "", 0));
-                }
-                else if (*b == Ch('0')) result += Ch('\0');
-                else if (*b == Ch('a')) result += Ch('\a');
-                else if (*b == Ch('b')) result += Ch('\b');
-                else if (*b == Ch('f')) result += Ch('\f');
-                else if (*b == Ch('n')) result += Ch('\n');
-                else if (*b == Ch('r')) result += Ch('\r');
-                else if (*b == Ch('t')) result += Ch('\t');
-                else if (*b == Ch('v')) result += Ch('\v');
-                else if (*b == Ch('"')) result += Ch('"');
-                else if (*b == Ch('\'')) result += Ch('\'');
-                else if (*b == Ch('\\')) result += Ch('\\');
-                else
-                    BOOST_PROPERTY_TREE_THROW(info_parser_error(
-                        "unknown escape sequence", "", 0));
+                BOOST_PROPERTY_TREE_THROW(info_parser_error(
+                    "character expected after backslash", "", 0));
             }
+            else if (*b == Ch('0')) result += Ch('\0');
+            else if (*b == Ch('a')) result += Ch('\a');
+            else if (*b == Ch('b')) result += Ch('\b');
+            else if (*b == Ch('f')) result += Ch('\f');
+            else if (*b == Ch('n')) result += Ch('\n');
+            else if (*b == Ch('r')) result += Ch('\r');
+            else if (*b == Ch('t')) result += Ch('\t');
+            else if (*b == Ch('v')) result += Ch('\v');
+            else if (*b == Ch('"')) result += Ch('"');
+            else if (*b == Ch('\'')) result += Ch('\'');
+            else if (*b == Ch('\\')) result += Ch('\\');
             else
-                result += *b;
-            ++b;
+                BOOST_PROPERTY_TREE_THROW(info_parser_error(
+                    "unknown escape sequence", "", 0));
+            run = std::find(++b, e, Ch('\\'));
+            result.append(b, run);
+            b = run;
         }
         return result;
     }
     
-    // Detect whitespace in a not very smart way.
+    // Detect whitespace in a not very smart way: the ASCII characters that
+    // std::isspace accepts in the C locale.
     template <class Ch>
     bool is_ascii_space(Ch c)
     {
-        // Everything outside ASCII is not space.
-        unsigned n = c;
-        if (n > 127)
-            return false;
-        return std::isspace(c) != 0;
+        return c == Ch(' ') || (c >= Ch('\t') && c <= Ch('\r'));
     }
 
     // Advance pointer past whitespace
@@ -185,12 +192,25 @@ namespace boost { namespace property_tree { namespace info_parser
         }
     }
 
-    // Build ptree from info stream
+    template<class Ptree>
+    class info_include_cache;
+
     template<class Ptree, class Ch>
     void read_info_internal(std::basic_istream<Ch> &stream,
                             Ptree &pt,
                             const std::string &filename,
-                            int include_depth)
+                            int include_depth,
+                            info_include_cache<Ptree> *cache = 0);
+
+    // Build ptree from info text in [first, text_end), which must be followed
+    // by a null character. The lines are terminated in place.
+    template<class Ptree, class Ch>
+    void read_info_internal(Ch *first,
+                            Ch *text_end,
+                            Ptree &pt,
+                            const std::string &filename,
+                            int include_depth,
+                            info_include_cache<Ptree> *cache)
     {
         typedef std::basic_string<Ch> str_t;
         // Possible parser states
@@ -203,23 +223,21 @@ namespace boost { namespace property_tree { namespace info_parser
         unsigned long line_no = 0;
         state_t state = s_key;          // Parser state
         Ptree *last = NULL;             // Pointer to last created ptree
-        // Define line here to minimize reallocations
-        str_t line;
 
         // Initialize ptree stack (used to handle nesting)
         std::stack<Ptree *> stack;
         stack.push(&pt);                // Push root ptree on stack initially
 
         try {
-            // While there are characters in the stream
-            while (stream.good()) {
-                // Read one line from stream
+            // For all lines, the last one being the one after the last
+            // newline
+            for (Ch *next = first, *end = first; end != text_end; ) {
+                // Terminate the line where it ends
                 ++line_no;
-                std::getline(stream, line);
-                if (!stream.good() && !stream.eof())
-                    BOOST_PROPERTY_TREE_THROW(info_parser_error(
-                        "read error", filename, line_no));
-                const Ch *text = line.c_str();
+                end = std::find(next, text_end, Ch('\n'));
+                *end = Ch();
+                const Ch *text = next;
+                next = end + 1;
 
                 // If directive found
                 skip_whitespace(text);
@@ -238,13 +256,23 @@ namespace boost { namespace property_tree { namespace info_parser
                         str_t s = read_string(text, NULL);
                         std::string inc_name =
                             convert_chtype<char, Ch>(s.c_str());
-                        std::basic_ifstream<Ch> inc_stream(inc_name.c_str());
-                        if (!inc_stream.good())
-                            BOOST_PROPERTY_TREE_THROW(info_parser_error(
-                                "cannot open include file " + inc_name,
-                                filename, line_no));
-                        read_info_internal(inc_stream, *stack.top(),
-                                           inc_name, include_depth + 1);
+                        if (cache) {
+                            const Ptree &included =
+                                cache->load(inc_name, include_depth + 1);
+                            for (typename Ptree::const_iterator
+                                     it = included.begin();
+                                 it != included.end(); ++it)
+                                stack.top()->push_back(*it);
+                        } else {
+                            std::basic_ifstream<Ch> inc_stream(
+                                inc_name.c_str());
+                            if (!inc_stream.good())
+                                BOOST_PROPERTY_TREE_THROW(info_parser_error(
+                                    "cannot open include file " + inc_name,
+                                    filename, line_no));
+                            read_info_internal(inc_stream, *stack.top(),
+                                               inc_name, include_depth + 1);
+                        }
                     } else {   // Unknown directive
                         BOOST_PROPERTY_TREE_THROW(info_parser_error(
                             "unknown directive", filename, line_no));
@@ -386,6 +414,154 @@ namespace boost { namespace property_tree { namespace info_parser
 
     }
 
+    // Build ptree from info stream, which is read in large blocks and
+    // parsed in memory
+    template<class Ptree, class Ch>
+    void read_info_internal(std::basic_istream<Ch> &stream,
+                            Ptree &pt,
+                            const std::string &filename,
+                            int include_depth,
+                            info_include_cache<Ptree> *cache)
+    {
+        std::vector<Ch> text;
+        if (stream.good()) {
+            text.resize(property_tree::detail::read_stream(stream, text));
+            stream.setstate(std::ios_base::eofbit);
+            if (stream.bad())
+                BOOST_PROPERTY_TREE_THROW(info_parser_error(
+                    "read error", filename, 0));
+        }
+        text.push_back(Ch());
+        read_info_internal(&text.front(), &text.back(), pt, filename,
+                           include_depth, cache);
+    }
+
+    /**
+     * Keeps the trees of files read through @c \#include, so that a file
+     * that many documents include is parsed once. A file is read again
+     * when its modification time or size, or that of a file it includes,
+     * has changed. Pass the same cache to each read_info call.
+     * @note Modification times are compared to the nanosecond on POSIX
+     *       systems that record them so, but only to the second on Windows
+     *       and older systems. There, a file rewritten within the second
+     *       it was read, with the same size, is not noticed.
+     */
+    template<class Ptree>
+    class info_include_cache
+    {
+    public:
+        info_include_cache() {}
+
+        /** The number of files held. */
+        std::size_t size() const { return m_entries.size(); }
+
+        /** Forget all files. */
+        void clear() { m_entries.clear(); }
+
+        // The tree of the file, from the cache if it is up to date.
+        const Ptree &load(const std::string &filename, int include_depth)
+        {
+            if (!m_loading.empty())
+                m_loading.back()->push_back(filename);
+            typename entries::iterator it = m_entries.find(filename);
+            if (it != m_entries.end() && is_current(it))
+                return it->second.tree;
+
+            std::basic_ifstream<typename Ptree::key_type::value_type>
+                stream(filename.c_str());
+            if (!stream.good())
+                BOOST_PROPERTY_TREE_THROW(info_parser_error(
+                    "cannot open include file " + filename, "", 0));
+            entry e;
+            e.known = stamp(filename, e.stamp);
+            m_loading.push_back(&e.includes);
+            try {
+                read_info_internal(stream, e.tree, filename, include_depth,
+                                   this);
+            } catch (...) {
+                m_loading.pop_back();
+                throw;
+            }
+            m_loading.pop_back();
+            entry &stored = m_entries[filename];
+            stored.swap(e);
+            return stored.tree;
+        }
+
+    private:
+        struct file_stamp
+        {
+            boost::intmax_t mtime;
+            long mtime_nsec;
+            boost::uintmax_t size;
+            bool operator ==(const file_stamp &other) const {
+                return mtime == other.mtime &&
+                       mtime_nsec == other.mtime_nsec && size == other.size;
+            }
+        };
+
+        struct entry
+        {
+            entry() : known(false) {}
+            void swap(entry &other) {
+                tree.swap(other.tree);
+                includes.swap(other.includes);
+                std::swap(stamp, other.stamp);
+                std::swap(known, other.known);
+            }
+            Ptree tree;
+            std::vector<std::string> includes;
+            file_stamp stamp;
+            bool known;
+        };
+        typedef std::map<std::string, entry> entries;
+
+        info_include_cache(const info_include_cache &);
+        info_include_cache &operator =(const info_include_cache &);
+
+        static bool stamp(const std::string &filename, file_stamp &s)
+        {
+#if defined(BOOST_WINDOWS) && !defined(__CYGWIN__)
+            struct ::_stat64 st;
+            if (::_stat64(filename.c_str(), &st) != 0)
+                return false;
+            s.mtime_nsec = 0;
+#else
+            struct stat st;
+            if (::stat(filename.c_str(), &st) != 0)
+                return false;
+#if defined(__APPLE__)
+            s.mtime_nsec = static_cast<long>(st.st_mtimespec.tv_nsec);
+#elif defined(_POSIX_VERSION) && _POSIX_VERSION >= 200809L
+            s.mtime_nsec = static_cast<long>(st.st_mtim.tv_nsec);
+#else
+            s.mtime_nsec = 0;
+#endif
+#endif
+            s.mtime = static_cast<boost::intmax_t>(st.st_mtime);
+            s.size = static_cast<boost::uintmax_t>(st.st_size);
+            return true;
+        }
+
+        bool is_current(typename entries::iterator it)
+        {
+            file_stamp now;
+            if (!it->second.known || !stamp(it->first, now) ||
+                !(now == it->second.stamp))
+                return false;
+            const std::vector<std::string> &includes = it->second.includes;
+            for (std::size_t i = 0; i < includes.size(); ++i) {
+                typename entries::iterator inc = m_entries.find(includes[i]);
+                if (inc == m_entries.end() || !is_current(inc))
+                    return false;
+            }
+            return true;
+        }
+
+        entries m_entries;
+        std::vector<std::vector<std::string> *> m_loading;
+    };
+
 } } }
 
 #endif
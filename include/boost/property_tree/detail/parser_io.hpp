@@ -0,0 +1,170 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_DETAIL_PARSER_IO_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_DETAIL_PARSER_IO_HPP_INCLUDED
+
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+
+// Input and output helpers shared by the parsers.
+
+namespace boost { namespace property_tree { namespace detail
+{
+
+    // The data of a node as a string of type Str, without a copy where the
+    // tree stores such strings already.
+    template<class Ptree, class Str>
+    const Str &string_data(const Ptree &pt, Str &, boost::true_type)
+    {
+        return pt.data();
+    }
+
+    template<class Ptree, class Str>
+    const Str &string_data(const Ptree &pt, Str &temp, boost::false_type)
+    {
+        temp = pt.template get_value<Str>();
+        return temp;
+    }
+
+    template<class Ptree, class Str>
+    const Str &string_data(const Ptree &pt, Str &temp)
+    {
+        return string_data(pt, temp,
+            boost::is_same<typename Ptree::data_type, Str>());
+    }
+
+    // Collects output in a staging buffer and hands it to the stream buffer
+    // in large pieces, bypassing the formatted output functions. With a
+    // flush_at of 0, nothing is written before flush(), so that output can
+    // still be discarded if the tree turns out not to be representable.
+    template<class Ch>
+    class staged_output
+    {
+    public:
+        explicit staged_output(std::basic_ostream<Ch> &stream,
+                               std::size_t flush_at = 0)
+            : m_stream(stream), m_flush_at(flush_at)
+        {
+            if (m_flush_at)
+                m_buffer.reserve(m_flush_at);
+        }
+
+        void put(Ch c)
+        {
+            m_buffer += c;
+        }
+
+        template<class Str>
+        void put(const Str &s)
+        {
+            m_buffer.append(s.begin(), s.end());
+            flush_if_full();
+        }
+
+        template<class It>
+        void put(It first, It last)
+        {
+            m_buffer.append(first, last);
+            flush_if_full();
+        }
+
+        void put(std::size_t count, Ch c)
+        {
+            m_buffer.append(count, c);
+            flush_if_full();
+        }
+
+        // Characters of the basic character set, widened.
+        void put_literal(const char *s)
+        {
+            for (; *s; ++s)
+                m_buffer += Ch(*s);
+        }
+
+        // Whether nothing is staged.
+        bool empty() const
+        {
+            return m_buffer.empty();
+        }
+
+        void flush()
+        {
+            if (!m_buffer.empty() && m_stream.good())
+            {
+                std::basic_streambuf<Ch> *sb = m_stream.rdbuf();
+                std::streamsize n =
+                    static_cast<std::streamsize>(m_buffer.size());
+                if (!sb || sb->sputn(m_buffer.data(), n) != n)
+                    m_stream.setstate(std::ios_base::badbit);
+            }
+            discard();
+        }
+
+        void discard()
+        {
+            m_buffer.clear();
+        }
+
+    protected:
+        void flush_if_full()
+        {
+            if (m_flush_at && m_buffer.size() >= m_flush_at)
+                flush();
+        }
+
+    private:
+        staged_output(const staged_output &);
+        staged_output &operator =(const staged_output &);
+
+        std::basic_ostream<Ch> &m_stream;
+        std::size_t m_flush_at;
+        std::basic_string<Ch> m_buffer;
+    };
+
+    // Read everything that is left in the stream into buffer, a vector or
+    // string whose elements each hold a whole number of characters. The
+    // buffer keeps its capacity and grows geometrically, and may end up
+    // larger than what was read. Returns the number of characters read.
+    // The stream's state is left to the caller.
+    template<class Ch, class Traits, class Buffer>
+    std::size_t read_stream(std::basic_istream<Ch, Traits> &stream,
+                            Buffer &buffer)
+    {
+        typedef typename Buffer::value_type unit;
+        BOOST_STATIC_ASSERT(sizeof(unit) % sizeof(Ch) == 0);
+        const std::size_t per_unit = sizeof(unit) / sizeof(Ch);
+        std::size_t size = 0;
+        std::basic_streambuf<Ch, Traits> *sb = stream.rdbuf();
+        if (!sb)
+            return 0;
+        buffer.resize((std::max)(buffer.capacity(),
+            static_cast<std::size_t>(16 * 1024 / sizeof(unit))));
+        for (;;)
+        {
+            Ch *chars = reinterpret_cast<Ch *>(&buffer[0]);
+            std::streamsize n = sb->sgetn(chars + size,
+                static_cast<std::streamsize>(
+                    buffer.size() * per_unit - size));
+            if (n <= 0)
+                break;
+            size += static_cast<std::size_t>(n);
+            if (size == buffer.size() * per_unit)
+                buffer.resize(buffer.size() * 2);
+        }
+        return size;
+    }
+
+} } }
+
+#endif
@@ -15,7 +15,16 @@
 #include <boost/iterator/reverse_iterator.hpp>
 #include <boost/assert.hpp>
 #include <boost/utility/swap.hpp>
+#include <boost/core/allocator_access.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/functional/hash.hpp>
+#include <algorithm>
 #include <memory>
+#include <new>
+#include <vector>
+#if !defined(BOOST_NO_CXX11_HDR_TYPE_TRAITS)
+#include <type_traits>
+#endif
 
 #if (defined(BOOST_MSVC) && \
      (_MSC_FULL_VER >= 160000000 && _MSC_FULL_VER < 170000000)) || \
@@ -26,8 +35,243 @@
 
 namespace boost { namespace property_tree
 {
-    template <class K, class D, class C>
-    struct basic_ptree<K, D, C>::subs
+    namespace impl
+    {
+        // Uses-allocator copy of node data, so that allocator-aware data
+        // (e.g. a std::pmr::string) lives in the same memory as the tree.
+#if !defined(BOOST_NO_CXX11_ALLOCATOR) && \
+    !defined(BOOST_NO_CXX11_HDR_TYPE_TRAITS) && \
+    !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+        template <typename T, typename Alloc>
+        T with_allocator(const T &t, const Alloc &a, std::true_type) {
+            return T(t, a);
+        }
+        template <typename T, typename Alloc>
+        T with_allocator(const T &t, const Alloc &, std::false_type) {
+            return t;
+        }
+        template <typename T, typename Alloc>
+        T with_allocator(const T &t, const Alloc &a) {
+            return with_allocator(t, a, std::integral_constant<bool,
+                std::uses_allocator<T, Alloc>::value &&
+                std::is_constructible<T, const T&, const Alloc&>::value>());
+        }
+#else
+        template <typename T, typename Alloc>
+        const T &with_allocator(const T &t, const Alloc &) {
+            return t;
+        }
+#endif
+
+        // Allocators are exchanged only if they say so; otherwise, like for
+        // the standard containers, swapped trees must have equal allocators.
+        template <typename Alloc>
+        void swap_allocators(Alloc &a1, Alloc &a2, boost::true_type) {
+            boost::swap(a1, a2);
+        }
+        template <typename Alloc>
+        void swap_allocators(Alloc &, Alloc &, boost::false_type) {}
+        template <typename Alloc>
+        void swap_allocators(Alloc &a1, Alloc &a2) {
+            swap_allocators(a1, a2, boost::integral_constant<bool,
+                boost::allocator_propagate_on_container_swap<Alloc>::type::
+                    value>());
+        }
+
+        // The by-name index of the child container: ordered by the key
+        // comparison, or hashed if the tree uses a hashed_key policy.
+        template <typename Tag, typename KeyFromValue, typename C>
+        struct by_name_index_spec
+        {
+            typedef multi_index::ordered_non_unique<Tag, KeyFromValue, C>
+                type;
+        };
+        template <typename Tag, typename KeyFromValue,
+                  typename K, typename H, typename P>
+        struct by_name_index_spec<Tag, KeyFromValue, hashed_key<K, H, P> >
+        {
+            typedef multi_index::hashed_non_unique<Tag, KeyFromValue, H, P>
+                type;
+        };
+
+        // A path fragment, compared in place against the keys of a node.
+        template <typename Ch>
+        struct fragment
+        {
+            fragment(const Ch *f, const Ch *l) : first(f), last(l) {}
+            const Ch *first;
+            const Ch *last;
+        };
+
+        template <typename Ch, typename Traits>
+        struct fragment_less
+        {
+            template <typename Str>
+            bool operator ()(const Str &k, const fragment<Ch> &f) const {
+                return compare(k, f) < 0;
+            }
+            template <typename Str>
+            bool operator ()(const fragment<Ch> &f, const Str &k) const {
+                return compare(k, f) > 0;
+            }
+            template <typename Str>
+            static int compare(const Str &k, const fragment<Ch> &f) {
+                std::size_t kn = k.size(),
+                            fn = static_cast<std::size_t>(f.last - f.first);
+                int r = Traits::compare(k.data(), f.first,
+                                        kn < fn ? kn : fn);
+                return r != 0 ? r : kn < fn ? -1 : kn > fn ? 1 : 0;
+            }
+        };
+
+        template <typename C, typename Ch>
+        struct fragment_less_nocase
+        {
+            explicit fragment_less_nocase(const C &c) : c(c) {}
+            template <typename Str>
+            bool operator ()(const Str &k, const fragment<Ch> &f) const {
+                return std::lexicographical_compare(k.begin(), k.end(),
+                                                    f.first, f.last, c);
+            }
+            template <typename Str>
+            bool operator ()(const fragment<Ch> &f, const Str &k) const {
+                return std::lexicographical_compare(f.first, f.last,
+                                                    k.begin(), k.end(), c);
+            }
+            C c;
+        };
+
+        template <typename Ch>
+        struct fragment_hash
+        {
+            std::size_t operator ()(const fragment<Ch> &f) const {
+                return boost::hash_range(f.first, f.last);
+            }
+        };
+
+        template <typename Ch, typename Traits>
+        struct fragment_equal
+        {
+            template <typename Str>
+            bool operator ()(const fragment<Ch> &f, const Str &k) const {
+                return k.size() == static_cast<std::size_t>(f.last - f.first)
+                    && Traits::compare(k.data(), f.first, k.size()) == 0;
+            }
+            template <typename Str>
+            bool operator ()(const Str &k, const fragment<Ch> &f) const {
+                return (*this)(f, k);
+            }
+        };
+
+        // Finding a child by a path fragment. The key comparisons that come
+        // with the library can compare a fragment of a string path in
+        // place; other keys are created by reducing the path.
+        template <typename Path, typename C>
+        struct fragment_lookup
+        {
+            template <typename Index>
+            static typename Index::iterator find(const Index &i, Path &p) {
+                return i.find(p.reduce());
+            }
+        };
+
+        template <typename Ch, typename Traits, typename Alloc>
+        struct fragment_lookup<
+            string_path<std::basic_string<Ch, Traits, Alloc>,
+                        id_translator<std::basic_string<Ch, Traits, Alloc> > >,
+            std::less<std::basic_string<Ch, Traits, Alloc> > >
+        {
+            template <typename Index, typename Path>
+            static typename Index::iterator find(const Index &i, Path &p) {
+                std::pair<const Ch *, const Ch *> r = p.reduce_range();
+                return i.find(fragment<Ch>(r.first, r.second),
+                              fragment_less<Ch, Traits>());
+            }
+        };
+
+        template <typename Ch, typename Traits, typename Alloc>
+        struct fragment_lookup<
+            string_path<std::basic_string<Ch, Traits, Alloc>,
+                        id_translator<std::basic_string<Ch, Traits, Alloc> > >,
+            detail::less_nocase<std::basic_string<Ch, Traits, Alloc> > >
+        {
+            template <typename Index, typename Path>
+            static typename Index::iterator find(const Index &i, Path &p) {
+                typedef detail::less_nocase<std::basic_string<Ch, Traits,
+                                                              Alloc> > C;
+                std::pair<const Ch *, const Ch *> r = p.reduce_range();
+                return i.find(fragment<Ch>(r.first, r.second),
+                              fragment_less_nocase<C, Ch>(i.key_comp()));
+            }
+        };
+
+        template <typename Ch, typename Traits, typename Alloc>
+        struct fragment_lookup<
+            string_path<std::basic_string<Ch, Traits, Alloc>,
+                        id_translator<std::basic_string<Ch, Traits, Alloc> > >,
+            hashed_key<std::basic_string<Ch, Traits, Alloc>,
+                       boost::hash<std::basic_string<Ch, Traits, Alloc> >,
+                       std::equal_to<std::basic_string<Ch, Traits, Alloc> > > >
+        {
+            template <typename Index, typename Path>
+            static typename Index::iterator find(const Index &i, Path &p) {
+                std::pair<const Ch *, const Ch *> r = p.reduce_range();
+                return i.find(fragment<Ch>(r.first, r.second),
+                              fragment_hash<Ch>(),
+                              fragment_equal<Ch, Traits>());
+            }
+        };
+
+        // The memory layout of a child container. Normally, the container
+        // is allocated on its own.
+        template <typename Alloc, typename Value>
+        struct child_storage
+        {
+            typedef typename boost::allocator_rebind<Alloc, Value>::type
+                value_allocator;
+
+            template <typename Container>
+            struct block
+            {
+                explicit block(const Alloc &a)
+                    : children(typename Container::ctor_args_list(),
+                               value_allocator(a))
+                {}
+                block(const Container &c, const Alloc &a)
+                    : children(c, value_allocator(a))
+                {}
+                Container children;
+            };
+        };
+
+        // With inline_children, the block starts with the slots that the
+        // container's first nodes are placed in.
+        template <std::size_t N, typename Alloc, typename Value>
+        struct child_storage<inline_children<N, Alloc>, Value>
+        {
+            typedef detail::inline_slots<N, Value> slots_type;
+            typedef detail::inline_slot_allocator<Value,
+                typename boost::allocator_rebind<Alloc, Value>::type,
+                slots_type> value_allocator;
+
+            template <typename Container>
+            struct block
+            {
+                explicit block(const inline_children<N, Alloc> &a)
+                    : children(typename Container::ctor_args_list(),
+                               value_allocator(a.base(), &slots))
+                {}
+                block(const Container &c, const inline_children<N, Alloc> &a)
+                    : children(c, value_allocator(a.base(), &slots))
+                {}
+                slots_type slots;
+                Container children;
+            };
+        };
+    }
+
+    template <class K, class D, class C, class A>
+    struct basic_ptree<K, D, C, A>::subs
     {
         struct by_name {};
         // The actual child container.
@@ -37,32 +281,108 @@ namespace boost { namespace property_tree
         BOOST_STATIC_CONSTANT(unsigned,
             first_offset = offsetof(value_type, first));
 #endif
-        typedef multi_index_container<value_type,
-            multi_index::indexed_by<
-                multi_index::sequenced<>,
-                multi_index::ordered_non_unique<multi_index::tag<by_name>,
+        typedef impl::child_storage<allocator_type, value_type> storage;
+        typedef typename storage::value_allocator value_allocator;
+        typedef typename impl::by_name_index_spec<multi_index::tag<by_name>,
 #if defined(BOOST_PROPERTY_TREE_PAIR_BUG)
-                    multi_index::member_offset<value_type, const key_type,
-                                        first_offset>,
+            multi_index::member_offset<value_type, const key_type,
+                                first_offset>,
 #else
-                    multi_index::member<value_type, const key_type,
-                                        &value_type::first>,
+            multi_index::member<value_type, const key_type,
+                                &value_type::first>,
 #endif
-                    key_compare
-                >
-            >
+            key_compare
+        >::type by_name_spec;
+        typedef multi_index_container<value_type,
+            multi_index::indexed_by<
+                multi_index::sequenced<>,
+                by_name_spec
+            >,
+            value_allocator
         > base_container;
+        typedef typename storage::BOOST_NESTED_TEMPLATE
+            block<base_container> block;
+        typedef typename boost::allocator_rebind<allocator_type,
+            block>::type block_allocator;
 
         // The by-name lookup index.
         typedef typename base_container::template index<by_name>::type
             by_name_index;
 
         // Access functions for getting to the children of a tree.
+        // A node that never had children has no container at all. Access
+        // to it is served from a shared, permanently empty container, so
+        // that walking over leaves never allocates and all their iterators
+        // compare equal. Only inserting members create the container.
         static base_container& ch(self_type *s) {
-            return *static_cast<base_container*>(s->m_children);
+            if (!s->m_children.first()) {
+                return empty();
+            }
+            return static_cast<block*>(s->m_children.first())->children;
         }
         static const base_container& ch(const self_type *s) {
-            return *static_cast<const base_container*>(s->m_children);
+            if (!s->m_children.first()) {
+                return empty();
+            }
+            return static_cast<const block*>(
+                s->m_children.first())->children;
+        }
+        // The container to insert into, created if the node has none.
+        static base_container& grow(self_type *s) {
+            if (!s->m_children.first()) {
+                s->m_children.first() = create(s->m_children.second());
+            }
+            return static_cast<block*>(s->m_children.first())->children;
+        }
+        // The position in grow(s) of where, an iterator of s. Before the
+        // container exists, where can only be the shared end iterator.
+        static typename base_container::iterator grow_at(self_type *s,
+                                                         iterator where) {
+            if (!s->m_children.first()) {
+                return grow(s).end();
+            }
+            return where.base();
+        }
+        // Never modified: the only iterators into it are end iterators.
+        static base_container& empty() {
+            static base_container e;
+            return e;
+        }
+
+        // Creation and destruction of the container, through the allocator.
+        static block* create(const allocator_type &a) {
+            block_allocator ba(a);
+            block *p = boost::allocator_allocate(ba, 1);
+            try {
+                ::new (static_cast<void*>(p)) block(a);
+            } catch (...) {
+                boost::allocator_deallocate(ba, p, 1);
+                throw;
+            }
+            return p;
+        }
+        static block* copy(const self_type *s, const allocator_type &a) {
+            if (!s->m_children.first() || ch(s).empty()) {
+                return 0;
+            }
+            block_allocator ba(a);
+            block *p = boost::allocator_allocate(ba, 1);
+            try {
+                ::new (static_cast<void*>(p)) block(ch(s), a);
+            } catch (...) {
+                boost::allocator_deallocate(ba, p, 1);
+                throw;
+            }
+            return p;
+        }
+        static void destroy(self_type *s) {
+            block *p = static_cast<block*>(s->m_children.first());
+            if (p) {
+                block_allocator ba(s->m_children.second());
+                p->~block();
+                boost::allocator_deallocate(ba, p, 1);
+                s->m_children.first() = 0;
+            }
         }
         static by_name_index& assoc(self_type *s) {
             return ch(s).BOOST_NESTED_TEMPLATE get<by_name>();
@@ -70,9 +390,73 @@ namespace boost { namespace property_tree
         static const by_name_index& assoc(const self_type *s) {
             return ch(s).BOOST_NESTED_TEMPLATE get<by_name>();
         }
+        // Find the child with the given key, or create it.
+        static self_type& force_child(self_type *s, const key_type &key) {
+            assoc_iterator el = s->find(key);
+            if (el != s->not_found()) {
+                return el->second;
+            }
+            return s->push_back(value_type(key, self_type()))->second;
+        }
+        // Walk down along the keys in [first, last). Not const-safe!
+        template <class It>
+        static self_type* walk_keys(const self_type *s, It first, It last) {
+            for (; first != last; ++first) {
+                const by_name_index &idx = assoc(s);
+                typename by_name_index::const_iterator el = idx.find(*first);
+                if (el == idx.end()) {
+                    return 0;
+                }
+                s = &el->second;
+            }
+            return const_cast<self_type*>(s);
+        }
+        // Walk down along the keys in [first, last), creating missing nodes.
+        template <class It>
+        static self_type& force_keys(self_type *s, It first, It last) {
+            for (; first != last; ++first) {
+                s = &force_child(s, *first);
+            }
+            return *s;
+        }
+        // Walk down along the keys of path, starting from the deepest node
+        // it shares with prev. On entry, nodes holds the root and the nodes
+        // found along prev; on exit, those found along path. Not const-safe!
+        static self_type* walk_shared(std::vector<self_type*> &nodes,
+                                      const compiled_path_type *prev,
+                                      const compiled_path_type &path) {
+            typename compiled_path_type::const_iterator it = path.begin();
+            std::size_t depth = 0;
+            if (prev) {
+                typename compiled_path_type::const_iterator pit =
+                    prev->begin();
+                while (depth + 1 < nodes.size() && it != path.end() &&
+                       *pit == *it) {
+                    ++pit;
+                    ++it;
+                    ++depth;
+                }
+            }
+            nodes.resize(depth + 1);
+            for (; it != path.end(); ++it) {
+                self_type *n = walk_keys(nodes.back(), it, it + 1);
+                if (!n) {
+                    return 0;
+                }
+                nodes.push_back(n);
+            }
+            return nodes.back();
+        }
+        // Take the first fragment off the path and find a child by it.
+        static self_type* find_fragment(const self_type *s, path_type &p) {
+            const by_name_index &idx = assoc(s);
+            typename by_name_index::iterator el =
+                impl::fragment_lookup<path_type, key_compare>::find(idx, p);
+            return el == idx.end() ? 0 : const_cast<self_type*>(&el->second);
+        }
     };
-    template <class K, class D, class C>
-    class basic_ptree<K, D, C>::iterator : public boost::iterator_adaptor<
+    template <class K, class D, class C, class A>
+    class basic_ptree<K, D, C, A>::iterator : public boost::iterator_adaptor<
         iterator, typename subs::base_container::iterator, value_type>
     {
         friend class boost::iterator_core_access;
@@ -94,9 +478,10 @@ namespace boost { namespace property_tree
             return const_cast<reference>(*this->base_reference());
         }
     };
-    template <class K, class D, class C>
-    class basic_ptree<K, D, C>::const_iterator : public boost::iterator_adaptor<
-        const_iterator, typename subs::base_container::const_iterator>
+    template <class K, class D, class C, class A>
+    class basic_ptree<K, D, C, A>::const_iterator
+        : public boost::iterator_adaptor<
+            const_iterator, typename subs::base_container::const_iterator>
     {
     public:
         const_iterator() {}
@@ -107,8 +492,8 @@ namespace boost { namespace property_tree
             : const_iterator::iterator_adaptor_(b.base())
         {}
     };
-    template <class K, class D, class C>
-    class basic_ptree<K, D, C>::reverse_iterator
+    template <class K, class D, class C, class A>
+    class basic_ptree<K, D, C, A>::reverse_iterator
         : public boost::reverse_iterator<iterator>
     {
     public:
@@ -117,8 +502,8 @@ namespace boost { namespace property_tree
             : boost::reverse_iterator<iterator>(b)
         {}
     };
-    template <class K, class D, class C>
-    class basic_ptree<K, D, C>::const_reverse_iterator
+    template <class K, class D, class C, class A>
+    class basic_ptree<K, D, C, A>::const_reverse_iterator
         : public boost::reverse_iterator<const_iterator>
     {
     public:
@@ -127,12 +512,12 @@ namespace boost { namespace property_tree
             : boost::reverse_iterator<const_iterator>(b)
         {}
         const_reverse_iterator(
-            typename basic_ptree<K, D, C>::reverse_iterator b)
+            typename basic_ptree<K, D, C, A>::reverse_iterator b)
             : boost::reverse_iterator<const_iterator>(b)
         {}
     };
-    template <class K, class D, class C>
-    class basic_ptree<K, D, C>::assoc_iterator
+    template <class K, class D, class C, class A>
+    class basic_ptree<K, D, C, A>::assoc_iterator
         : public boost::iterator_adaptor<assoc_iterator,
                                          typename subs::by_name_index::iterator,
                                          value_type>
@@ -153,8 +538,8 @@ namespace boost { namespace property_tree
             return const_cast<reference>(*this->base_reference());
         }
     };
-    template <class K, class D, class C>
-    class basic_ptree<K, D, C>::const_assoc_iterator
+    template <class K, class D, class C, class A>
+    class basic_ptree<K, D, C, A>::const_assoc_iterator
         : public boost::iterator_adaptor<const_assoc_iterator,
                                    typename subs::by_name_index::const_iterator>
     {
@@ -172,214 +557,346 @@ namespace boost { namespace property_tree
 
     // Big five
 
-    // Perhaps the children collection could be created on-demand only, to
-    // reduce heap traffic. But that's a lot more work to implement.
+    // The children collection is created on demand only, to reduce heap
+    // traffic. Most nodes in a typical tree are leaves.
+
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A>::basic_ptree()
+        : m_children(0)
+    {
+    }
+
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A>::basic_ptree(const allocator_type &a)
+        : m_data(impl::with_allocator(data_type(), a)), m_children(0, a)
+    {
+    }
 
-    template<class K, class D, class C> inline
-    basic_ptree<K, D, C>::basic_ptree()
-        : m_children(new typename subs::base_container)
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A>::basic_ptree(const data_type &d)
+        : m_data(d), m_children(0)
     {
     }
 
-    template<class K, class D, class C> inline
-    basic_ptree<K, D, C>::basic_ptree(const data_type &d)
-        : m_data(d), m_children(new typename subs::base_container)
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A>::basic_ptree(const data_type &d,
+                                         const allocator_type &a)
+        : m_data(impl::with_allocator(d, a)), m_children(0, a)
     {
     }
 
-    template<class K, class D, class C> inline
-    basic_ptree<K, D, C>::basic_ptree(const basic_ptree<K, D, C> &rhs)
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A>::basic_ptree(const basic_ptree<K, D, C, A> &rhs)
         : m_data(rhs.m_data),
-          m_children(new typename subs::base_container(subs::ch(&rhs)))
+          m_children(0, boost::allocator_select_on_container_copy_construction(
+                            rhs.m_children.second()))
     {
+        m_children.first() = subs::copy(&rhs, m_children.second());
     }
 
-    template<class K, class D, class C>
-    basic_ptree<K, D, C> &
-        basic_ptree<K, D, C>::operator =(const basic_ptree<K, D, C> &rhs)
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A>::basic_ptree(const basic_ptree<K, D, C, A> &rhs,
+                                         const allocator_type &a)
+        : m_data(impl::with_allocator(rhs.m_data, a)),
+          m_children(subs::copy(&rhs, a), a)
     {
-        self_type(rhs).swap(*this);
+    }
+
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::operator =(const basic_ptree<K, D, C, A> &rhs)
+    {
+        // The target keeps its allocator, like a standard container whose
+        // allocator doesn't propagate on copy assignment.
+        self_type(rhs, get_allocator()).swap(*this);
         return *this;
     }
 
-    template<class K, class D, class C>
-    basic_ptree<K, D, C>::~basic_ptree()
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A>::basic_ptree(basic_ptree<K, D, C, A> &&rhs)
+        BOOST_NOEXCEPT_IF(
+            boost::is_nothrow_move_constructible<data_type>::value &&
+            boost::is_nothrow_move_constructible<allocator_type>::value)
+        : m_data(std::move(rhs.m_data)),
+          m_children(rhs.m_children.first(), rhs.m_children.second())
     {
-        delete &subs::ch(this);
+        rhs.m_children.first() = 0;
     }
 
-    template<class K, class D, class C> inline
-    void basic_ptree<K, D, C>::swap(basic_ptree<K, D, C> &rhs)
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A>::basic_ptree(basic_ptree<K, D, C, A> &&rhs,
+                                         const allocator_type &a)
+        : m_data(a == rhs.m_children.second() ?
+                     data_type(std::move(rhs.m_data)) :
+                     impl::with_allocator(rhs.m_data, a)),
+          m_children(0, a)
+    {
+        // Children can only be taken over if they were allocated by an
+        // equal allocator.
+        if (a == rhs.m_children.second()) {
+            m_children.first() = rhs.m_children.first();
+            rhs.m_children.first() = 0;
+        } else {
+            m_children.first() = subs::copy(&rhs, a);
+        }
+    }
+
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::operator =(basic_ptree<K, D, C, A> &&rhs)
+        BOOST_NOEXCEPT_IF(
+            boost::is_nothrow_move_constructible<data_type>::value &&
+            boost::is_nothrow_move_constructible<allocator_type>::value &&
+            boost::allocator_is_always_equal<allocator_type>::type::value)
+    {
+        // Go through a temporary, as rhs may be one of our descendants.
+        if (get_allocator() == rhs.get_allocator()) {
+            self_type(std::move(rhs)).swap(*this);
+        } else {
+            *this = static_cast<const self_type &>(rhs);
+        }
+        return *this;
+    }
+#endif
+
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A>::~basic_ptree()
+    {
+        subs::destroy(this);
+    }
+
+    template<class K, class D, class C, class A> inline
+    void basic_ptree<K, D, C, A>::swap(basic_ptree<K, D, C, A> &rhs)
     {
         boost::swap(m_data, rhs.m_data);
         // Void pointers, no ADL necessary
-        std::swap(m_children, rhs.m_children);
+        std::swap(m_children.first(), rhs.m_children.first());
+        impl::swap_allocators(m_children.second(), rhs.m_children.second());
+    }
+
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::allocator_type
+        basic_ptree<K, D, C, A>::get_allocator() const
+    {
+        return m_children.second();
     }
 
     // Container view
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::size_type
-        basic_ptree<K, D, C>::size() const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::size_type
+        basic_ptree<K, D, C, A>::size() const
     {
         return subs::ch(this).size();
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::size_type
-        basic_ptree<K, D, C>::max_size() const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::size_type
+        basic_ptree<K, D, C, A>::max_size() const
     {
         return subs::ch(this).max_size();
     }
 
-    template<class K, class D, class C> inline
-    bool basic_ptree<K, D, C>::empty() const
+    template<class K, class D, class C, class A> inline
+    bool basic_ptree<K, D, C, A>::empty() const
     {
         return subs::ch(this).empty();
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::iterator
-        basic_ptree<K, D, C>::begin()
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::begin()
     {
         return iterator(subs::ch(this).begin());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::const_iterator
-        basic_ptree<K, D, C>::begin() const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::const_iterator
+        basic_ptree<K, D, C, A>::begin() const
     {
         return const_iterator(subs::ch(this).begin());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::iterator
-        basic_ptree<K, D, C>::end()
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::end()
     {
         return iterator(subs::ch(this).end());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::const_iterator
-        basic_ptree<K, D, C>::end() const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::const_iterator
+        basic_ptree<K, D, C, A>::end() const
     {
         return const_iterator(subs::ch(this).end());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::reverse_iterator
-        basic_ptree<K, D, C>::rbegin()
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::reverse_iterator
+        basic_ptree<K, D, C, A>::rbegin()
     {
         return reverse_iterator(this->end());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::const_reverse_iterator
-        basic_ptree<K, D, C>::rbegin() const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::const_reverse_iterator
+        basic_ptree<K, D, C, A>::rbegin() const
     {
         return const_reverse_iterator(this->end());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::reverse_iterator
-        basic_ptree<K, D, C>::rend()
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::reverse_iterator
+        basic_ptree<K, D, C, A>::rend()
     {
         return reverse_iterator(this->begin());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::const_reverse_iterator
-        basic_ptree<K, D, C>::rend() const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::const_reverse_iterator
+        basic_ptree<K, D, C, A>::rend() const
     {
         return const_reverse_iterator(this->begin());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::value_type &
-        basic_ptree<K, D, C>::front()
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::value_type &
+        basic_ptree<K, D, C, A>::front()
     {
         return const_cast<value_type&>(subs::ch(this).front());
     }
 
-    template<class K, class D, class C> inline
-    const typename basic_ptree<K, D, C>::value_type &
-        basic_ptree<K, D, C>::front() const
+    template<class K, class D, class C, class A> inline
+    const typename basic_ptree<K, D, C, A>::value_type &
+        basic_ptree<K, D, C, A>::front() const
     {
         return subs::ch(this).front();
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::value_type &
-        basic_ptree<K, D, C>::back()
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::value_type &
+        basic_ptree<K, D, C, A>::back()
     {
         return const_cast<value_type&>(subs::ch(this).back());
     }
 
-    template<class K, class D, class C> inline
-    const typename basic_ptree<K, D, C>::value_type &
-        basic_ptree<K, D, C>::back() const
+    template<class K, class D, class C, class A> inline
+    const typename basic_ptree<K, D, C, A>::value_type &
+        basic_ptree<K, D, C, A>::back() const
     {
         return subs::ch(this).back();
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::iterator
-    basic_ptree<K, D, C>::insert(iterator where, const value_type &value)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+    basic_ptree<K, D, C, A>::insert(iterator where, const value_type &value)
     {
-        return iterator(subs::ch(this).insert(where.base(), value).first);
+        typename subs::base_container::iterator at =
+            subs::grow_at(this, where);
+        return iterator(subs::ch(this).insert(at, value).first);
     }
 
-    template<class K, class D, class C>
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+    basic_ptree<K, D, C, A>::insert(iterator where, value_type &&value)
+    {
+        typename subs::base_container::iterator at =
+            subs::grow_at(this, where);
+        return iterator(subs::ch(this).insert(at, std::move(value)).first);
+    }
+#endif
+
+    template<class K, class D, class C, class A>
     template<class It> inline
-    void basic_ptree<K, D, C>::insert(iterator where, It first, It last)
+    void basic_ptree<K, D, C, A>::insert(iterator where, It first, It last)
     {
-        subs::ch(this).insert(where.base(), first, last);
+        if (first == last) {
+            return;
+        }
+        typename subs::base_container::iterator at =
+            subs::grow_at(this, where);
+        subs::ch(this).insert(at, first, last);
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::iterator
-        basic_ptree<K, D, C>::erase(iterator where)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::erase(iterator where)
     {
         return iterator(subs::ch(this).erase(where.base()));
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::iterator
-        basic_ptree<K, D, C>::erase(iterator first, iterator last)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::erase(iterator first, iterator last)
     {
         return iterator(subs::ch(this).erase(first.base(), last.base()));
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::iterator
-        basic_ptree<K, D, C>::push_front(const value_type &value)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::push_front(const value_type &value)
+    {
+        return iterator(subs::grow(this).push_front(value).first);
+    }
+
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::push_back(const value_type &value)
+    {
+        return iterator(subs::grow(this).push_back(value).first);
+    }
+
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::push_front(value_type &&value)
     {
-        return iterator(subs::ch(this).push_front(value).first);
+        return iterator(subs::grow(this).push_front(std::move(value)).first);
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::iterator
-        basic_ptree<K, D, C>::push_back(const value_type &value)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::push_back(value_type &&value)
+    {
+        return iterator(subs::grow(this).push_back(std::move(value)).first);
+    }
+#endif
+
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && \
+    !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) && \
+    !defined(BOOST_NO_CXX11_HDR_TUPLE)
+    template<class K, class D, class C, class A>
+    template<class... Args> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::emplace_back(const key_type &key,
+                                              Args&&... args)
     {
-        return iterator(subs::ch(this).push_back(value).first);
+        return iterator(subs::grow(this).emplace_back(std::piecewise_construct,
+            std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...)).first);
     }
+#endif
 
-    template<class K, class D, class C> inline
-    void basic_ptree<K, D, C>::pop_front()
+    template<class K, class D, class C, class A> inline
+    void basic_ptree<K, D, C, A>::pop_front()
     {
         subs::ch(this).pop_front();
     }
 
-    template<class K, class D, class C> inline
-    void basic_ptree<K, D, C>::pop_back()
+    template<class K, class D, class C, class A> inline
+    void basic_ptree<K, D, C, A>::pop_back()
     {
         subs::ch(this).pop_back();
     }
 
-    template<class K, class D, class C> inline
-    void basic_ptree<K, D, C>::reverse()
+    template<class K, class D, class C, class A> inline
+    void basic_ptree<K, D, C, A>::reverse()
     {
-        subs::ch(this).reverse();
+        if (m_children.first()) {
+            subs::ch(this).reverse();
+        }
     }
 
     namespace impl
@@ -392,14 +909,31 @@ namespace boost { namespace property_tree
             }
         };
 
+        template <typename C>
+        struct key_equivalent
+        {
+            template <typename K>
+            bool operator ()(const K& lhs, const K& rhs) const {
+                C c;
+                return !c(lhs, rhs) && !c(rhs, lhs);
+            }
+        };
+        template <typename K, typename H, typename P>
+        struct key_equivalent<hashed_key<K, H, P> >
+        {
+            template <typename Key>
+            bool operator ()(const Key& lhs, const Key& rhs) const {
+                P p;
+                return p(lhs, rhs);
+            }
+        };
+
         template <typename C>
         struct equal_pred
         {
             template <typename P>
             bool operator ()(const P& lhs, const P& rhs) const {
-                C c;
-                return !c(lhs.first, rhs.first) &&
-                       !c(rhs.first, lhs.first) &&
+                return key_equivalent<C>()(lhs.first, rhs.first) &&
                        lhs.second == rhs.second;
             }
         };
@@ -412,86 +946,88 @@ namespace boost { namespace property_tree
         }
     }
 
-    template<class K, class D, class C> inline
-    void basic_ptree<K, D, C>::sort()
+    template<class K, class D, class C, class A> inline
+    void basic_ptree<K, D, C, A>::sort()
     {
         sort(impl::by_first());
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Compare> inline
-    void basic_ptree<K, D, C>::sort(Compare comp)
+    void basic_ptree<K, D, C, A>::sort(Compare comp)
     {
-        subs::ch(this).sort(comp);
+        if (m_children.first()) {
+            subs::ch(this).sort(comp);
+        }
     }
 
     // Equality
 
-    template<class K, class D, class C> inline
-    bool basic_ptree<K, D, C>::operator ==(
-                                  const basic_ptree<K, D, C> &rhs) const
+    template<class K, class D, class C, class A> inline
+    bool basic_ptree<K, D, C, A>::operator ==(
+                                  const basic_ptree<K, D, C, A> &rhs) const
     {
         // The size test is cheap, so add it as an optimization
         return size() == rhs.size() && data() == rhs.data() &&
             impl::equal_children<C>(subs::ch(this), subs::ch(&rhs));
     }
 
-    template<class K, class D, class C> inline
-    bool basic_ptree<K, D, C>::operator !=(
-                                  const basic_ptree<K, D, C> &rhs) const
+    template<class K, class D, class C, class A> inline
+    bool basic_ptree<K, D, C, A>::operator !=(
+                                  const basic_ptree<K, D, C, A> &rhs) const
     {
         return !(*this == rhs);
     }
 
     // Associative view
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::assoc_iterator
-        basic_ptree<K, D, C>::ordered_begin()
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::assoc_iterator
+        basic_ptree<K, D, C, A>::ordered_begin()
     {
         return assoc_iterator(subs::assoc(this).begin());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::const_assoc_iterator
-        basic_ptree<K, D, C>::ordered_begin() const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::const_assoc_iterator
+        basic_ptree<K, D, C, A>::ordered_begin() const
     {
         return const_assoc_iterator(subs::assoc(this).begin());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::assoc_iterator
-        basic_ptree<K, D, C>::not_found()
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::assoc_iterator
+        basic_ptree<K, D, C, A>::not_found()
     {
         return assoc_iterator(subs::assoc(this).end());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::const_assoc_iterator
-        basic_ptree<K, D, C>::not_found() const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::const_assoc_iterator
+        basic_ptree<K, D, C, A>::not_found() const
     {
         return const_assoc_iterator(subs::assoc(this).end());
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::assoc_iterator
-        basic_ptree<K, D, C>::find(const key_type &key)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::assoc_iterator
+        basic_ptree<K, D, C, A>::find(const key_type &key)
     {
         return assoc_iterator(subs::assoc(this).find(key));
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::const_assoc_iterator
-        basic_ptree<K, D, C>::find(const key_type &key) const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::const_assoc_iterator
+        basic_ptree<K, D, C, A>::find(const key_type &key) const
     {
         return const_assoc_iterator(subs::assoc(this).find(key));
     }
 
-    template<class K, class D, class C> inline
+    template<class K, class D, class C, class A> inline
     std::pair<
-        typename basic_ptree<K, D, C>::assoc_iterator,
-        typename basic_ptree<K, D, C>::assoc_iterator
-    > basic_ptree<K, D, C>::equal_range(const key_type &key)
+        typename basic_ptree<K, D, C, A>::assoc_iterator,
+        typename basic_ptree<K, D, C, A>::assoc_iterator
+    > basic_ptree<K, D, C, A>::equal_range(const key_type &key)
     {
         std::pair<typename subs::by_name_index::iterator,
                   typename subs::by_name_index::iterator> r(
@@ -500,11 +1036,11 @@ namespace boost { namespace property_tree
           assoc_iterator(r.first), assoc_iterator(r.second));
     }
 
-    template<class K, class D, class C> inline
+    template<class K, class D, class C, class A> inline
     std::pair<
-        typename basic_ptree<K, D, C>::const_assoc_iterator,
-        typename basic_ptree<K, D, C>::const_assoc_iterator
-    > basic_ptree<K, D, C>::equal_range(const key_type &key) const
+        typename basic_ptree<K, D, C, A>::const_assoc_iterator,
+        typename basic_ptree<K, D, C, A>::const_assoc_iterator
+    > basic_ptree<K, D, C, A>::equal_range(const key_type &key) const
     {
         std::pair<typename subs::by_name_index::const_iterator,
                   typename subs::by_name_index::const_iterator> r(
@@ -513,31 +1049,34 @@ namespace boost { namespace property_tree
             const_assoc_iterator(r.first), const_assoc_iterator(r.second));
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::size_type
-        basic_ptree<K, D, C>::count(const key_type &key) const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::size_type
+        basic_ptree<K, D, C, A>::count(const key_type &key) const
     {
         return subs::assoc(this).count(key);
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::size_type
-        basic_ptree<K, D, C>::erase(const key_type &key)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::size_type
+        basic_ptree<K, D, C, A>::erase(const key_type &key)
     {
+        if (!m_children.first()) {
+            return 0;
+        }
         return subs::assoc(this).erase(key);
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::iterator
-        basic_ptree<K, D, C>::to_iterator(assoc_iterator ai)
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::iterator
+        basic_ptree<K, D, C, A>::to_iterator(assoc_iterator ai)
     {
         return iterator(subs::ch(this).
             BOOST_NESTED_TEMPLATE project<0>(ai.base()));
     }
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::const_iterator
-        basic_ptree<K, D, C>::to_iterator(const_assoc_iterator ai) const
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::const_iterator
+        basic_ptree<K, D, C, A>::to_iterator(const_assoc_iterator ai) const
     {
         return const_iterator(subs::ch(this).
             BOOST_NESTED_TEMPLATE project<0>(ai.base()));
@@ -545,32 +1084,34 @@ namespace boost { namespace property_tree
 
     // Property tree view
 
-    template<class K, class D, class C> inline
-    typename basic_ptree<K, D, C>::data_type &
-        basic_ptree<K, D, C>::data()
+    template<class K, class D, class C, class A> inline
+    typename basic_ptree<K, D, C, A>::data_type &
+        basic_ptree<K, D, C, A>::data()
     {
         return m_data;
     }
 
-    template<class K, class D, class C> inline
-    const typename basic_ptree<K, D, C>::data_type &
-        basic_ptree<K, D, C>::data() const
+    template<class K, class D, class C, class A> inline
+    const typename basic_ptree<K, D, C, A>::data_type &
+        basic_ptree<K, D, C, A>::data() const
     {
         return m_data;
     }
 
-    template<class K, class D, class C> inline
-    void basic_ptree<K, D, C>::clear()
+    template<class K, class D, class C, class A> inline
+    void basic_ptree<K, D, C, A>::clear()
     {
         m_data = data_type();
-        subs::ch(this).clear();
+        if (m_children.first()) {
+            subs::ch(this).clear();
+        }
     }
 
-    template<class K, class D, class C>
-    basic_ptree<K, D, C> &
-        basic_ptree<K, D, C>::get_child(const path_type &path)
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(const path_type &path)
     {
-        path_type p(path);
+        path_type p(detail::walk_copy(path));
         self_type *n = walk_path(p);
         if (!n) {
             BOOST_PROPERTY_TREE_THROW(ptree_bad_path("No such node", path));
@@ -578,26 +1119,26 @@ namespace boost { namespace property_tree
         return *n;
     }
 
-    template<class K, class D, class C> inline
-    const basic_ptree<K, D, C> &
-        basic_ptree<K, D, C>::get_child(const path_type &path) const
+    template<class K, class D, class C, class A> inline
+    const basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(const path_type &path) const
     {
         return const_cast<self_type*>(this)->get_child(path);
     }
 
-    template<class K, class D, class C> inline
-    basic_ptree<K, D, C> &
-        basic_ptree<K, D, C>::get_child(const path_type &path,
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(const path_type &path,
                                         self_type &default_value)
     {
-        path_type p(path);
+        path_type p(detail::walk_copy(path));
         self_type *n = walk_path(p);
         return n ? *n : default_value;
     }
 
-    template<class K, class D, class C> inline
-    const basic_ptree<K, D, C> &
-        basic_ptree<K, D, C>::get_child(const path_type &path,
+    template<class K, class D, class C, class A> inline
+    const basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(const path_type &path,
                                         const self_type &default_value) const
     {
         return const_cast<self_type*>(this)->get_child(path,
@@ -605,11 +1146,11 @@ namespace boost { namespace property_tree
     }
 
 
-    template<class K, class D, class C>
-    optional<basic_ptree<K, D, C> &>
-        basic_ptree<K, D, C>::get_child_optional(const path_type &path)
+    template<class K, class D, class C, class A>
+    optional<basic_ptree<K, D, C, A> &>
+        basic_ptree<K, D, C, A>::get_child_optional(const path_type &path)
     {
-        path_type p(path);
+        path_type p(detail::walk_copy(path));
         self_type *n = walk_path(p);
         if (!n) {
             return optional<self_type&>();
@@ -617,11 +1158,11 @@ namespace boost { namespace property_tree
         return *n;
     }
 
-    template<class K, class D, class C>
-    optional<const basic_ptree<K, D, C> &>
-        basic_ptree<K, D, C>::get_child_optional(const path_type &path) const
+    template<class K, class D, class C, class A>
+    optional<const basic_ptree<K, D, C, A> &>
+        basic_ptree<K, D, C, A>::get_child_optional(const path_type &path) const
     {
-        path_type p(path);
+        path_type p(detail::walk_copy(path));
         self_type *n = walk_path(p);
         if (!n) {
             return optional<const self_type&>();
@@ -629,15 +1170,45 @@ namespace boost { namespace property_tree
         return *n;
     }
 
-    template<class K, class D, class C>
-    basic_ptree<K, D, C> &
-        basic_ptree<K, D, C>::put_child(const path_type &path,
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(const path_char_type *path)
+    {
+        return get_child(detail::borrow_path<path_type>(path));
+    }
+
+    template<class K, class D, class C, class A> inline
+    const basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(const path_char_type *path) const
+    {
+        return get_child(detail::borrow_path<path_type>(path));
+    }
+
+    template<class K, class D, class C, class A>
+    optional<basic_ptree<K, D, C, A> &>
+        basic_ptree<K, D, C, A>::get_child_optional(
+                                                const path_char_type *path)
+    {
+        return get_child_optional(detail::borrow_path<path_type>(path));
+    }
+
+    template<class K, class D, class C, class A>
+    optional<const basic_ptree<K, D, C, A> &>
+        basic_ptree<K, D, C, A>::get_child_optional(
+                                          const path_char_type *path) const
+    {
+        return get_child_optional(detail::borrow_path<path_type>(path));
+    }
+
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::put_child(const path_type &path,
                                         const self_type &value)
     {
-        path_type p(path);
-        self_type &parent = force_path(p);
+        path_type p(detail::walk_copy(path));
+        key_type fragment;
+        self_type &parent = force_path(p, fragment);
         // Got the parent. Now get the correct child.
-        key_type fragment = p.reduce();
         assoc_iterator el = parent.find(fragment);
         // If the new child exists, replace it.
         if(el != parent.not_found()) {
@@ -647,22 +1218,56 @@ namespace boost { namespace property_tree
         }
     }
 
-    template<class K, class D, class C>
-    basic_ptree<K, D, C> &
-        basic_ptree<K, D, C>::add_child(const path_type &path,
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::add_child(const path_type &path,
                                         const self_type &value)
     {
-        path_type p(path);
-        self_type &parent = force_path(p);
+        path_type p(detail::walk_copy(path));
+        key_type fragment;
+        self_type &parent = force_path(p, fragment);
         // Got the parent.
-        key_type fragment = p.reduce();
         return parent.push_back(value_type(fragment, value))->second;
     }
 
-    template<class K, class D, class C>
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::put_child(const path_type &path,
+                                        self_type &&value)
+    {
+        path_type p(detail::walk_copy(path));
+        key_type fragment;
+        self_type &parent = force_path(p, fragment);
+        // Got the parent. Now get the correct child.
+        assoc_iterator el = parent.find(fragment);
+        // If the new child exists, replace it.
+        if(el != parent.not_found()) {
+            return el->second = std::move(value);
+        } else {
+            return parent.push_back(
+                value_type(fragment, std::move(value)))->second;
+        }
+    }
+
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::add_child(const path_type &path,
+                                        self_type &&value)
+    {
+        path_type p(detail::walk_copy(path));
+        key_type fragment;
+        self_type &parent = force_path(p, fragment);
+        // Got the parent.
+        return parent.push_back(
+            value_type(fragment, std::move(value)))->second;
+    }
+#endif
+
+    template<class K, class D, class C, class A>
     template<class Type, class Translator>
     typename boost::enable_if<detail::is_translator<Translator>, Type>::type
-    basic_ptree<K, D, C>::get_value(Translator tr) const
+    basic_ptree<K, D, C, A>::get_value(Translator tr) const
     {
         if(boost::optional<Type> o = get_value_optional<Type>(tr)) {
             return *o;
@@ -672,130 +1277,131 @@ namespace boost { namespace property_tree
             typeid(Type).name() + "\" failed", data()));
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type> inline
-    Type basic_ptree<K, D, C>::get_value() const
+    Type basic_ptree<K, D, C, A>::get_value() const
     {
         return get_value<Type>(
             typename translator_between<data_type, Type>::type());
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type, class Translator> inline
-    Type basic_ptree<K, D, C>::get_value(const Type &default_value,
+    Type basic_ptree<K, D, C, A>::get_value(const Type &default_value,
                                          Translator tr) const
     {
         return get_value_optional<Type>(tr).get_value_or(default_value);
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template <class Ch, class Translator>
     typename boost::enable_if<
         detail::is_character<Ch>,
         std::basic_string<Ch>
     >::type
-    basic_ptree<K, D, C>::get_value(const Ch *default_value, Translator tr)const
+    basic_ptree<K, D, C, A>::get_value(const Ch *default_value,
+                                       Translator tr) const
     {
         return get_value<std::basic_string<Ch>, Translator>(default_value, tr);
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type> inline
     typename boost::disable_if<detail::is_translator<Type>, Type>::type
-    basic_ptree<K, D, C>::get_value(const Type &default_value) const
+    basic_ptree<K, D, C, A>::get_value(const Type &default_value) const
     {
         return get_value(default_value,
                          typename translator_between<data_type, Type>::type());
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template <class Ch>
     typename boost::enable_if<
         detail::is_character<Ch>,
         std::basic_string<Ch>
     >::type
-    basic_ptree<K, D, C>::get_value(const Ch *default_value) const
+    basic_ptree<K, D, C, A>::get_value(const Ch *default_value) const
     {
         return get_value< std::basic_string<Ch> >(default_value);
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type, class Translator> inline
-    optional<Type> basic_ptree<K, D, C>::get_value_optional(
+    optional<Type> basic_ptree<K, D, C, A>::get_value_optional(
                                                 Translator tr) const
     {
         return tr.get_value(data());
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type> inline
-    optional<Type> basic_ptree<K, D, C>::get_value_optional() const
+    optional<Type> basic_ptree<K, D, C, A>::get_value_optional() const
     {
         return get_value_optional<Type>(
             typename translator_between<data_type, Type>::type());
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type, class Translator> inline
     typename boost::enable_if<detail::is_translator<Translator>, Type>::type
-    basic_ptree<K, D, C>::get(const path_type &path,
+    basic_ptree<K, D, C, A>::get(const path_type &path,
                               Translator tr) const
     {
         return get_child(path).BOOST_NESTED_TEMPLATE get_value<Type>(tr);
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type> inline
-    Type basic_ptree<K, D, C>::get(const path_type &path) const
+    Type basic_ptree<K, D, C, A>::get(const path_type &path) const
     {
         return get_child(path).BOOST_NESTED_TEMPLATE get_value<Type>();
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type, class Translator> inline
-    Type basic_ptree<K, D, C>::get(const path_type &path,
+    Type basic_ptree<K, D, C, A>::get(const path_type &path,
                                    const Type &default_value,
                                    Translator tr) const
     {
         return get_optional<Type>(path, tr).get_value_or(default_value);
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template <class Ch, class Translator>
     typename boost::enable_if<
         detail::is_character<Ch>,
         std::basic_string<Ch>
     >::type
-    basic_ptree<K, D, C>::get(
+    basic_ptree<K, D, C, A>::get(
         const path_type &path, const Ch *default_value, Translator tr) const
     {
         return get<std::basic_string<Ch>, Translator>(path, default_value, tr);
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type> inline
     typename boost::disable_if<detail::is_translator<Type>, Type>::type
-    basic_ptree<K, D, C>::get(const path_type &path,
+    basic_ptree<K, D, C, A>::get(const path_type &path,
                               const Type &default_value) const
     {
         return get_optional<Type>(path).get_value_or(default_value);
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template <class Ch>
     typename boost::enable_if<
         detail::is_character<Ch>,
         std::basic_string<Ch>
     >::type
-    basic_ptree<K, D, C>::get(
+    basic_ptree<K, D, C, A>::get(
         const path_type &path, const Ch *default_value) const
     {
         return get< std::basic_string<Ch> >(path, default_value);
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type, class Translator>
-    optional<Type> basic_ptree<K, D, C>::get_optional(const path_type &path,
+    optional<Type> basic_ptree<K, D, C, A>::get_optional(const path_type &path,
                                                          Translator tr) const
     {
         if (optional<const self_type&> child = get_child_optional(path))
@@ -805,9 +1411,9 @@ namespace boost { namespace property_tree
             return optional<Type>();
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type>
-    optional<Type> basic_ptree<K, D, C>::get_optional(
+    optional<Type> basic_ptree<K, D, C, A>::get_optional(
                                                 const path_type &path) const
     {
         if (optional<const self_type&> child = get_child_optional(path))
@@ -816,9 +1422,24 @@ namespace boost { namespace property_tree
             return optional<Type>();
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
+    template<class Type> inline
+    Type basic_ptree<K, D, C, A>::get(const path_char_type *path) const
+    {
+        return get<Type>(detail::borrow_path<path_type>(path));
+    }
+
+    template<class K, class D, class C, class A>
+    template<class Type>
+    optional<Type> basic_ptree<K, D, C, A>::get_optional(
+                                          const path_char_type *path) const
+    {
+        return get_optional<Type>(detail::borrow_path<path_type>(path));
+    }
+
+    template<class K, class D, class C, class A>
     template<class Type, class Translator>
-    void basic_ptree<K, D, C>::put_value(const Type &value, Translator tr)
+    void basic_ptree<K, D, C, A>::put_value(const Type &value, Translator tr)
     {
         if(optional<data_type> o = tr.put_value(value)) {
             data() = *o;
@@ -829,16 +1450,16 @@ namespace boost { namespace property_tree
         }
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type> inline
-    void basic_ptree<K, D, C>::put_value(const Type &value)
+    void basic_ptree<K, D, C, A>::put_value(const Type &value)
     {
         put_value(value, typename translator_between<data_type, Type>::type());
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type, typename Translator>
-    basic_ptree<K, D, C> & basic_ptree<K, D, C>::put(
+    basic_ptree<K, D, C, A> & basic_ptree<K, D, C, A>::put(
         const path_type &path, const Type &value, Translator tr)
     {
         if(optional<self_type &> child = get_child_optional(path)) {
@@ -851,18 +1472,18 @@ namespace boost { namespace property_tree
         }
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type> inline
-    basic_ptree<K, D, C> & basic_ptree<K, D, C>::put(
+    basic_ptree<K, D, C, A> & basic_ptree<K, D, C, A>::put(
         const path_type &path, const Type &value)
     {
         return put(path, value,
                    typename translator_between<data_type, Type>::type());
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type, typename Translator> inline
-    basic_ptree<K, D, C> & basic_ptree<K, D, C>::add(
+    basic_ptree<K, D, C, A> & basic_ptree<K, D, C, A>::add(
         const path_type &path, const Type &value, Translator tr)
     {
         self_type &child = add_child(path, self_type());
@@ -870,9 +1491,9 @@ namespace boost { namespace property_tree
         return child;
     }
 
-    template<class K, class D, class C>
+    template<class K, class D, class C, class A>
     template<class Type> inline
-    basic_ptree<K, D, C> & basic_ptree<K, D, C>::add(
+    basic_ptree<K, D, C, A> & basic_ptree<K, D, C, A>::add(
         const path_type &path, const Type &value)
     {
         return add(path, value,
@@ -880,46 +1501,261 @@ namespace boost { namespace property_tree
     }
 
 
-    template<class K, class D, class C>
-    basic_ptree<K, D, C> *
-    basic_ptree<K, D, C>::walk_path(path_type &p) const
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> *
+    basic_ptree<K, D, C, A>::walk_path(path_type &p) const
     {
-        if(p.empty()) {
-            // I'm the child we're looking for.
-            return const_cast<basic_ptree*>(this);
-        }
-        // Recurse down the tree to find the path.
-        key_type fragment = p.reduce();
-        const_assoc_iterator el = find(fragment);
-        if(el == not_found()) {
-            // No such child.
-            return 0;
+        // Walk down one fragment at a time, until the path is used up.
+        self_type *n = const_cast<self_type*>(this);
+        while(!p.empty()) {
+            n = subs::find_fragment(n, p);
+            if(!n) {
+                // No such child.
+                return 0;
+            }
         }
-        // Not done yet, recurse.
-        return el->second.walk_path(p);
+        return n;
     }
 
-    template<class K, class D, class C>
-    basic_ptree<K, D, C> & basic_ptree<K, D, C>::force_path(path_type &p)
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+    basic_ptree<K, D, C, A>::force_path(path_type &p, key_type &fragment)
     {
         BOOST_ASSERT(!p.empty() && "Empty path not allowed for put_child.");
-        if(p.single()) {
-            // I'm the parent we're looking for.
-            return *this;
+        // Take fragments off the front until none are left behind the
+        // current one; asking p.single() at every level would rescan the
+        // rest of the path each time.
+        self_type *parent = this;
+        fragment = p.reduce();
+        while(!p.empty()) {
+            parent = &subs::force_child(parent, fragment);
+            fragment = p.reduce();
+        }
+        return *parent;
+    }
+
+    // Compiled paths
+
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(const compiled_path_type &path)
+    {
+        self_type *n = subs::walk_keys(this, path.begin(), path.end());
+        if (!n) {
+            BOOST_PROPERTY_TREE_THROW(ptree_bad_path("No such node", path));
+        }
+        return *n;
+    }
+
+    template<class K, class D, class C, class A> inline
+    const basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(
+            const compiled_path_type &path) const
+    {
+        return const_cast<self_type*>(this)->get_child(path);
+    }
+
+    template<class K, class D, class C, class A> inline
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(const compiled_path_type &path,
+                                        self_type &default_value)
+    {
+        self_type *n = subs::walk_keys(this, path.begin(), path.end());
+        return n ? *n : default_value;
+    }
+
+    template<class K, class D, class C, class A> inline
+    const basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::get_child(const compiled_path_type &path,
+                                        const self_type &default_value) const
+    {
+        return const_cast<self_type*>(this)->get_child(path,
+            const_cast<self_type&>(default_value));
+    }
+
+    template<class K, class D, class C, class A>
+    optional<basic_ptree<K, D, C, A> &>
+        basic_ptree<K, D, C, A>::get_child_optional(
+            const compiled_path_type &path)
+    {
+        self_type *n = subs::walk_keys(this, path.begin(), path.end());
+        if (!n) {
+            return optional<self_type&>();
+        }
+        return *n;
+    }
+
+    template<class K, class D, class C, class A>
+    optional<const basic_ptree<K, D, C, A> &>
+        basic_ptree<K, D, C, A>::get_child_optional(
+            const compiled_path_type &path) const
+    {
+        self_type *n = subs::walk_keys(this, path.begin(), path.end());
+        if (!n) {
+            return optional<const self_type&>();
+        }
+        return *n;
+    }
+
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::put_child(const compiled_path_type &path,
+                                        const self_type &value)
+    {
+        BOOST_ASSERT(!path.empty() && "Empty path not allowed for put_child.");
+        typename compiled_path_type::const_iterator last = path.end();
+        --last;
+        self_type &parent = subs::force_keys(this, path.begin(), last);
+        assoc_iterator el = parent.find(*last);
+        if(el != parent.not_found()) {
+            return el->second = value;
+        } else {
+            return parent.push_back(value_type(*last, value))->second;
+        }
+    }
+
+    template<class K, class D, class C, class A>
+    basic_ptree<K, D, C, A> &
+        basic_ptree<K, D, C, A>::add_child(const compiled_path_type &path,
+                                        const self_type &value)
+    {
+        BOOST_ASSERT(!path.empty() && "Empty path not allowed for add_child.");
+        typename compiled_path_type::const_iterator last = path.end();
+        --last;
+        self_type &parent = subs::force_keys(this, path.begin(), last);
+        return parent.push_back(value_type(*last, value))->second;
+    }
+
+    template<class K, class D, class C, class A>
+    template<class Type> inline
+    Type basic_ptree<K, D, C, A>::get(const compiled_path_type &path) const
+    {
+        return get_child(path).BOOST_NESTED_TEMPLATE get_value<Type>();
+    }
+
+    template<class K, class D, class C, class A>
+    template<class Type> inline
+    Type basic_ptree<K, D, C, A>::get(const compiled_path_type &path,
+                                      const Type &default_value) const
+    {
+        if (optional<const self_type&> child = get_child_optional(path))
+            return child.get().get_value(default_value);
+        return default_value;
+    }
+
+    template<class K, class D, class C, class A>
+    template <class Ch>
+    typename boost::enable_if<
+        detail::is_character<Ch>,
+        std::basic_string<Ch>
+    >::type
+    basic_ptree<K, D, C, A>::get(
+        const compiled_path_type &path, const Ch *default_value) const
+    {
+        return get< std::basic_string<Ch> >(path, default_value);
+    }
+
+    template<class K, class D, class C, class A>
+    template<class Type>
+    optional<Type> basic_ptree<K, D, C, A>::get_optional(
+                                        const compiled_path_type &path) const
+    {
+        if (optional<const self_type&> child = get_child_optional(path))
+            return child.get().BOOST_NESTED_TEMPLATE get_value_optional<Type>();
+        else
+            return optional<Type>();
+    }
+
+    template<class K, class D, class C, class A>
+    template<class Type>
+    basic_ptree<K, D, C, A> & basic_ptree<K, D, C, A>::put(
+        const compiled_path_type &path, const Type &value)
+    {
+        if(optional<self_type &> child = get_child_optional(path)) {
+            child.get().put_value(value);
+            return *child;
+        } else {
+            self_type &child2 = put_child(path, self_type());
+            child2.put_value(value);
+            return child2;
+        }
+    }
+
+    template<class K, class D, class C, class A>
+    template<class Type> inline
+    basic_ptree<K, D, C, A> & basic_ptree<K, D, C, A>::add(
+        const compiled_path_type &path, const Type &value)
+    {
+        self_type &child = add_child(path, self_type());
+        child.put_value(value);
+        return child;
+    }
+
+    // Batched lookup
+
+    template<class K, class D, class C, class A>
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator basic_ptree<K, D, C, A>::get_child_many(
+        ForwardIterator first, ForwardIterator last, OutputIterator out)
+    {
+        std::vector<self_type*> nodes(1, this);
+        const compiled_path_type *prev = 0;
+        for (; first != last; ++first, ++out) {
+            const compiled_path_type &path = *first;
+            if (self_type *n = subs::walk_shared(nodes, prev, path)) {
+                *out = optional<self_type&>(*n);
+            } else {
+                *out = optional<self_type&>();
+            }
+            prev = &path;
+        }
+        return out;
+    }
+
+    template<class K, class D, class C, class A>
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator basic_ptree<K, D, C, A>::get_child_many(
+        ForwardIterator first, ForwardIterator last,
+        OutputIterator out) const
+    {
+        std::vector<self_type*> nodes(1, const_cast<self_type*>(this));
+        const compiled_path_type *prev = 0;
+        for (; first != last; ++first, ++out) {
+            const compiled_path_type &path = *first;
+            if (const self_type *n = subs::walk_shared(nodes, prev, path)) {
+                *out = optional<const self_type&>(*n);
+            } else {
+                *out = optional<const self_type&>();
+            }
+            prev = &path;
+        }
+        return out;
+    }
+
+    template<class K, class D, class C, class A>
+    template<class Type, class ForwardIterator, class OutputIterator>
+    OutputIterator basic_ptree<K, D, C, A>::get_many(
+        ForwardIterator first, ForwardIterator last,
+        OutputIterator out) const
+    {
+        std::vector<self_type*> nodes(1, const_cast<self_type*>(this));
+        const compiled_path_type *prev = 0;
+        for (; first != last; ++first, ++out) {
+            const compiled_path_type &path = *first;
+            if (const self_type *n = subs::walk_shared(nodes, prev, path)) {
+                *out = n->BOOST_NESTED_TEMPLATE get_value_optional<Type>();
+            } else {
+                *out = optional<Type>();
+            }
+            prev = &path;
         }
-        key_type fragment = p.reduce();
-        assoc_iterator el = find(fragment);
-        // If we've found an existing child, go down that path. Else
-        // create a new one.
-        self_type& child = el == not_found() ?
-            push_back(value_type(fragment, self_type()))->second : el->second;
-        return child.force_path(p);
+        return out;
     }
 
     // Free functions
 
-    template<class K, class D, class C>
-    inline void swap(basic_ptree<K, D, C> &pt1, basic_ptree<K, D, C> &pt2)
+    template<class K, class D, class C, class A>
+    inline void swap(basic_ptree<K, D, C, A> &pt1, basic_ptree<K, D, C, A> &pt2)
     {
         pt1.swap(pt2);
     }
@@ -0,0 +1,213 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_DETAIL_PTREE_INLINE_CHILDREN_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_DETAIL_PTREE_INLINE_CHILDREN_HPP_INCLUDED
+
+#include <boost/property_tree/ptree_fwd.hpp>
+#include <boost/core/allocator_access.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <cstddef>
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && \
+    !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+#include <utility>
+#endif
+
+namespace boost { namespace property_tree
+{
+
+    /**
+     * Storage policy for basic_ptree, passed in place of its allocator.
+     * A node that has children reserves room for @p N of them in the same
+     * block as its child container. Narrow nodes thus take a single
+     * allocation, and their children lie next to each other in memory.
+     * Any further children are allocated from @p Alloc as usual.
+     *
+     * Children are never moved between the inline slots and the heap, so
+     * iterators and references keep all of basic_ptree's guarantees. The
+     * room for @p N children is taken as soon as a node gets its first
+     * child, which makes this a good fit for trees made of many small
+     * nodes, and a bad one for trees with long chains of single children.
+     */
+    template <std::size_t N, class Alloc>
+    class inline_children : public Alloc
+    {
+    public:
+        template <class U>
+        struct rebind
+        {
+            typedef inline_children<N,
+                typename boost::allocator_rebind<Alloc, U>::type> other;
+        };
+
+        inline_children() {}
+        inline_children(const Alloc &a) : Alloc(a) {}
+        template <class U>
+        inline_children(const inline_children<N, U> &other)
+            : Alloc(other.base()) {}
+
+        /** The underlying allocator. */
+        const Alloc &base() const { return *this; }
+    };
+
+    namespace detail
+    {
+        // The inline slots of one child container. The first node-sized
+        // request fixes the slot size; that is always the container's
+        // header node, which multi_index allocates on construction.
+        template <std::size_t N, class Value>
+        struct inline_slots
+        {
+            // Room for the header and N children. A node is the value plus
+            // at most five pointers of index links.
+            BOOST_STATIC_CONSTANT(std::size_t,
+                bytes = (N + 1) * (sizeof(Value) + 5 * sizeof(void*)));
+            BOOST_STATIC_ASSERT(N > 0 && N < 64);
+
+            inline_slots() : slot_size(0), count(0), used(0) {}
+
+            // Only nodes are placed in the slots. Nodes contain a value,
+            // so they are the only requests larger than one.
+            static bool eligible(std::size_t size) {
+                return size > sizeof(Value);
+            }
+
+            void *allocate(std::size_t size) {
+                if (slot_size == 0) {
+                    // One bit of used per slot.
+                    slot_size = size;
+                    count = (std::min)(bytes / size, std::size_t(64));
+                }
+                if (size != slot_size) {
+                    return 0;
+                }
+                for (std::size_t i = 0; i < count; ++i) {
+                    boost::uint64_t bit = boost::uint64_t(1) << i;
+                    if (!(used & bit)) {
+                        used |= bit;
+                        return first() + i * slot_size;
+                    }
+                }
+                return 0;
+            }
+
+            bool deallocate(void *p) {
+                char *c = static_cast<char*>(p);
+                if (c < first() || c >= first() + count * slot_size) {
+                    return false;
+                }
+                used &= ~(boost::uint64_t(1) <<
+                          static_cast<std::size_t>(c - first()) / slot_size);
+                return true;
+            }
+
+        private:
+            char *first() {
+                return static_cast<char*>(static_cast<void*>(&storage));
+            }
+
+            std::size_t slot_size;
+            std::size_t count;
+            boost::uint64_t used;
+            typename boost::aligned_storage<bytes>::type storage;
+        };
+
+        // The allocator given to a child container in inline_children mode.
+        // Single nodes come from the container's slots while there are free
+        // ones; everything else goes to the underlying allocator.
+        template <class T, class Alloc, class Slots>
+        class inline_slot_allocator
+        {
+            template <class U, class A, class S>
+            friend class inline_slot_allocator;
+        public:
+            typedef T value_type;
+            typedef T *pointer;
+            typedef const T *const_pointer;
+            typedef T &reference;
+            typedef const T &const_reference;
+            typedef std::size_t size_type;
+            typedef std::ptrdiff_t difference_type;
+            template <class U>
+            struct rebind
+            {
+                typedef inline_slot_allocator<U,
+                    typename boost::allocator_rebind<Alloc, U>::type,
+                    Slots> other;
+            };
+
+            inline_slot_allocator() : m_slots(0) {}
+            inline_slot_allocator(const Alloc &a, Slots *slots)
+                : m_base(a), m_slots(slots) {}
+            template <class U, class A>
+            inline_slot_allocator(
+                    const inline_slot_allocator<U, A, Slots> &other)
+                : m_base(other.m_base), m_slots(other.m_slots) {}
+
+            pointer allocate(size_type n, const void * = 0) {
+                if (n == 1 && m_slots && Slots::eligible(sizeof(T))) {
+                    if (void *p = m_slots->allocate(sizeof(T))) {
+                        return static_cast<pointer>(p);
+                    }
+                }
+                return boost::allocator_allocate(m_base, n);
+            }
+            void deallocate(pointer p, size_type n) {
+                if (n == 1 && m_slots && m_slots->deallocate(p)) {
+                    return;
+                }
+                boost::allocator_deallocate(m_base, p, n);
+            }
+            size_type max_size() const {
+                return boost::allocator_max_size(m_base);
+            }
+
+#if !defined(BOOST_NO_CXX11_ALLOCATOR) && \
+    !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && \
+    !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+            // Let the underlying allocator do uses-allocator construction.
+            template <class U, class... Args>
+            void construct(U *p, Args&&... args) {
+                boost::allocator_construct(m_base, p,
+                                           std::forward<Args>(args)...);
+            }
+            template <class U>
+            void destroy(U *p) {
+                boost::allocator_destroy(m_base, p);
+            }
+#else
+            void construct(pointer p, const T &t) {
+                ::new (static_cast<void*>(p)) T(t);
+            }
+            void destroy(pointer p) {
+                p->~T();
+            }
+#endif
+
+            template <class U, class A>
+            bool operator ==(
+                    const inline_slot_allocator<U, A, Slots> &rhs) const {
+                return m_slots == rhs.m_slots && m_base == rhs.m_base;
+            }
+            template <class U, class A>
+            bool operator !=(
+                    const inline_slot_allocator<U, A, Slots> &rhs) const {
+                return !(*this == rhs);
+            }
+
+        private:
+            Alloc m_base;
+            Slots *m_slots;
+        };
+    }
+
+} }
+
+#endif
@@ -16,6 +16,7 @@
 #include <boost/mpl/and.hpp>
 #include <string>
 #include <algorithm>
+#include <cstddef>
 #include <locale>
 
 namespace boost { namespace property_tree { namespace detail
@@ -45,6 +46,30 @@ namespace boost { namespace property_tree { namespace detail
     struct is_character<wchar_t> : public boost::true_type {};
 
 
+    // The string type that parsers and writers use for the keys of a tree
+    // whose key type is Key. Key types that are not strings themselves,
+    // such as basic_interned_string, specialize this.
+    template <typename Key>
+    struct key_string
+    {
+        typedef Key type;
+    };
+
+    // Makes the keys of one document from the strings a parser reads. Key
+    // types that are costly to make, such as basic_interned_string,
+    // specialize this to remember the keys made so far.
+    template <typename Key>
+    struct key_maker
+    {
+        const Key &operator()(const Key &s) const {
+            return s;
+        }
+        template <typename Ch>
+        Key operator()(const Ch *s, std::size_t n) const {
+            return Key(s, n);
+        }
+    };
+
     BOOST_MPL_HAS_XXX_TRAIT_DEF(internal_type)
     BOOST_MPL_HAS_XXX_TRAIT_DEF(external_type)
     template <typename T>
@@ -348,7 +348,8 @@ namespace boost { namespace property_tree { namespace detail {namespace rapidxml
     //! <br><br>
     //! Pool maintains <code>BOOST_PROPERTY_TREE_RAPIDXML_STATIC_POOL_SIZE</code> bytes of statically allocated memory. 
     //! Until static memory is exhausted, no dynamic memory allocations are done.
-    //! When static memory is exhausted, pool allocates additional blocks of memory of size <code>BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE</code> each,
+    //! When static memory is exhausted, pool allocates additional blocks of memory of size <code>BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE</code> each
+    //! (see set_block_size() to change this at runtime),
     //! by using global <code>new[]</code> and <code>delete[]</code> operators. 
     //! This behaviour can be changed by setting custom allocation routines. 
     //! Use set_allocator() function to set them.
@@ -379,6 +380,8 @@ namespace boost { namespace property_tree { namespace detail {namespace rapidxml
         memory_pool()
             : m_alloc_func(0)
             , m_free_func(0)
+            , m_block_size(0)
+            , m_next_block_size(BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE)
         {
             init();
         }
@@ -523,6 +526,52 @@ namespace boost { namespace property_tree { namespace detail {namespace rapidxml
                 m_begin = previous_begin;
             }
             init();
+            m_next_block_size = m_block_size ? m_block_size : BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE;
+        }
+
+        //! Clears the pool like clear(), but keeps its memory for subsequent allocations.
+        //! If the pool had to allocate more than one dynamic block, they are replaced by a single block
+        //! as large as all memory used. A pool that is used for one document after the other
+        //! thus stops allocating memory once it has seen the largest one.
+        //! Any nodes or strings allocated from the pool will no longer be valid.
+        void recycle()
+        {
+            if (m_begin == m_static_memory)
+            {
+                init();
+                return;
+            }
+            header *current = reinterpret_cast<header *>(align(m_begin));
+            if (current->previous_begin == m_static_memory)
+            {
+                m_ptr = reinterpret_cast<char *>(current) + sizeof(header);
+                return;
+            }
+            std::size_t total = sizeof(m_static_memory);
+            while (m_begin != m_static_memory)
+            {
+                header *h = reinterpret_cast<header *>(align(m_begin));
+                char *previous_begin = h->previous_begin;
+                total += h->pool_size;
+                if (m_free_func)
+                    m_free_func(m_begin);
+                else
+                    delete[] m_begin;
+                m_begin = previous_begin;
+            }
+            init();
+            allocate_block(total);
+        }
+
+        //! Sets the size of the dynamic blocks that the pool allocates from now on, when static memory is exhausted.
+        //! Blocks are still made larger for allocations that do not fit otherwise.
+        //! By default, the first block has <code>BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE</code> bytes,
+        //! and each following one twice the size of the one before, up to 64 times that size.
+        //! \param size Size of dynamic blocks in bytes, or 0 to restore the default.
+        void set_block_size(std::size_t size)
+        {
+            m_block_size = size;
+            m_next_block_size = size ? size : BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE;
         }
 
         //! Sets or resets the user-defined memory allocation functions for the pool.
@@ -550,6 +599,7 @@ namespace boost { namespace property_tree { namespace detail {namespace rapidxml
         struct header
         {
             char *previous_begin;
+            std::size_t pool_size;
         };
 
         void init()
@@ -581,6 +631,22 @@ namespace boost { namespace property_tree { namespace detail {namespace rapidxml
             return static_cast<char *>(memory);
         }
         
+        void allocate_block(std::size_t pool_size)
+        {
+            // Allocate
+            std::size_t alloc_size = sizeof(header) + (2 * BOOST_PROPERTY_TREE_RAPIDXML_ALIGNMENT - 2) + pool_size;     // 2 alignments required in worst case: one for header, one for actual allocation
+            char *raw_memory = allocate_raw(alloc_size);
+
+            // Setup new pool in allocated memory
+            char *pool = align(raw_memory);
+            header *new_header = reinterpret_cast<header *>(pool);
+            new_header->previous_begin = m_begin;
+            new_header->pool_size = pool_size;
+            m_begin = raw_memory;
+            m_ptr = pool + sizeof(header);
+            m_end = raw_memory + alloc_size;
+        }
+
         void *allocate_aligned(std::size_t size)
         {
             // Calculate aligned pointer
@@ -589,22 +655,13 @@ namespace boost { namespace property_tree { namespace detail {namespace rapidxml
             // If not enough memory left in current pool, allocate a new pool
             if (result + size > m_end)
             {
-                // Calculate required pool size (may be bigger than BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE)
-                std::size_t pool_size = BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE;
+                // Calculate required pool size (may be bigger than the block size)
+                std::size_t pool_size = m_next_block_size;
                 if (pool_size < size)
                     pool_size = size;
-                
-                // Allocate
-                std::size_t alloc_size = sizeof(header) + (2 * BOOST_PROPERTY_TREE_RAPIDXML_ALIGNMENT - 2) + pool_size;     // 2 alignments required in worst case: one for header, one for actual allocation
-                char *raw_memory = allocate_raw(alloc_size);
-                    
-                // Setup new pool in allocated memory
-                char *pool = align(raw_memory);
-                header *new_header = reinterpret_cast<header *>(pool);
-                new_header->previous_begin = m_begin;
-                m_begin = raw_memory;
-                m_ptr = pool + sizeof(header);
-                m_end = raw_memory + alloc_size;
+                allocate_block(pool_size);
+                if (!m_block_size && m_next_block_size < 64 * BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE)
+                    m_next_block_size *= 2;
 
                 // Calculate aligned pointer again using new pool
                 result = align(m_ptr);
@@ -621,6 +678,8 @@ namespace boost { namespace property_tree { namespace detail {namespace rapidxml
         char m_static_memory[BOOST_PROPERTY_TREE_RAPIDXML_STATIC_POOL_SIZE];    // Static raw memory
         boost_ptree_raw_alloc_func *m_alloc_func;           // Allocator function, or 0 if default is to be used
         boost_ptree_raw_free_func *m_free_func;             // Free function, or 0 if default is to be used
+        std::size_t m_block_size;                           // Size of dynamic blocks, or 0 if they grow
+        std::size_t m_next_block_size;                      // Size of the next dynamic block
     };
 
     ///////////////////////////////////////////////////////////////////////////
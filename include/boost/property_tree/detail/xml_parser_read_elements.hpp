@@ -0,0 +1,338 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_DETAIL_XML_PARSER_READ_ELEMENTS_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_DETAIL_XML_PARSER_READ_ELEMENTS_HPP_INCLUDED
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/detail/xml_parser_error.hpp>
+#include <boost/property_tree/detail/xml_parser_read_rapidxml.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace boost { namespace property_tree { namespace xml_parser
+{
+
+    /**
+     * Reads the elements with a given name out of an XML document one at a
+     * time, without holding the whole document in memory. The stream is
+     * read as needed, and only the element at hand is kept: it is parsed
+     * on its own and translated to a property tree the same way read_xml
+     * would, so that memory use depends on the largest element rather than
+     * on the document.
+     *
+     * Elements are found at any depth. An element with the name that is
+     * inside another one is part of the outer element's tree. Everything
+     * outside the elements is skipped, and only checked as far as needed
+     * to find them.
+     *
+     * @code
+     * xml_element_reader<ptree> reader(stream, "record");
+     * ptree record;
+     * while (reader.next(record))
+     *     process(record);
+     * @endcode
+     */
+    template<class Ptree>
+    class xml_element_reader
+    {
+    public:
+        typedef typename Ptree::key_type key_type;
+        typedef typename key_type::value_type char_type;
+
+        /**
+         * @param stream Stream from which to read the document.
+         * @param name The name of the elements to read.
+         * @param flags Flags controlling the behaviour of the parser, as
+         *              for read_xml.
+         * @param filename The file name to report in errors.
+         */
+        xml_element_reader(std::basic_istream<char_type> &stream,
+                           const key_type &name,
+                           int flags = 0,
+                           const std::string &filename = std::string())
+            : m_stream(stream), m_name(name), m_flags(flags),
+              m_filename(filename), m_pos(0), m_line(1), m_eof(false)
+        {
+            BOOST_ASSERT(validate_flags(flags));
+        }
+
+        /**
+         * Read the next element into @p element. The tree is what read_xml
+         * gives for the element: its attributes, text, comments and child
+         * elements.
+         * @return false if the document holds no further element.
+         * @throw xml_parser_error In case of a syntax error or an error
+         *                         reading the stream.
+         */
+        bool next(Ptree &element)
+        {
+            for (;;)
+            {
+                discard();
+                if (!find_markup())
+                    return false;
+                std::size_t start = m_pos;
+                if (skip_markup() != start_tag || !m_matched)
+                    continue;
+                if (!m_self_closing)
+                    skip_element();
+                parse_element(start, element);
+                return true;
+            }
+        }
+
+    private:
+        typedef char_type Ch;
+        enum markup { start_tag, end_tag, other };
+
+        xml_element_reader(const xml_element_reader &);
+        xml_element_reader &operator =(const xml_element_reader &);
+
+        // Make sure that the buffer holds the character at pos, if the
+        // stream has it.
+        bool fill(std::size_t pos)
+        {
+            while (pos >= m_buffer.size() && !m_eof)
+            {
+                std::size_t size = m_buffer.size();
+                m_buffer.resize(size + read_size);
+                std::streamsize n = 0;
+                if (std::basic_streambuf<Ch> *sb = m_stream.rdbuf())
+                    n = sb->sgetn(&m_buffer[size],
+                                  static_cast<std::streamsize>(read_size));
+                m_buffer.resize(size + static_cast<std::size_t>(n));
+                if (n <= 0)
+                {
+                    m_eof = true;
+                    if (!m_stream.good())
+                        BOOST_PROPERTY_TREE_THROW(xml_parser_error(
+                            "read error", m_filename, 0));
+                }
+            }
+            return pos < m_buffer.size();
+        }
+
+        // The character at pos, or 0 at the end of the stream.
+        Ch at(std::size_t pos)
+        {
+            return fill(pos) ? m_buffer[pos] : Ch();
+        }
+
+        // Drop what has been read, when there is enough of it.
+        void discard()
+        {
+            if (m_pos < read_size || m_pos < m_buffer.size() / 2)
+                return;
+            m_line += static_cast<unsigned long>(std::count(
+                m_buffer.begin(), m_buffer.begin() + m_pos, Ch('\n')));
+            m_buffer.erase(m_buffer.begin(), m_buffer.begin() + m_pos);
+            m_pos = 0;
+        }
+
+        unsigned long line_at(std::size_t pos) const
+        {
+            return m_line + static_cast<unsigned long>(std::count(
+                m_buffer.begin(), m_buffer.begin() + pos, Ch('\n')));
+        }
+
+        void unexpected_end()
+        {
+            BOOST_PROPERTY_TREE_THROW(xml_parser_error(
+                "unexpected end of data", m_filename,
+                line_at(m_buffer.size())));
+        }
+
+        // Move to the next '<'.
+        bool find_markup()
+        {
+            for (;;)
+            {
+                typename std::vector<Ch>::iterator it = std::find(
+                    m_buffer.begin() + m_pos, m_buffer.end(), Ch('<'));
+                m_pos = static_cast<std::size_t>(it - m_buffer.begin());
+                if (it != m_buffer.end())
+                    return true;
+                if (!fill(m_pos))
+                    return false;
+            }
+        }
+
+        // Whether the text at pos is s.
+        bool looking_at(std::size_t pos, const char *s)
+        {
+            for (; *s; ++s, ++pos)
+                if (at(pos) != Ch(*s))
+                    return false;
+            return true;
+        }
+
+        // Move past the next occurrence of s.
+        void skip_past(const char *s)
+        {
+            while (!looking_at(m_pos, s))
+            {
+                if (!fill(m_pos))
+                    unexpected_end();
+                ++m_pos;
+            }
+            m_pos += std::char_traits<char>::length(s);
+        }
+
+        static bool is_whitespace(Ch c)
+        {
+            return c == Ch(' ') || c == Ch('\t') || c == Ch('\n') ||
+                   c == Ch('\r');
+        }
+
+        // Skip the markup at m_pos, which is '<', as rapidxml delimits it.
+        // For a start tag, note whether it has the name we are looking for
+        // and whether it closes itself.
+        markup skip_markup()
+        {
+            Ch c = at(m_pos + 1);
+            if (c == Ch('!'))
+            {
+                if (looking_at(m_pos + 2, "--")) {
+                    m_pos += 4;
+                    skip_past("-->");
+                } else if (looking_at(m_pos + 2, "[CDATA[")) {
+                    m_pos += 9;
+                    skip_past("]]>");
+                } else if (looking_at(m_pos + 2, "DOCTYPE") &&
+                           is_whitespace(at(m_pos + 9))) {
+                    m_pos += 10;
+                    skip_doctype();
+                } else {
+                    m_pos += 2;
+                    skip_past(">");
+                }
+                return other;
+            }
+            if (c == Ch('?'))
+            {
+                m_pos += 2;
+                skip_past("?>");
+                return other;
+            }
+            if (c == Ch('/'))
+            {
+                m_pos += 2;
+                skip_past(">");
+                return end_tag;
+            }
+
+            // Start tag: the name, then attributes up to '>'.
+            ++m_pos;
+            std::size_t name = m_pos;
+            for (Ch n = at(m_pos); n && !is_whitespace(n) && n != Ch('/') &&
+                                   n != Ch('>') && n != Ch('?');
+                 n = at(++m_pos))
+                ;
+            m_matched = m_pos - name == m_name.size() &&
+                std::equal(m_name.begin(), m_name.end(),
+                           m_buffer.begin() + name);
+            Ch previous = Ch();
+            for (;;)
+            {
+                Ch a = at(m_pos);
+                if (!a)
+                    unexpected_end();
+                ++m_pos;
+                if (a == Ch('>'))
+                    break;
+                if (a == Ch('"') || a == Ch('\''))
+                {
+                    const char quote[] = { static_cast<char>(a), 0 };
+                    skip_past(quote);
+                }
+                previous = a;
+            }
+            m_self_closing = previous == Ch('/');
+            return start_tag;
+        }
+
+        void skip_doctype()
+        {
+            for (;;)
+            {
+                Ch c = at(m_pos);
+                if (!c)
+                    unexpected_end();
+                ++m_pos;
+                if (c == Ch('>'))
+                    return;
+                if (c == Ch('['))
+                {
+                    for (int depth = 1; depth > 0; ++m_pos)
+                    {
+                        Ch d = at(m_pos);
+                        if (!d)
+                            unexpected_end();
+                        if (d == Ch('['))
+                            ++depth;
+                        else if (d == Ch(']'))
+                            --depth;
+                    }
+                }
+            }
+        }
+
+        // Move past the end of the element whose start tag was just read.
+        void skip_element()
+        {
+            for (int depth = 1; depth > 0; )
+            {
+                if (!find_markup())
+                    unexpected_end();
+                markup m = skip_markup();
+                if (m == start_tag && !m_self_closing)
+                    ++depth;
+                else if (m == end_tag)
+                    --depth;
+            }
+        }
+
+        // Parse the element's text on its own, with the same rules as
+        // read_xml.
+        void parse_element(std::size_t start, Ptree &element)
+        {
+            m_text.assign(m_buffer.begin() + start, m_buffer.begin() + m_pos);
+            m_text.push_back(Ch());
+            Ptree local(element.get_allocator());
+            try {
+                read_xml_internal(&m_text.front(), m_text.size() - 1, local,
+                                  m_flags, m_filename, m_context);
+            } catch (xml_parser_error &e) {
+                BOOST_PROPERTY_TREE_THROW(xml_parser_error(e.message(),
+                    m_filename, line_at(start) + e.line() - 1));
+            }
+            element.swap(local.front().second);
+        }
+
+        static const std::size_t read_size = 64 * 1024;
+
+        std::basic_istream<Ch> &m_stream;
+        key_type m_name;
+        int m_flags;
+        std::string m_filename;
+        std::vector<Ch> m_buffer;
+        std::vector<Ch> m_text;
+        std::size_t m_pos;
+        unsigned long m_line;   // Line at the start of the buffer
+        bool m_eof;
+        bool m_matched;
+        bool m_self_closing;
+        xml_reader_context<Ch> m_context;
+    };
+
+} } }
+
+#endif
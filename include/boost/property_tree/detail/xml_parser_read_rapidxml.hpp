@@ -15,6 +15,10 @@
 #include <boost/property_tree/detail/xml_parser_flags.hpp>
 #include <boost/property_tree/detail/xml_parser_utils.hpp>
 #include <boost/property_tree/detail/rapidxml.hpp>
+#include <boost/property_tree/detail/parser_io.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <streambuf>
 #include <vector>
 
 namespace boost { namespace property_tree { namespace xml_parser
@@ -22,36 +26,44 @@ namespace boost { namespace property_tree { namespace xml_parser
 
     template<class Ptree, class Ch>
     void read_xml_node(detail::rapidxml::xml_node<Ch> *node,
-                       Ptree &pt, int flags)
+                       Ptree &pt, int flags,
+                       property_tree::detail::key_maker<
+                           typename Ptree::key_type> &keys)
     {
         using namespace detail::rapidxml;
+        // Keys and text are made separately: where keys are interned,
+        // the text is not.
+        typedef typename Ptree::key_type Key;
+        typedef typename property_tree::detail::key_string<Key>::type Str;
         switch (node->type())
         {
             // Element nodes
             case node_element: 
             {
                 // Create node
-                Ptree &pt_node = pt.push_back(std::make_pair(node->name(),
-                                                             Ptree()))->second;
+                Ptree &pt_node = pt.push_back(std::make_pair(
+                    keys(node->name(), node->name_size()),
+                    Ptree()))->second;
 
                 // Copy attributes
                 if (node->first_attribute())
                 {
                     Ptree &pt_attr_root = pt_node.push_back(
-                        std::make_pair(xmlattr<typename Ptree::key_type>(), Ptree()))->second;
+                        std::make_pair(keys(xmlattr<Str>()), Ptree()))->second;
                     for (xml_attribute<Ch> *attr = node->first_attribute();
                          attr; attr = attr->next_attribute())
                     {
                         Ptree &pt_attr = pt_attr_root.push_back(
-                            std::make_pair(attr->name(), Ptree()))->second;
-                        pt_attr.data() = typename Ptree::key_type(attr->value(), attr->value_size());
+                            std::make_pair(keys(attr->name(), attr->name_size()),
+                                           Ptree()))->second;
+                        pt_attr.data() = Str(attr->value(), attr->value_size());
                     }
                 }
 
                 // Copy children
                 for (xml_node<Ch> *child = node->first_node();
                      child; child = child->next_sibling())
-                    read_xml_node(child, pt_node, flags);
+                    read_xml_node(child, pt_node, flags, keys);
             }
             break;
 
@@ -60,10 +72,10 @@ namespace boost { namespace property_tree { namespace xml_parser
             case node_cdata:
             {
                 if (flags & no_concat_text)
-                    pt.push_back(std::make_pair(xmltext<typename Ptree::key_type>(),
-                                                Ptree(node->value())));
+                    pt.push_back(std::make_pair(keys(xmltext<Str>()),
+                                    Ptree(Str(node->value(), node->value_size()))));
                 else
-                    pt.data() += typename Ptree::key_type(node->value(), node->value_size());
+                    pt.data() += Str(node->value(), node->value_size());
             }
             break;
 
@@ -71,8 +83,8 @@ namespace boost { namespace property_tree { namespace xml_parser
             case node_comment:
             {
                 if (!(flags & no_comments))
-                    pt.push_back(std::make_pair(xmlcomment<typename Ptree::key_type>(),
-                                    Ptree(typename Ptree::key_type(node->value(), node->value_size()))));
+                    pt.push_back(std::make_pair(keys(xmlcomment<Str>()),
+                                    Ptree(Str(node->value(), node->value_size()))));
             }
             break;
 
@@ -82,63 +94,210 @@ namespace boost { namespace property_tree { namespace xml_parser
         }
     }
 
+    /**
+     * Memory that read_xml can reuse from one document to the next. The
+     * parser's document and node pool live on the heap, and a series of
+     * read_xml calls given the same context keeps the pool's last block and
+     * the input buffer, so that parsing stops allocating once the largest
+     * document has been seen. A context must not be used by two threads at
+     * the same time.
+     */
+    template<class Ch>
+    class xml_reader_context
+    {
+    public:
+        typedef detail::rapidxml::xml_document<Ch> document_type;
+        typedef void *(alloc_func)(std::size_t);
+        typedef void (free_func)(void *);
+
+        xml_reader_context()
+            : m_doc(new document_type), m_block_size(0)
+        {
+        }
+
+        ~xml_reader_context()
+        {
+            delete m_doc;
+        }
+
+        /**
+         * Set the functions that allocate and free the memory for nodes.
+         * Memory held so far is released.
+         * @param af Allocation function, or 0 for operator new[].
+         * @param ff Free function, or 0 for operator delete[].
+         */
+        void set_allocator(alloc_func *af, free_func *ff)
+        {
+            m_doc->clear();
+            m_doc->set_allocator(af, ff);
+        }
+
+        /// Passed to set_block_size to size the blocks after the input.
+        BOOST_STATIC_CONSTANT(std::size_t, input_sized = ~std::size_t(0));
+
+        /**
+         * Set the size in bytes of the blocks in which memory for nodes is
+         * allocated. The default, 0, starts with small blocks that double
+         * in size up to a few MiB. @c input_sized makes the first block
+         * large enough for the nodes of the whole input, so that a document
+         * of any size needs a single block.
+         */
+        void set_block_size(std::size_t size)
+        {
+            m_block_size = size;
+        }
+
+        /** Release all memory held by the context. */
+        void release()
+        {
+            m_doc->clear();
+            std::vector<Ch>().swap(m_buffer);
+        }
+
+        // For the parser's use.
+        document_type &document() { return *m_doc; }
+        std::vector<Ch> &buffer() { return m_buffer; }
+        std::size_t block_size(std::size_t input_size) const
+        {
+            // A node takes about a hundred bytes, and markup-dense text has
+            // one every few characters; the pool merges its blocks after a
+            // document that needed more.
+            if (m_block_size != input_sized)
+                return m_block_size;
+            return (std::max)(
+                static_cast<std::size_t>(
+                    BOOST_PROPERTY_TREE_RAPIDXML_DYNAMIC_POOL_SIZE),
+                16 * input_size);
+        }
+
+    private:
+        xml_reader_context(const xml_reader_context &);
+        xml_reader_context &operator =(const xml_reader_context &);
+
+        document_type *m_doc;
+        std::vector<Ch> m_buffer;
+        std::size_t m_block_size;
+    };
+
+    // Empties the document when parsing is over, keeping its memory.
+    template<class Ch>
+    class xml_document_recycler
+    {
+    public:
+        explicit xml_document_recycler(
+                detail::rapidxml::xml_document<Ch> &doc)
+            : m_doc(doc)
+        {
+        }
+
+        ~xml_document_recycler()
+        {
+            m_doc.remove_all_nodes();
+            m_doc.remove_all_attributes();
+            m_doc.recycle();
+        }
+
+    private:
+        xml_document_recycler(const xml_document_recycler &);
+        xml_document_recycler &operator =(const xml_document_recycler &);
+
+        detail::rapidxml::xml_document<Ch> &m_doc;
+    };
+
+    // Parse the zero-terminated text in place and build the tree from it.
+    // Names and values are taken by their sizes, so the parser need not
+    // terminate them.
     template<class Ptree>
-    void read_xml_internal(std::basic_istream<
-                               typename Ptree::key_type::value_type> &stream,
+    void read_xml_internal(typename Ptree::key_type::value_type *text,
+                           std::size_t size,
                            Ptree &pt,
                            int flags,
-                           const std::string &filename)
+                           const std::string &filename,
+                           xml_reader_context<
+                               typename Ptree::key_type::value_type> &context)
     {
         typedef typename Ptree::key_type::value_type Ch;
         using namespace detail::rapidxml;
 
-        // Load data into vector
-        stream.unsetf(std::ios::skipws);
-        std::vector<Ch> v(std::istreambuf_iterator<Ch>(stream.rdbuf()),
-                          std::istreambuf_iterator<Ch>());
-        if (!stream.good())
-            BOOST_PROPERTY_TREE_THROW(
-                xml_parser_error("read error", filename, 0));
-        v.push_back(0); // zero-terminate
-
+        xml_document<Ch> &doc = context.document();
+        doc.set_block_size(context.block_size(size));
+        xml_document_recycler<Ch> recycler(doc);
         try {
             // Parse using appropriate flags
             const int f_tws = parse_normalize_whitespace
-                            | parse_trim_whitespace;
-            const int f_c = parse_comment_nodes;
+                            | parse_trim_whitespace
+                            | parse_no_string_terminators;
+            const int f_c = parse_comment_nodes
+                          | parse_no_string_terminators;
             // Some compilers don't like the bitwise or in the template arg.
             const int f_tws_c = parse_normalize_whitespace
                               | parse_trim_whitespace
-                              | parse_comment_nodes;
-            xml_document<Ch> doc;
+                              | parse_comment_nodes
+                              | parse_no_string_terminators;
+            const int f_none = parse_no_string_terminators;
             if (flags & no_comments) {
                 if (flags & trim_whitespace)
-                    doc.BOOST_NESTED_TEMPLATE parse<f_tws>(&v.front());
+                    doc.BOOST_NESTED_TEMPLATE parse<f_tws>(text);
                 else
-                    doc.BOOST_NESTED_TEMPLATE parse<0>(&v.front());
+                    doc.BOOST_NESTED_TEMPLATE parse<f_none>(text);
             } else {
                 if (flags & trim_whitespace)
-                    doc.BOOST_NESTED_TEMPLATE parse<f_tws_c>(&v.front());
+                    doc.BOOST_NESTED_TEMPLATE parse<f_tws_c>(text);
                 else
-                    doc.BOOST_NESTED_TEMPLATE parse<f_c>(&v.front());
+                    doc.BOOST_NESTED_TEMPLATE parse<f_c>(text);
             }
 
             // Create ptree from nodes
-            Ptree local;
+            Ptree local(pt.get_allocator());
+            property_tree::detail::key_maker<typename Ptree::key_type> keys;
             for (xml_node<Ch> *child = doc.first_node();
                  child; child = child->next_sibling())
-                read_xml_node(child, local, flags);
+                read_xml_node(child, local, flags, keys);
 
             // Swap local and result ptrees
             pt.swap(local);
         } catch (parse_error &e) {
             long line = static_cast<long>(
-                std::count(&v.front(), e.where<Ch>(), Ch('\n')) + 1);
+                std::count(text, e.where<Ch>(), Ch('\n')) + 1);
             BOOST_PROPERTY_TREE_THROW(
                 xml_parser_error(e.what(), filename, line));  
         }
     }
 
+    template<class Ptree>
+    void read_xml_internal(std::basic_istream<
+                               typename Ptree::key_type::value_type> &stream,
+                           Ptree &pt,
+                           int flags,
+                           const std::string &filename,
+                           xml_reader_context<
+                               typename Ptree::key_type::value_type> &context)
+    {
+        typedef typename Ptree::key_type::value_type Ch;
+
+        // Load data into the buffer, a block at a time
+        std::vector<Ch> &v = context.buffer();
+        std::size_t size = property_tree::detail::read_stream(stream, v);
+        if (!stream.good())
+            BOOST_PROPERTY_TREE_THROW(
+                xml_parser_error("read error", filename, 0));
+        v.resize(size);
+        v.push_back(0); // zero-terminate
+
+        read_xml_internal(&v.front(), size, pt, flags, filename, context);
+    }
+
+    template<class Ptree>
+    void read_xml_internal(std::basic_istream<
+                               typename Ptree::key_type::value_type> &stream,
+                           Ptree &pt,
+                           int flags,
+                           const std::string &filename)
+    {
+        xml_reader_context<typename Ptree::key_type::value_type> context;
+        read_xml_internal(stream, pt, flags, filename, context);
+    }
+
 } } }
 
 #endif
@@ -13,23 +13,94 @@
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/detail/xml_parser_utils.hpp>
+#include <boost/property_tree/detail/parser_io.hpp>
+#include <cstddef>
 #include <string>
 #include <ostream>
-#include <iomanip>
 
 namespace boost { namespace property_tree { namespace xml_parser
 {
+    // Hands the output to the stream buffer in large pieces, rather than
+    // going through the stream for every token.
+    template<class Ch>
+    class xml_output : public property_tree::detail::staged_output<Ch>
+    {
+    public:
+        explicit xml_output(std::basic_ostream<Ch> &stream)
+            : property_tree::detail::staged_output<Ch>(stream, 16 * 1024)
+        {
+        }
+
+        // Write s with the characters that XML reserves replaced by
+        // entities; see encode_char_entities. Runs of other characters are
+        // copied as a whole.
+        template<class Str>
+        void put_encoded(const Str &s)
+        {
+            typedef typename Str::size_type size_type;
+            if (s.empty())
+                return;
+            if (s.find_first_not_of(Ch(' ')) == Str::npos)
+            {
+                this->put_literal("&#32;");
+                this->put(s.size() - 1, Ch(' '));
+                return;
+            }
+            const Ch specials[] = {
+                Ch('<'), Ch('>'), Ch('&'), Ch('"'), Ch('\''), Ch()
+            };
+            size_type first = 0;
+            for (;;)
+            {
+                size_type run = s.find_first_of(specials, first);
+                this->put(s.begin() + first,
+                    run == Str::npos ? s.end() : s.begin() + run);
+                if (run == Str::npos)
+                    break;
+                switch (s[run])
+                {
+                    case Ch('<'): this->put_literal("&lt;"); break;
+                    case Ch('>'): this->put_literal("&gt;"); break;
+                    case Ch('&'): this->put_literal("&amp;"); break;
+                    case Ch('"'): this->put_literal("&quot;"); break;
+                    default: this->put_literal("&apos;"); break;
+                }
+                first = run + 1;
+            }
+        }
+    };
+
+    // What a child node stands for in XML.
+    enum xml_node_kind { xml_attributes, xml_comment, xml_text, xml_element };
+
+    // The special keys all start with '<', which no element name does, so
+    // that most keys are told apart by their first character.
+    template<class Str>
+    xml_node_kind classify_xml_node(const Str &key)
+    {
+        typedef typename Str::value_type Ch;
+        if (key.empty() || key[0] != Ch('<'))
+            return xml_element;
+        if (key == xmlattr<Str>())
+            return xml_attributes;
+        if (key == xmlcomment<Str>())
+            return xml_comment;
+        if (key == xmltext<Str>())
+            return xml_text;
+        return xml_element;
+    }
+
     template<class Str>
-    void write_xml_indent(std::basic_ostream<typename Str::value_type> &stream,
+    void write_xml_indent(xml_output<typename Str::value_type> &out,
           int indent,
           const xml_writer_settings<Str> & settings
           )
     {
-        stream << std::basic_string<typename Str::value_type>(indent * settings.indent_count, settings.indent_char);
+        out.put(indent * settings.indent_count, settings.indent_char);
     }
 
     template<class Str>
-    void write_xml_comment(std::basic_ostream<typename Str::value_type> &stream,
+    void write_xml_comment(xml_output<typename Str::value_type> &out,
                            const Str &s,
                            int indent,
                            bool separate_line,
@@ -38,16 +109,16 @@ namespace boost { namespace property_tree { namespace xml_parser
     {
         typedef typename Str::value_type Ch;
         if (separate_line)
-            write_xml_indent(stream,indent,settings);
-        stream << Ch('<') << Ch('!') << Ch('-') << Ch('-');
-        stream << s;
-        stream << Ch('-') << Ch('-') << Ch('>');
+            write_xml_indent(out,indent,settings);
+        out.put_literal("<!--");
+        out.put(s);
+        out.put_literal("-->");
         if (separate_line)
-            stream << Ch('\n');
+            out.put(Ch('\n'));
     }
 
     template<class Str>
-    void write_xml_text(std::basic_ostream<typename Str::value_type> &stream,
+    void write_xml_text(xml_output<typename Str::value_type> &out,
                         const Str &s,
                         int indent, 
                         bool separate_line,
@@ -56,14 +127,14 @@ namespace boost { namespace property_tree { namespace xml_parser
     {
         typedef typename Str::value_type Ch;
         if (separate_line)
-            write_xml_indent(stream,indent,settings);
-        stream << encode_char_entities(s);
+            write_xml_indent(out,indent,settings);
+        out.put_encoded(s);
         if (separate_line)
-            stream << Ch('\n');
+            out.put(Ch('\n'));
     }
 
     template<class Ptree>
-    void write_xml_element(std::basic_ostream<typename Ptree::key_type::value_type> &stream,
+    void write_xml_element(xml_output<typename Ptree::key_type::value_type> &out,
                            const typename Ptree::key_type &key,
                            const Ptree &pt,
                            int indent,
@@ -79,10 +150,11 @@ namespace boost { namespace property_tree { namespace xml_parser
         bool has_attrs_only = pt.data().empty();
         for (It it = pt.begin(), end = pt.end(); it != end; ++it)
         {
-            if (it->first != xmlattr<Str>() )
+            xml_node_kind kind = classify_xml_node(it->first);
+            if (kind != xml_attributes)
             {
                 has_attrs_only = false;
-                if (it->first != xmltext<Str>())
+                if (kind != xml_text)
                 {
                     has_elements = true;
                     break;
@@ -90,16 +162,19 @@ namespace boost { namespace property_tree { namespace xml_parser
             }
         }
 
+        Str temp;
+
         // Write element
         if (pt.data().empty() && pt.empty())    // Empty key
         {
             if (indent >= 0)
             {
-                write_xml_indent(stream,indent,settings);
-                stream << Ch('<') << key << 
-                          Ch('/') << Ch('>');
+                write_xml_indent(out,indent,settings);
+                out.put(Ch('<'));
+                out.put(key);
+                out.put_literal("/>");
                 if (want_pretty)
-                    stream << Ch('\n');
+                    out.put(Ch('\n'));
             }
         }
         else    // Nonempty key
@@ -108,68 +183,85 @@ namespace boost { namespace property_tree { namespace xml_parser
             if (indent >= 0)
             {
                 // Write opening brace and key
-                write_xml_indent(stream,indent,settings);
-                stream << Ch('<') << key;
+                write_xml_indent(out,indent,settings);
+                out.put(Ch('<'));
+                out.put(key);
 
                 // Write attributes
-                if (optional<const Ptree &> attribs = pt.get_child_optional(xmlattr<Str>()))
-                    for (It it = attribs.get().begin(); it != attribs.get().end(); ++it)
-                        stream << Ch(' ') << it->first << Ch('=')
-                               << Ch('"')
-                               << encode_char_entities(
-                                    it->second.template get_value<Str>())
-                               << Ch('"');
+                typename Ptree::const_assoc_iterator attribs =
+                    pt.find(xmlattr<Str>());
+                if (attribs != pt.not_found())
+                {
+                    const Ptree &attrs = attribs->second;
+                    for (It it = attrs.begin(); it != attrs.end(); ++it)
+                    {
+                        out.put(Ch(' '));
+                        out.put(it->first);
+                        out.put_literal("=\"");
+                        out.put_encoded(property_tree::detail::string_data(
+                            it->second, temp));
+                        out.put(Ch('"'));
+                    }
+                }
 
                 if ( has_attrs_only )
                 {
                     // Write closing brace
-                    stream << Ch('/') << Ch('>');
+                    out.put_literal("/>");
                     if (want_pretty)
-                        stream << Ch('\n');
+                        out.put(Ch('\n'));
                 }
                 else
                 {
                     // Write closing brace
-                    stream << Ch('>');
+                    out.put(Ch('>'));
 
                     // Break line if needed and if we want pretty-printing
                     if (has_elements && want_pretty)
-                        stream << Ch('\n');
+                        out.put(Ch('\n'));
                 }
             }
 
             // Write data text, if present
             if (!pt.data().empty())
-                write_xml_text(stream,
-                    pt.template get_value<Str>(),
+                write_xml_text(out,
+                    property_tree::detail::string_data(pt, temp),
                     indent + 1, has_elements && want_pretty, settings);
 
             // Write elements, comments and texts
             for (It it = pt.begin(); it != pt.end(); ++it)
             {
-                if (it->first == xmlattr<Str>())
-                    continue;
-                else if (it->first == xmlcomment<Str>())
-                    write_xml_comment(stream,
-                        it->second.template get_value<Str>(),
+                switch (classify_xml_node(it->first))
+                {
+                case xml_attributes:
+                    break;
+                case xml_comment:
+                    write_xml_comment(out,
+                        property_tree::detail::string_data(it->second, temp),
                         indent + 1, want_pretty, settings);
-                else if (it->first == xmltext<Str>())
-                    write_xml_text(stream,
-                        it->second.template get_value<Str>(),
+                    break;
+                case xml_text:
+                    write_xml_text(out,
+                        property_tree::detail::string_data(it->second, temp),
                         indent + 1, has_elements && want_pretty, settings);
-                else
-                    write_xml_element(stream, it->first, it->second,
+                    break;
+                default:
+                    write_xml_element(out, it->first, it->second,
                         indent + 1, settings);
+                    break;
+                }
             }
 
             // Write closing tag
             if (indent >= 0 && !has_attrs_only)
             {
                 if (has_elements)
-                    write_xml_indent(stream,indent,settings);
-                stream << Ch('<') << Ch('/') << key << Ch('>');
+                    write_xml_indent(out,indent,settings);
+                out.put_literal("</");
+                out.put(key);
+                out.put(Ch('>'));
                 if (want_pretty)
-                    stream << Ch('\n');
+                    out.put(Ch('\n'));
             }
 
         }
@@ -182,10 +274,14 @@ namespace boost { namespace property_tree { namespace xml_parser
                             const xml_writer_settings<typename Ptree::key_type> & settings)
     {
         typedef typename Ptree::key_type Str;
-        stream  << detail::widen<Str>("<?xml version=\"1.0\" encoding=\"")
-                << settings.encoding
-                << detail::widen<Str>("\"?>\n");
-        write_xml_element(stream, Str(), pt, -1, settings);
+        {
+            xml_output<typename Str::value_type> out(stream);
+            out.put_literal("<?xml version=\"1.0\" encoding=\"");
+            out.put(settings.encoding);
+            out.put_literal("\"?>\n");
+            write_xml_element(out, Str(), pt, -1, settings);
+            out.flush();
+        }
         if (!stream)
             BOOST_PROPERTY_TREE_THROW(xml_parser_error("write error", filename, 0));
     }
@@ -29,7 +29,7 @@ namespace boost { namespace property_tree { namespace info_parser
     template<class Ptree, class Ch>
     void read_info(std::basic_istream<Ch> &stream, Ptree &pt)
     {
-        Ptree local;
+        Ptree local(pt.get_allocator());
         read_info_internal(stream, local, std::string(), 0);
         pt.swap(local);
     }
@@ -69,7 +69,7 @@ namespace boost { namespace property_tree { namespace info_parser
                 "cannot open file for reading", filename, 0));
         }
         stream.imbue(loc);
-        Ptree local;
+        Ptree local(pt.get_allocator());
         read_info_internal(stream, local, filename, 0);
         pt.swap(local);
     }
@@ -94,6 +94,48 @@ namespace boost { namespace property_tree { namespace info_parser
         }
     }
 
+    /**
+     * Read INFO from a the given stream and translate it to a property tree,
+     * taking included files from @p cache.
+     * @note Replaces the existing contents. Strong exception guarantee.
+     * @throw info_parser_error If the stream cannot be read, doesn't contain
+     *                          valid INFO, or a conversion fails.
+     * @param cache The trees of included files, shared between calls.
+     */
+    template<class Ptree, class Ch>
+    void read_info(std::basic_istream<Ch> &stream, Ptree &pt,
+                   info_include_cache<Ptree> &cache)
+    {
+        Ptree local(pt.get_allocator());
+        read_info_internal(stream, local, std::string(), 0, &cache);
+        pt.swap(local);
+    }
+
+    /**
+     * Read INFO from a the given file and translate it to a property tree,
+     * taking included files from @p cache.
+     * @note Replaces the existing contents. Strong exception guarantee.
+     * @throw info_parser_error If the file cannot be read, doesn't contain
+     *                          valid INFO, or a conversion fails.
+     * @param cache The trees of included files, shared between calls.
+     */
+    template<class Ptree>
+    void read_info(const std::string &filename, Ptree &pt,
+                   info_include_cache<Ptree> &cache,
+                   const std::locale &loc = std::locale())
+    {
+        std::basic_ifstream<typename Ptree::key_type::value_type>
+            stream(filename.c_str());
+        if (!stream) {
+            BOOST_PROPERTY_TREE_THROW(info_parser_error(
+                "cannot open file for reading", filename, 0));
+        }
+        stream.imbue(loc);
+        Ptree local(pt.get_allocator());
+        read_info_internal(stream, local, filename, 0, &cache);
+        pt.swap(local);
+    }
+
     /**
      * Writes a tree to the stream in INFO format.
      * @throw info_parser_error If the stream cannot be written to, or a
@@ -143,6 +185,7 @@ namespace boost { namespace property_tree
 {
     using info_parser::info_parser_error;
     using info_parser::read_info;
+    using info_parser::info_include_cache;
     using info_parser::write_info;
     using info_parser::info_writer_settings;
     using info_parser::info_writer_make_settings;
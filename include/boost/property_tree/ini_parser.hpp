@@ -14,13 +14,17 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/detail/ptree_utils.hpp>
 #include <boost/property_tree/detail/file_parser_error.hpp>
+#include <boost/property_tree/detail/parser_io.hpp>
 #include <boost/optional.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <stdexcept>
 #include <locale>
+#include <vector>
 
 namespace boost { namespace property_tree { namespace ini_parser
 {
@@ -60,9 +64,10 @@ namespace boost { namespace property_tree { namespace ini_parser
         template<typename StringType>
         inline StringType make_string(const char* string)
         {
-            std::basic_ostringstream<typename StringType::value_type> stm;
-            stm << string;
-            return stm.str();
+            StringType result;
+            for (; *string; ++string)
+                result += typename StringType::value_type(*string);
+            return result;
         }
 
         template<typename StringType>
@@ -80,8 +85,7 @@ namespace boost { namespace property_tree { namespace ini_parser
         template<typename CharType>
         inline CharType comment_start_character()
         {
-            std::basic_ostringstream<CharType> stm;
-            return stm.widen('#');
+            return CharType('#');
         }
 
         template<class Ptree>
@@ -101,77 +105,95 @@ namespace boost { namespace property_tree { namespace ini_parser
             }
         }
 
+        // Collects the whole output, so that nothing is written when the
+        // tree turns out not to be valid INI.
+        template<class Ch>
+        class ini_output : public property_tree::detail::staged_output<Ch>
+        {
+        public:
+            explicit ini_output(std::basic_ostream<Ch> &stream)
+                : property_tree::detail::staged_output<Ch>(stream),
+                  m_at_start(stream.tellp() == 0)
+            {
+            }
+
+            // Whether nothing precedes the output in the stream.
+            bool at_start() const
+            {
+                return m_at_start && this->empty();
+            }
+
+        private:
+            bool m_at_start;
+        };
+
+        // Each line of the comment is written after commentStart, without
+        // '\r'. Lines that are empty are written as they are.
         template<class Ptree>
-        void write_comment(std::basic_ostream<
-                               typename Ptree::key_type::value_type
-                           > &stream,
-                           const typename Ptree::key_type& comment,
+        void write_comment(ini_output<typename Ptree::key_type::value_type> &out,
+                           const std::basic_string<
+                               typename Ptree::key_type::value_type>& comment,
                            const typename Ptree::key_type::value_type& commentStart)
         {
             typedef typename Ptree::key_type::value_type Ch;
+            typedef typename std::basic_string<Ch>::const_iterator It;
             if (comment.empty())
                 return;
-            typename Ptree::key_type line;
-            bool hadNonEmptyLine = false;
-            for (size_t i = 0; i < comment.size(); i++)
+            for (It first = comment.begin(), end = comment.end(); ; )
             {
-                if (comment[i] == Ch('\n'))
+                It last = std::find(first, end, Ch('\n'));
+                bool empty = true;
+                for (It cr = first; cr != last; ++cr)
                 {
-                    if (!line.empty() || hadNonEmptyLine)
-                    {
-                        // dump comment line
-                        stream << commentStart << line << Ch('\n');
-                    }
-                    else
+                    if (*cr != Ch('\r'))
                     {
-                        // preceding empty lines are output without the commentStart
-                        // dump comment line
-                        stream << Ch('\n');
+                        empty = false;
+                        break;
                     }
-                    line.clear();
-                    hadNonEmptyLine |= (!line.empty());
                 }
-                else if (comment[i] != Ch('\r'))
+                if (!empty)
                 {
-                    // Ignore '\r' (for Windows!)
-                    line += comment[i];
+                    out.put(commentStart);
+                    for (It cr; (cr = std::find(first, last, Ch('\r'))) != last;
+                         first = cr + 1)
+                        out.put(first, cr);
+                    out.put(first, last);
                 }
-            }
-            if (!line.empty() || hadNonEmptyLine)
-            {
-                // dump comment line
-                stream << commentStart << line << Ch('\n');
-            }
-            else
-            {
-                // preceding empty lines are output without the commentStart
-                // dump comment line
-                stream << Ch('\n');
+                out.put(Ch('\n'));
+                if (last == end)
+                    break;
+                first = last + 1;
             }
         }
 
         template <typename Ptree>
-        void write_keys(std::basic_ostream<
-                                      typename Ptree::key_type::value_type
-                                  > &stream,
-                                  const Ptree& pt,
-                                  bool throw_on_children,
-                                  const typename Ptree::key_type& commentKey,
-                                  const typename Ptree::key_type::value_type& commentStart,
-                                  const typename boost::optional<typename Ptree::key_type>& sectionName = {})
+        void write_keys(ini_output<typename Ptree::key_type::value_type> &out,
+                        const Ptree& pt,
+                        bool throw_on_children,
+                        const typename Ptree::key_type& commentKey,
+                        const typename Ptree::key_type::value_type& commentStart,
+                        const typename Ptree::key_type *sectionName = 0)
         {
             typedef typename Ptree::key_type::value_type Ch;
             typedef typename Ptree::key_type Str;
+            typedef typename Ptree::const_assoc_iterator Found;
             const Str sectionCommentKey = section_comment_key<Str>();
+            std::basic_string<Ch> temp;
             for (typename Ptree::const_iterator it = pt.begin(), end = pt.end();
                  it != end; ++it)
             {
                 // check for existence of comment node
-                boost::optional<Str> comment = it->second.template get_optional<Str>(commentKey);
-                boost::optional<Str> sectionComment = it->second.template get_optional<Str>(sectionCommentKey);
-
-                const typename Ptree::size_type commentCount = bool(comment) + bool(sectionComment);
-                if (it->second.size() != commentCount) {
+                const Ptree &child = it->second;
+                Found comment = child.not_found(), sectionComment = comment;
+                typename Ptree::size_type commentCount = 0;
+                if (!child.empty())
+                {
+                    comment = child.find(commentKey);
+                    sectionComment = child.find(sectionCommentKey);
+                    commentCount = (comment != child.not_found()) +
+                                   (sectionComment != child.not_found());
+                }
+                if (child.size() != commentCount) {
                     //only two depth-levels are allowed in INI-files ... but we also have to filter out the additional .comment nodes
                     if (throw_on_children) {
                         BOOST_PROPERTY_TREE_THROW(ini_parser_error(
@@ -184,132 +206,148 @@ namespace boost { namespace property_tree { namespace ini_parser
                 if (it == pt.begin() && sectionName)
                 {
                     // empty lines in front of a new section to better separate it from other sections
-                    if (stream.tellp() != 0)
-                        stream  << Ch('\n');
-
-                    if (sectionComment)
-                        write_comment<Ptree>(stream, *sectionComment, commentStart);
-
-                    stream << Ch('[') << *sectionName << Ch(']') << Ch('\n');
+                    if (!out.at_start())
+                        out.put(Ch('\n'));
+
+                    if (sectionComment != child.not_found())
+                        write_comment<Ptree>(out,
+                            property_tree::detail::string_data(
+                                sectionComment->second, temp),
+                            commentStart);
+
+                    out.put(Ch('['));
+                    out.put(*sectionName);
+                    out.put(Ch(']'));
+                    out.put(Ch('\n'));
                 }
                 // write parameter
-                if (comment)
-                    write_comment<Ptree>(stream, *comment, commentStart);
-
-                stream << it->first << Ch(' ') << Ch('=') << Ch(' ')
-                       << it->second.template get_value<
-                          std::basic_string<Ch> >()
-                       << Ch('\n');
+                if (comment != child.not_found())
+                    write_comment<Ptree>(out,
+                        property_tree::detail::string_data(
+                            comment->second, temp),
+                        commentStart);
+
+                out.put(it->first);
+                out.put(Ch(' '));
+                out.put(Ch('='));
+                out.put(Ch(' '));
+                out.put(property_tree::detail::string_data(child, temp));
+                out.put(Ch('\n'));
             }
         }
 
         template <typename Ptree>
-        void write_top_level_keys(std::basic_ostream<
-                                      typename Ptree::key_type::value_type
-                                  > &stream,
+        void write_top_level_keys(ini_output<typename Ptree::key_type::value_type> &out,
                                   const Ptree& pt,
                                   const typename Ptree::key_type& commentKey,
                                   const typename Ptree::key_type::value_type& commentStart)
         {
-            write_keys(stream, pt, false, commentKey, commentStart);
+            write_keys(out, pt, false, commentKey, commentStart);
         }
 
         template <typename Ptree>
-        void write_sections(std::basic_ostream<
-                                typename Ptree::key_type::value_type
-                            > &stream,
+        void write_sections(ini_output<typename Ptree::key_type::value_type> &out,
                             const Ptree& pt,
                             const typename Ptree::key_type& commentKey,
                             const typename Ptree::key_type::value_type& commentStart)
         {
-            typedef typename Ptree::key_type::value_type Ch;
-            typedef typename Ptree::key_type Str;
             for (typename Ptree::const_iterator it = pt.begin(), end = pt.end();
                  it != end; ++it)
             {
-                boost::optional<Str> comment = it->second.template get_optional<Str>(commentKey);
                 if (!it->second.empty()) {
                     check_dupes(it->second);
-                    if(!it->second.data().empty() && comment) // top_level_key with comment
-                        continue;
-                    if (!it->second.data().empty())
+                    if (!it->second.data().empty()) {
+                        // top_level_key with comment
+                        if (it->second.find(commentKey) != it->second.not_found())
+                            continue;
                         BOOST_PROPERTY_TREE_THROW(ini_parser_error(
                             "mixed data and children", "", 0));
+                    }
 
-                    write_keys(stream, it->second, true, commentKey, commentStart, it->first);
+                    write_keys(out, it->second, true, commentKey, commentStart, &it->first);
                 }
             }
         }
     }
 
-    /**
-     * Read INI from a the given stream and translate it to a property tree.
-     * @note Clears existing contents of property tree. In case of error
-     *       the property tree is not modified.
-     * @throw ini_parser_error If a format violation is found.
-     * @param stream Stream from which to read in the property tree.
-     * @param[out] pt The property tree to populate.
-     *
-     * Key comments will be stored in the propertyTree as a child of actual property
-     * in an additional entry \c key.inicomment (wie von comment_key() returned)
-     * Section comments will be stored in the propertyTree as a child of section first property
-     * in an additional entry \c key.inicomment_section (wie von section_comment_key() returned)
-     */
-    template<class Ptree>
-    void read_ini(std::basic_istream<
-                    typename Ptree::key_type::value_type> &stream,
-                  Ptree &pt)
+    namespace detail
     {
-        typedef typename Ptree::key_type Str;
-        typedef typename Str::value_type Ch;
-        const Ch semicolon = stream.widen(';');
-        const Ch hash = detail::comment_start_character<Ch>();
-        const Ch lbracket = stream.widen('[');
-        const Ch rbracket = stream.widen(']');
-        const Str commentKey = detail::comment_key<Str>();
-        const Str sectionCommentKey = detail::section_comment_key<Str>();
-
-        Ptree local;
-        unsigned long line_no = 0;
-        Ptree *section = 0;
-        Str line;
-        Str lastComment;
-        Str sectionComment;
-
-        // For all lines
-        while (stream.good())
+        // Whitespace as std::isspace has it, without asking the locale
+        // about ASCII characters.
+        template<class Ch>
+        bool is_ini_space(Ch c, const std::locale &loc)
         {
+            if (static_cast<unsigned long>(c) < 0x80)
+                return c == Ch(' ') || (c >= Ch('\t') && c <= Ch('\r'));
+            return std::isspace(c, loc);
+        }
 
-            // Get line from stream
-            ++line_no;
-            std::getline(stream, line);
-            if (!stream.good() && !stream.eof())
-                BOOST_PROPERTY_TREE_THROW(ini_parser_error(
-                    "read error", "", line_no));
+        template<class Ch>
+        void trim_ini(const Ch *&first, const Ch *&last,
+                      const std::locale &loc)
+        {
+            while (first != last && is_ini_space(*first, loc))
+                ++first;
+            while (last != first && is_ini_space(*(last - 1), loc))
+                --last;
+        }
 
-            // If line is non-empty
-            line = property_tree::detail::trim(line, stream.getloc());
-            if (!line.empty())
+        // Parse the INI text in [first, last). Lines are trimmed and split
+        // in place, so that each key, value and comment is built once.
+        template<class Ptree>
+        void read_ini_internal(const typename Ptree::key_type::value_type *first,
+                               const typename Ptree::key_type::value_type *last,
+                               Ptree &pt,
+                               const std::locale &loc)
+        {
+            typedef typename Ptree::key_type Str;
+            typedef typename Str::value_type Ch;
+            const Ch semicolon = Ch(';');
+            const Ch hash = comment_start_character<Ch>();
+            const Ch lbracket = Ch('[');
+            const Ch rbracket = Ch(']');
+            const Str commentKey = comment_key<Str>();
+            const Str sectionCommentKey = section_comment_key<Str>();
+
+            Ptree local(pt.get_allocator());
+            unsigned long line_no = 0;
+            Ptree *section = 0;
+            Str lastComment;
+            Str sectionComment;
+
+            // For all lines
+            for (const Ch *next = first; next != last; )
             {
+                ++line_no;
+                const Ch *begin = next;
+                const Ch *end = std::find(begin, last, Ch('\n'));
+                next = end == last ? last : end + 1;
+
+                // If line is non-empty
+                trim_ini(begin, end, loc);
+                if (begin == end)
+                    continue;
+
                 // Comment, section or key?
-                if (line[0] == semicolon || line[0] == hash)
+                if (*begin == semicolon || *begin == hash)
                 {
                     // Save comments to intermediate storage
                     if (!lastComment.empty())
                         lastComment += Ch('\n');
-                    lastComment += line.substr(1);
+                    lastComment.append(begin + 1, end);
                 }
-                else if (line[0] == lbracket)
+                else if (*begin == lbracket)
                 {
                     // If the previous section was empty, drop it again.
                     if (section && section->empty())
                         local.pop_back();
-                    typename Str::size_type end = line.find(rbracket);
-                    if (end == Str::npos)
+                    const Ch *close = std::find(begin, end, rbracket);
+                    if (close == end)
                         BOOST_PROPERTY_TREE_THROW(ini_parser_error(
                             "unmatched '['", "", line_no));
-                    Str key = property_tree::detail::trim(
-                        line.substr(1, end - 1), stream.getloc());
+                    const Ch *name = begin + 1;
+                    trim_ini(name, close, loc);
+                    Str key(name, close);
                     if (local.find(key) != local.not_found())
                         BOOST_PROPERTY_TREE_THROW(ini_parser_error(
                             "duplicate section name", "", line_no));
@@ -317,48 +355,104 @@ namespace boost { namespace property_tree { namespace ini_parser
                         std::make_pair(key, Ptree()))->second;
                     if (!lastComment.empty())
                     {
-                        sectionComment = lastComment;
+                        sectionComment.swap(lastComment);
                         lastComment.clear();
                     }
                 }
                 else
                 {
                     Ptree &container = section ? *section : local;
-                    typename Str::size_type eqpos = line.find(Ch('='));
-                    if (eqpos == Str::npos)
+                    const Ch *eq = std::find(begin, end, Ch('='));
+                    if (eq == end)
                         BOOST_PROPERTY_TREE_THROW(ini_parser_error(
                             "'=' character not found in line", "", line_no));
-                    if (eqpos == 0)
+                    if (eq == begin)
                         BOOST_PROPERTY_TREE_THROW(ini_parser_error(
                             "key expected", "", line_no));
-                    Str key = property_tree::detail::trim(
-                        line.substr(0, eqpos), stream.getloc());
-                    Str data = property_tree::detail::trim(
-                        line.substr(eqpos + 1, Str::npos), stream.getloc());
+                    const Ch *key_last = eq, *data_first = eq + 1;
+                    trim_ini(begin, key_last, loc);
+                    trim_ini(data_first, end, loc);
+                    Str key(begin, key_last);
                     if (container.find(key) != container.not_found())
                         BOOST_PROPERTY_TREE_THROW(ini_parser_error(
                             "duplicate key name", "", line_no));
-                    Ptree* keyTree = &container.push_back(std::make_pair(key, Ptree(data)))->second;
+                    Ptree *keyTree = &container.push_back(std::make_pair(
+                        key, Ptree(Str(data_first, end))))->second;
                     if (!lastComment.empty())
                     {
-                        keyTree->put(commentKey, lastComment);
+                        keyTree->push_back(std::make_pair(
+                            commentKey, Ptree(lastComment)));
                         lastComment.clear();
                     }
-                    if(!sectionComment.empty())
+                    if (!sectionComment.empty())
                     {
-                        keyTree->put(sectionCommentKey, sectionComment);
+                        keyTree->push_back(std::make_pair(
+                            sectionCommentKey, Ptree(sectionComment)));
                         sectionComment.clear();
                     }
                 }
             }
+            // If the last section was empty, drop it again.
+            if (section && section->empty())
+                local.pop_back();
+
+            // Swap local ptree with result ptree
+            pt.swap(local);
         }
-        // If the last section was empty, drop it again.
-        if (section && section->empty())
-            local.pop_back();
+    }
 
-        // Swap local ptree with result ptree
-        pt.swap(local);
+    /**
+     * Read INI from a the given stream and translate it to a property tree.
+     * The rest of the stream is read into memory in large blocks and
+     * parsed there.
+     * @note Clears existing contents of property tree. In case of error
+     *       the property tree is not modified.
+     * @throw ini_parser_error If a format violation is found.
+     * @param stream Stream from which to read in the property tree.
+     * @param[out] pt The property tree to populate.
+     *
+     * Key comments will be stored in the propertyTree as a child of actual property
+     * in an additional entry \c key.inicomment (wie von comment_key() returned)
+     * Section comments will be stored in the propertyTree as a child of section first property
+     * in an additional entry \c key.inicomment_section (wie von section_comment_key() returned)
+     */
+    template<class Ptree>
+    void read_ini(std::basic_istream<
+                    typename Ptree::key_type::value_type> &stream,
+                  Ptree &pt)
+    {
+        typedef typename Ptree::key_type::value_type Ch;
+        std::vector<Ch> text;
+        if (stream.good())
+        {
+            text.resize(property_tree::detail::read_stream(stream, text));
+            stream.setstate(std::ios_base::eofbit);
+            if (stream.bad())
+                BOOST_PROPERTY_TREE_THROW(ini_parser_error(
+                    "read error", "", 0));
+        }
+        const Ch *first = text.empty() ? 0 : &text.front();
+        detail::read_ini_internal(first, first + text.size(), pt,
+                                  stream.getloc());
+    }
 
+    /**
+     * Read INI from text in memory, such as a mapped file, and translate it
+     * to a property tree. See the overload for streams.
+     * @note Clears existing contents of property tree. In case of error
+     *       the property tree is not modified.
+     * @throw ini_parser_error If a format violation is found.
+     * @param first, last The INI text.
+     * @param[out] pt The property tree to populate.
+     * @param loc The locale that tells which characters are whitespace.
+     */
+    template<class Ptree>
+    void read_ini(const typename Ptree::key_type::value_type *first,
+                  const typename Ptree::key_type::value_type *last,
+                  Ptree &pt,
+                  const std::locale &loc = std::locale())
+    {
+        detail::read_ini_internal(first, last, pt, loc);
     }
 
     /**
@@ -393,6 +487,8 @@ namespace boost { namespace property_tree { namespace ini_parser
     /**
      * Translates the property tree to INI and writes it the given output
      * stream.
+     * @note The output is only written once the whole tree has been
+     *       translated, so that nothing is written in case of error.
      * @pre @e pt cannot have data in its root.
      * @pre @e pt cannot have keys both data and children.
      * @pre @e pt cannot be deeper than two levels.
@@ -423,8 +519,10 @@ namespace boost { namespace property_tree { namespace ini_parser
                 "ptree has data on root", "", 0));
         detail::check_dupes(pt);
 
-        detail::write_top_level_keys(stream, pt, commentKey, commentStart);
-        detail::write_sections(stream, pt, commentKey, commentStart);
+        detail::ini_output<typename Ptree::key_type::value_type> out(stream);
+        detail::write_top_level_keys(out, pt, commentKey, commentStart);
+        detail::write_sections(out, pt, commentKey, commentStart);
+        out.flush();
     }
 
     /**
@@ -0,0 +1,402 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_INTERNED_STRING_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_INTERNED_STRING_HPP_INCLUDED
+
+#include <boost/config.hpp>
+
+// The pool of interned strings is guarded by a std::mutex, so that this
+// header needs no compiled library.
+#ifdef BOOST_NO_CXX11_HDR_MUTEX
+#error "boost/property_tree/interned_string.hpp requires <mutex>"
+#endif
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/optional.hpp>
+#include <boost/unordered_map.hpp>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <mutex>
+
+namespace boost { namespace property_tree
+{
+
+    namespace detail
+    {
+        typedef std::mutex intern_mutex;
+        typedef std::lock_guard<std::mutex> intern_lock;
+
+        // The strings that interned strings point to. Strings are added
+        // on first use and kept for the life of the program, so that a
+        // string's address identifies its contents.
+        template <typename Ch, typename Traits>
+        class intern_pool
+        {
+        public:
+            typedef std::basic_string<Ch, Traits> string_type;
+
+            static intern_pool &instance() {
+                static intern_pool pool;
+                return pool;
+            }
+
+            // The pooled copy of [first, last), added if it is new.
+            const string_type *intern(const Ch *first, const Ch *last) {
+                intern_lock lock(m_mutex);
+                typename strings::iterator it = m_strings.find(
+                    impl::fragment<Ch>(first, last),
+                    impl::fragment_hash<Ch>(),
+                    impl::fragment_equal<Ch, Traits>());
+                if (it == m_strings.end()) {
+                    it = m_strings.insert(string_type(first, last)).first;
+                }
+                return &*it;
+            }
+
+            // The pooled copy of [first, last), if there is one.
+            const string_type *find(const Ch *first, const Ch *last) {
+                intern_lock lock(m_mutex);
+                typename strings::iterator it = m_strings.find(
+                    impl::fragment<Ch>(first, last),
+                    impl::fragment_hash<Ch>(),
+                    impl::fragment_equal<Ch, Traits>());
+                return it == m_strings.end() ? 0 : &*it;
+            }
+
+            std::size_t size() {
+                intern_lock lock(m_mutex);
+                return m_strings.size();
+            }
+
+        private:
+            typedef multi_index_container<string_type,
+                multi_index::indexed_by<
+                    multi_index::hashed_unique<
+                        multi_index::identity<string_type> >
+                >
+            > strings;
+
+            intern_pool() {}
+            intern_pool(const intern_pool &);
+            intern_pool &operator =(const intern_pool &);
+
+            strings m_strings;
+            intern_mutex m_mutex;
+        };
+    }
+
+    /**
+     * An immutable string that is stored once per program, in a pool shared
+     * by all interned strings of its type. It is the size of a pointer, and
+     * copying or comparing two interned strings for equality only copies or
+     * compares the pointers.
+     *
+     * As the key type of a basic_ptree, it stores each distinct key once
+     * however many nodes use it, and the library's parsers intern keys as
+     * they read them. The pool is never emptied, so this suits trees with a
+     * limited set of keys repeated over many nodes, as in arrays of JSON
+     * objects, rather than trees whose keys are themselves data.
+     */
+    template <typename Ch, typename Traits>
+    class basic_interned_string
+    {
+        typedef detail::intern_pool<Ch, Traits> pool_type;
+    public:
+        typedef std::basic_string<Ch, Traits> string_type;
+        typedef Ch value_type;
+        typedef Traits traits_type;
+        typedef typename string_type::size_type size_type;
+        typedef typename string_type::const_iterator const_iterator;
+        typedef const_iterator iterator;
+        BOOST_STATIC_CONSTANT(size_type, npos = string_type::npos);
+
+        /// The empty string. Not stored in the pool.
+        basic_interned_string() : m_string(0) {}
+
+        basic_interned_string(const string_type &s)
+            : m_string(intern(s.data(), s.data() + s.size())) {}
+
+        basic_interned_string(const Ch *s)
+            : m_string(intern(s, s + Traits::length(s))) {}
+
+        template <typename It>
+        basic_interned_string(It first, It last) : m_string(0) {
+            string_type s(first, last);
+            m_string = intern(s.data(), s.data() + s.size());
+        }
+
+        basic_interned_string(const Ch *first, const Ch *last)
+            : m_string(intern(first, last)) {}
+
+        basic_interned_string(const Ch *s, size_type n)
+            : m_string(intern(s, s + n)) {}
+
+        /**
+         * The interned string equal to [first, last), if the pool has one.
+         * Unlike the constructors, this never adds to the pool; a string
+         * that is not in it cannot be the key of any node.
+         */
+        static optional<basic_interned_string> lookup(const Ch *first,
+                                                      const Ch *last) {
+            if (first == last) {
+                return basic_interned_string();
+            }
+            if (const string_type *s =
+                    pool_type::instance().find(first, last)) {
+                return basic_interned_string(s);
+            }
+            return optional<basic_interned_string>();
+        }
+
+        /// The number of distinct strings interned so far.
+        static std::size_t pool_size() {
+            return pool_type::instance().size();
+        }
+
+        /// The pooled string.
+        const string_type &str() const {
+            return m_string ? *m_string : empty_string();
+        }
+        operator const string_type &() const { return str(); }
+
+        const Ch *data() const { return str().data(); }
+        const Ch *c_str() const { return str().c_str(); }
+        size_type size() const { return m_string ? m_string->size() : 0; }
+        size_type length() const { return size(); }
+        bool empty() const { return size() == 0; }
+        const_iterator begin() const { return str().begin(); }
+        const_iterator end() const { return str().end(); }
+        const Ch &operator [](size_type i) const { return str()[i]; }
+
+        int compare(const basic_interned_string &o) const {
+            return m_string == o.m_string ? 0 : str().compare(o.str());
+        }
+
+        void swap(basic_interned_string &o) {
+            const string_type *t = m_string;
+            m_string = o.m_string;
+            o.m_string = t;
+        }
+
+        friend bool operator ==(const basic_interned_string &a,
+                                const basic_interned_string &b) {
+            return a.m_string == b.m_string;
+        }
+        friend bool operator !=(const basic_interned_string &a,
+                                const basic_interned_string &b) {
+            return a.m_string != b.m_string;
+        }
+        friend bool operator <(const basic_interned_string &a,
+                               const basic_interned_string &b) {
+            return a.m_string != b.m_string && a.str() < b.str();
+        }
+        friend bool operator >(const basic_interned_string &a,
+                               const basic_interned_string &b) {
+            return b < a;
+        }
+        friend bool operator <=(const basic_interned_string &a,
+                                const basic_interned_string &b) {
+            return !(b < a);
+        }
+        friend bool operator >=(const basic_interned_string &a,
+                                const basic_interned_string &b) {
+            return !(a < b);
+        }
+
+        // Comparisons with plain strings look at the characters, and do
+        // not intern the other string.
+        friend bool operator ==(const basic_interned_string &a,
+                                const string_type &b) {
+            return a.str() == b;
+        }
+        friend bool operator ==(const string_type &a,
+                                const basic_interned_string &b) {
+            return a == b.str();
+        }
+        friend bool operator !=(const basic_interned_string &a,
+                                const string_type &b) {
+            return a.str() != b;
+        }
+        friend bool operator !=(const string_type &a,
+                                const basic_interned_string &b) {
+            return a != b.str();
+        }
+        friend bool operator ==(const basic_interned_string &a,
+                                const Ch *b) {
+            return a.str() == b;
+        }
+        friend bool operator !=(const basic_interned_string &a,
+                                const Ch *b) {
+            return a.str() != b;
+        }
+
+        /// Hashes the address, which identifies the contents.
+        friend std::size_t hash_value(const basic_interned_string &s) {
+            return boost::hash<const void *>()(s.m_string);
+        }
+
+        friend std::basic_ostream<Ch, Traits> &operator <<(
+            std::basic_ostream<Ch, Traits> &stream,
+            const basic_interned_string &s) {
+            return stream << s.str();
+        }
+
+    private:
+        explicit basic_interned_string(const string_type *s)
+            : m_string(s) {}
+
+        static const string_type *intern(const Ch *first, const Ch *last) {
+            return first == last ? 0
+                : pool_type::instance().intern(first, last);
+        }
+
+        static const string_type &empty_string() {
+            static const string_type empty;
+            return empty;
+        }
+
+        const string_type *m_string;
+    };
+
+    template <typename Ch, typename Traits>
+    inline void swap(basic_interned_string<Ch, Traits> &a,
+                     basic_interned_string<Ch, Traits> &b)
+    {
+        a.swap(b);
+    }
+
+    /// Translates the fragments of a string path to interned keys.
+    template <typename Ch, typename Traits>
+    struct interning_translator
+    {
+        typedef std::basic_string<Ch, Traits> internal_type;
+        typedef basic_interned_string<Ch, Traits> external_type;
+
+        boost::optional<external_type> get_value(const internal_type &v) {
+            return external_type(v);
+        }
+        boost::optional<internal_type> put_value(const external_type &v) {
+            return v.str();
+        }
+    };
+
+    template <typename Ch, typename Traits>
+    struct path_of< basic_interned_string<Ch, Traits> >
+    {
+        typedef std::basic_string<Ch, Traits> _string;
+        typedef string_path< _string, interning_translator<Ch, Traits> >
+            type;
+    };
+
+    namespace detail
+    {
+        template <typename Ch, typename Traits>
+        struct key_string< basic_interned_string<Ch, Traits> >
+        {
+            typedef std::basic_string<Ch, Traits> type;
+        };
+
+        // Parsers look each key up here first, so that they take the
+        // pool's lock once per distinct key of a document, not once per
+        // node.
+        template <typename Ch, typename Traits>
+        class key_maker< basic_interned_string<Ch, Traits> >
+        {
+            typedef basic_interned_string<Ch, Traits> key_type;
+            typedef std::basic_string<Ch, Traits> string_type;
+        public:
+            const key_type &operator()(const string_type &s) {
+                return make(s.data(), s.data() + s.size());
+            }
+            const key_type &operator()(const Ch *s, std::size_t n) {
+                return make(s, s + n);
+            }
+
+        private:
+            const key_type &make(const Ch *first, const Ch *last) {
+                typename cache::iterator it = m_keys.find(
+                    impl::fragment<Ch>(first, last),
+                    impl::fragment_hash<Ch>(),
+                    impl::fragment_equal<Ch, Traits>());
+                if (it == m_keys.end()) {
+                    it = m_keys.insert(std::make_pair(
+                        string_type(first, last),
+                        key_type(first, last))).first;
+                }
+                return it->second;
+            }
+
+            typedef boost::unordered_map<string_type, key_type> cache;
+            cache m_keys;
+        };
+    }
+
+    namespace impl
+    {
+        // Looking a path fragment up in the pool tells whether any key can
+        // match it, without adding it to the pool.
+        template <typename Ch, typename Traits>
+        struct interned_fragment_lookup
+        {
+            template <typename Index, typename Path>
+            static typename Index::iterator find(const Index &i, Path &p) {
+                std::pair<const Ch *, const Ch *> r = p.reduce_range();
+                if (optional<basic_interned_string<Ch, Traits> > key =
+                        basic_interned_string<Ch, Traits>::lookup(
+                            r.first, r.second)) {
+                    return i.find(*key);
+                }
+                return i.end();
+            }
+        };
+
+        template <typename Ch, typename Traits>
+        struct fragment_lookup<
+            string_path<std::basic_string<Ch, Traits>,
+                        interning_translator<Ch, Traits> >,
+            std::less<basic_interned_string<Ch, Traits> > >
+            : interned_fragment_lookup<Ch, Traits>
+        {};
+
+        template <typename Ch, typename Traits>
+        struct fragment_lookup<
+            string_path<std::basic_string<Ch, Traits>,
+                        interning_translator<Ch, Traits> >,
+            hashed_key<basic_interned_string<Ch, Traits>,
+                       boost::hash<basic_interned_string<Ch, Traits> >,
+                       std::equal_to<basic_interned_string<Ch, Traits> > > >
+            : interned_fragment_lookup<Ch, Traits>
+        {};
+    }
+
+    typedef basic_interned_string<char> interned_string;
+
+    /**
+     * A property tree with interned keys and std::string data. Each
+     * distinct key is stored once, and nodes hold a pointer to it.
+     */
+    typedef basic_ptree<interned_string, std::string> interned_ptree;
+
+#ifndef BOOST_NO_STD_WSTRING
+    typedef basic_interned_string<wchar_t> winterned_string;
+
+    /**
+     * Like interned_ptree, but with wide strings.
+     * @note The type only exists if the platform supports @c wchar_t.
+     */
+    typedef basic_ptree<winterned_string, std::wstring> winterned_ptree;
+#endif
+
+} }
+
+#endif
@@ -13,6 +13,8 @@
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser/error.hpp>
+#include <boost/property_tree/json_parser/sax.hpp>
+#include <boost/property_tree/json_parser/incremental_reader.hpp>
 #include <boost/property_tree/json_parser/detail/read.hpp>
 #include <boost/property_tree/json_parser/detail/write.hpp>
 
@@ -46,6 +48,25 @@ namespace boost { namespace property_tree { namespace json_parser
         detail::read_json_internal(stream, pt, std::string());
     }
 
+    /**
+     * Read JSON from the characters in [first, last) and translate it to a
+     * property tree. This is the fastest way to parse a document that is
+     * already in memory.
+     * @note Clears existing contents of property tree.  In case of error the
+     *       property tree unmodified.
+     * @throw json_parser_error In case of error deserializing the property
+     *                          tree.
+     * @param first, last The characters to parse.
+     * @param[out] pt The property tree to populate.
+     */
+    template<class Ptree>
+    void read_json(const typename Ptree::key_type::value_type *first,
+                   const typename Ptree::key_type::value_type *last,
+                   Ptree &pt)
+    {
+        detail::read_json_internal(first, last, pt, std::string());
+    }
+
     /**
      * Read JSON from a the given file and translate it to a property tree.
      * @note Clears existing contents of property tree.  In case of error the
@@ -0,0 +1,587 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_DETAIL_JSON_PARSER_INCREMENTAL_PARSER_HPP
+#define BOOST_PROPERTY_TREE_DETAIL_JSON_PARSER_INCREMENTAL_PARSER_HPP
+
+#include <boost/property_tree/json_parser/error.hpp>
+#include <boost/property_tree/json_parser/detail/scanner.hpp>
+
+#include <boost/core/ref.hpp>
+#include <boost/bind/bind.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace boost { namespace property_tree {
+    namespace json_parser { namespace detail
+{
+
+    // The same grammar and callbacks as parser, but driven by the input
+    // instead of pulling it: the position in the grammar is kept in
+    // explicit state, so that input can be given in chunks of any size.
+    // Errors are reported with the same messages and lines as parser.
+    template <typename Callbacks, typename Encoding>
+    class incremental_parser
+    {
+        typedef typename Encoding::external_char code_unit;
+        typedef bool (Encoding::*encoding_predicate)(code_unit c) const;
+        typedef detail::scanner<Encoding, const code_unit*> scanner;
+
+    public:
+        incremental_parser(Callbacks& callbacks, Encoding& encoding,
+                           const std::string& filename)
+            : callbacks(callbacks), encoding(encoding), filename(filename)
+        {
+            reset();
+        }
+
+        // Get ready for a new document.
+        void reset() {
+            st = start;
+            line = 1;
+            levels.clear();
+            carry.clear();
+            high = 0;
+            number_continued = false;
+        }
+
+        void feed(const code_unit* first, const code_unit* last) {
+            // Complete the code point the last chunk ended in.
+            while (!carry.empty() && first != last) {
+                carry += *first++;
+                const code_unit* data = carry.data();
+                carry.erase(0,
+                    step(data, data + carry.size(), false) - data);
+            }
+            if (carry.empty()) {
+                carry.assign(step(first, last, false), last);
+            }
+        }
+
+        void finish() {
+            const code_unit* data = carry.data();
+            step(data, data + carry.size(), true);
+            carry.clear();
+            for (;;) {
+                switch (st) {
+                case done:
+                    return;
+                case number_zero:
+                case number_int:
+                case number_frac:
+                case number_exp:
+                    // Handed over digit by digit at the end of the last step.
+                    number_continued = false;
+                    callbacks.on_end_number();
+                    value_done();
+                    break;
+                default:
+                    parse_error(eof_message());
+                }
+            }
+        }
+
+    private:
+        enum state {
+            start,
+            value,
+            done,
+            array_first, array_next,
+            object_first, object_key, object_colon, object_next,
+            literal,
+            number_minus, number_zero, number_int, number_frac_first,
+            number_frac, number_exp_sign, number_exp_first, number_exp,
+            string_chars, string_escape, string_hex,
+            string_low_backslash, string_low_u
+        };
+        enum level { array_level, object_level };
+
+        // Enough code units for any code point, and for the byte order
+        // mark.
+        static const std::ptrdiff_t lookahead = 4;
+
+        void parse_error(const char* msg) {
+            BOOST_PROPERTY_TREE_THROW(json_parser_error(msg, filename, line));
+        }
+
+        const char* eof_message() const {
+            switch (st) {
+            case array_next: return "expected ']' or ','";
+            case object_first:
+            case object_key: return "expected key string";
+            case object_colon: return "expected ':'";
+            case object_next: return "expected '}' or ','";
+            case literal: return literal_message;
+            case number_minus: return "expected digits after -";
+            case number_frac_first: return "need at least one digit after '.'";
+            case number_exp_sign:
+            case number_exp_first: return "need at least one digit in exponent";
+            case string_chars: return "unterminated string";
+            case string_escape:
+            case string_hex: return "invalid escape sequence";
+            case string_low_backslash:
+                return "invalid codepoint, stray high surrogate";
+            case string_low_u:
+                return "expected codepoint reference after high surrogate";
+            default: return "expected value";
+            }
+        }
+
+        bool is(encoding_predicate p, code_unit c) const {
+            return (encoding.*p)(c);
+        }
+
+        void value_done() {
+            if (levels.empty()) {
+                st = done;
+            } else if (levels.back() == array_level) {
+                st = array_next;
+            } else {
+                st = object_next;
+            }
+        }
+
+        void begin_literal(const encoding_predicate* rest, int length,
+                           const char* message, int kind) {
+            literal_rest = rest;
+            literal_left = length;
+            literal_message = message;
+            literal_kind = kind;
+            st = literal;
+        }
+
+        void end_literal() {
+            switch (literal_kind) {
+            case 0: callbacks.on_null(); break;
+            case 1: callbacks.on_boolean(true); break;
+            default: callbacks.on_boolean(false); break;
+            }
+            value_done();
+        }
+
+        bool in_number() const {
+            return st >= number_minus && st <= number_exp;
+        }
+
+        void begin_number(const code_unit* p, state s) {
+            number_begin = p;
+            number_continued = false;
+            st = s;
+        }
+
+        void number_unit(code_unit c) {
+            if (number_continued) {
+                callbacks.on_digit(encoding.to_internal_trivial(c));
+            }
+        }
+
+        void end_number(const code_unit* p) {
+            if (number_continued) {
+                callbacks.on_end_number();
+            } else {
+                callbacks.on_number(encoding.to_internal(number_begin, p));
+            }
+            number_continued = false;
+            value_done();
+        }
+
+        void begin_string(bool key) {
+            callbacks.on_begin_string();
+            in_key = key;
+            st = string_chars;
+        }
+
+        void end_string() {
+            callbacks.on_end_string();
+            if (in_key) {
+                st = object_colon;
+            } else {
+                value_done();
+            }
+        }
+
+        void flush_run(const code_unit* p) {
+            if (run_begin != p) {
+                callbacks.on_code_units(encoding.to_internal(run_begin, p));
+            }
+        }
+
+        void feed_codepoint(unsigned codepoint) {
+            encoding.feed_codepoint(codepoint,
+                                    boost::bind(&Callbacks::on_code_unit,
+                                                boost::ref(callbacks),
+                                                boost::placeholders::_1));
+        }
+
+        static bool is_surrogate_high(unsigned codepoint) {
+            return (codepoint & 0xfc00) == 0xd800;
+        }
+        static bool is_surrogate_low(unsigned codepoint) {
+            return (codepoint & 0xfc00) == 0xdc00;
+        }
+        static unsigned combine_surrogates(unsigned high, unsigned low) {
+            return 0x010000 + (((high & 0x3ff) << 10) | (low & 0x3ff));
+        }
+
+        // Start the value that c begins.
+        void start_value(const code_unit*& p, code_unit c) {
+            static const encoding_predicate null_rest[] =
+                { &Encoding::is_u, &Encoding::is_l, &Encoding::is_l };
+            static const encoding_predicate true_rest[] =
+                { &Encoding::is_r, &Encoding::is_u, &Encoding::is_e };
+            static const encoding_predicate false_rest[] =
+                { &Encoding::is_a, &Encoding::is_l, &Encoding::is_s,
+                  &Encoding::is_e };
+            if (is(&Encoding::is_open_brace, c)) {
+                callbacks.on_begin_object();
+                levels.push_back(object_level);
+                st = object_first;
+            } else if (is(&Encoding::is_open_bracket, c)) {
+                callbacks.on_begin_array();
+                levels.push_back(array_level);
+                st = array_first;
+            } else if (is(&Encoding::is_quote, c)) {
+                begin_string(false);
+                run_begin = p + 1;
+            } else if (is(&Encoding::is_t, c)) {
+                begin_literal(true_rest, 3, "expected 'true'", 1);
+            } else if (is(&Encoding::is_f, c)) {
+                begin_literal(false_rest, 4, "expected 'false'", 2);
+            } else if (is(&Encoding::is_n, c)) {
+                begin_literal(null_rest, 3, "expected 'null'", 0);
+            } else if (is(&Encoding::is_minus, c)) {
+                begin_number(p, number_minus);
+            } else if (is(&Encoding::is_0, c)) {
+                begin_number(p, number_zero);
+            } else if (is(&Encoding::is_digit0, c)) {
+                begin_number(p, number_int);
+            } else {
+                parse_error("expected value");
+            }
+            ++p;
+        }
+
+        // Consume what can be consumed of [p, last). This only stops short
+        // inside a string, where a code point may continue in the next
+        // chunk, unless eof says there is none.
+        const code_unit* step(const code_unit* p, const code_unit* last,
+                              bool eof) {
+            run_begin = p;
+            while (p != last) {
+                const code_unit c = *p;
+                switch (st) {
+                case start:
+                    if (last - p < lookahead && !eof) {
+                        return p;
+                    }
+                    encoding.skip_introduction(p, last);
+                    st = value;
+                    continue;
+
+                case value:
+                case done:
+                case array_first:
+                case array_next:
+                case object_first:
+                case object_key:
+                case object_colon:
+                case object_next:
+                    if (is(&Encoding::is_ws, c)) {
+                        if (is(&Encoding::is_nl, c)) {
+                            ++line;
+                        }
+                        ++p;
+                        continue;
+                    }
+                    break;
+
+                default:
+                    break;
+                }
+
+                switch (st) {
+                case value:
+                    start_value(p, c);
+                    break;
+                case done:
+                    parse_error("garbage after data");
+                    break;
+                case array_first:
+                    if (is(&Encoding::is_close_bracket, c)) {
+                        ++p;
+                        levels.pop_back();
+                        callbacks.on_end_array();
+                        value_done();
+                    } else {
+                        st = value;
+                    }
+                    break;
+                case array_next:
+                    if (is(&Encoding::is_comma, c)) {
+                        ++p;
+                        st = value;
+                    } else if (is(&Encoding::is_close_bracket, c)) {
+                        ++p;
+                        levels.pop_back();
+                        callbacks.on_end_array();
+                        value_done();
+                    } else {
+                        parse_error("expected ']' or ','");
+                    }
+                    break;
+                case object_first:
+                    if (is(&Encoding::is_close_brace, c)) {
+                        ++p;
+                        levels.pop_back();
+                        callbacks.on_end_object();
+                        value_done();
+                    } else {
+                        st = object_key;
+                    }
+                    break;
+                case object_key:
+                    if (!is(&Encoding::is_quote, c)) {
+                        parse_error("expected key string");
+                    }
+                    ++p;
+                    begin_string(true);
+                    run_begin = p;
+                    break;
+                case object_colon:
+                    if (!is(&Encoding::is_colon, c)) {
+                        parse_error("expected ':'");
+                    }
+                    ++p;
+                    st = value;
+                    break;
+                case object_next:
+                    if (is(&Encoding::is_comma, c)) {
+                        ++p;
+                        st = object_key;
+                    } else if (is(&Encoding::is_close_brace, c)) {
+                        ++p;
+                        levels.pop_back();
+                        callbacks.on_end_object();
+                        value_done();
+                    } else {
+                        parse_error("expected '}' or ','");
+                    }
+                    break;
+
+                case literal:
+                    if (!is(*literal_rest, c)) {
+                        parse_error(literal_message);
+                    }
+                    ++p;
+                    ++literal_rest;
+                    if (--literal_left == 0) {
+                        end_literal();
+                    }
+                    break;
+
+                case number_minus:
+                    if (is(&Encoding::is_0, c)) {
+                        st = number_zero;
+                    } else if (is(&Encoding::is_digit0, c)) {
+                        st = number_int;
+                    } else {
+                        parse_error("expected digits after -");
+                    }
+                    number_unit(c);
+                    ++p;
+                    break;
+                case number_zero:
+                case number_int:
+                case number_frac:
+                    if (st != number_zero && is(&Encoding::is_digit, c)) {
+                        // Stay.
+                    } else if (st != number_frac && is(&Encoding::is_dot, c)) {
+                        st = number_frac_first;
+                    } else if (is(&Encoding::is_eE, c)) {
+                        st = number_exp_sign;
+                    } else {
+                        end_number(p);
+                        break;
+                    }
+                    number_unit(c);
+                    ++p;
+                    break;
+                case number_frac_first:
+                    if (!is(&Encoding::is_digit, c)) {
+                        parse_error("need at least one digit after '.'");
+                    }
+                    st = number_frac;
+                    number_unit(c);
+                    ++p;
+                    break;
+                case number_exp_sign:
+                case number_exp_first:
+                    if (st == number_exp_sign &&
+                        is(&Encoding::is_plusminus, c)) {
+                        st = number_exp_first;
+                    } else if (is(&Encoding::is_digit, c)) {
+                        st = number_exp;
+                    } else {
+                        parse_error("need at least one digit in exponent");
+                    }
+                    number_unit(c);
+                    ++p;
+                    break;
+                case number_exp:
+                    if (!is(&Encoding::is_digit, c)) {
+                        end_number(p);
+                        break;
+                    }
+                    number_unit(c);
+                    ++p;
+                    break;
+
+                case string_chars:
+                    scanner::skip_string_chars(p, last);
+                    if (p == last) {
+                        break;
+                    }
+                    if (is(&Encoding::is_quote, *p)) {
+                        flush_run(p);
+                        ++p;
+                        end_string();
+                    } else if (is(&Encoding::is_backslash, *p)) {
+                        flush_run(p);
+                        ++p;
+                        st = string_escape;
+                    } else {
+                        if (last - p < lookahead && !eof) {
+                            flush_run(p);
+                            return p;
+                        }
+                        encoding.skip_codepoint(p, last,
+                            boost::bind(&incremental_parser::parse_error,
+                                        this, "invalid code sequence"));
+                    }
+                    break;
+                case string_escape:
+                    if (is(&Encoding::is_quote, c)) {
+                        feed_codepoint(0x22);
+                    } else if (is(&Encoding::is_backslash, c)) {
+                        feed_codepoint(0x5c);
+                    } else if (is(&Encoding::is_slash, c)) {
+                        feed_codepoint(0x2f);
+                    } else if (is(&Encoding::is_b, c)) {
+                        feed_codepoint(0x08); // backspace
+                    } else if (is(&Encoding::is_f, c)) {
+                        feed_codepoint(0x0c); // formfeed
+                    } else if (is(&Encoding::is_n, c)) {
+                        feed_codepoint(0x0a); // line feed
+                    } else if (is(&Encoding::is_r, c)) {
+                        feed_codepoint(0x0d); // carriage return
+                    } else if (is(&Encoding::is_t, c)) {
+                        feed_codepoint(0x09); // horizontal tab
+                    } else if (is(&Encoding::is_u, c)) {
+                        st = string_hex;
+                        hex_digits = 0;
+                        codepoint = 0;
+                        ++p;
+                        break;
+                    } else {
+                        parse_error("invalid escape sequence");
+                    }
+                    ++p;
+                    st = string_chars;
+                    run_begin = p;
+                    break;
+                case string_hex: {
+                    int digit = encoding.decode_hexdigit(c);
+                    if (digit < 0) {
+                        parse_error("invalid escape sequence");
+                    }
+                    ++p;
+                    codepoint = codepoint * 16 + digit;
+                    if (++hex_digits < 4) {
+                        break;
+                    }
+                    if (high) {
+                        if (!is_surrogate_low(codepoint)) {
+                            parse_error(
+                                "expected low surrogate after high surrogate");
+                        }
+                        codepoint = combine_surrogates(high, codepoint);
+                        high = 0;
+                    } else if (is_surrogate_low(codepoint)) {
+                        parse_error("invalid codepoint, stray low surrogate");
+                    } else if (is_surrogate_high(codepoint)) {
+                        high = codepoint;
+                        st = string_low_backslash;
+                        break;
+                    }
+                    feed_codepoint(codepoint);
+                    st = string_chars;
+                    run_begin = p;
+                    break;
+                }
+                case string_low_backslash:
+                    if (!is(&Encoding::is_backslash, c)) {
+                        parse_error("invalid codepoint, stray high surrogate");
+                    }
+                    ++p;
+                    st = string_low_u;
+                    break;
+                case string_low_u:
+                    if (!is(&Encoding::is_u, c)) {
+                        parse_error(
+                            "expected codepoint reference after high surrogate");
+                    }
+                    ++p;
+                    st = string_hex;
+                    hex_digits = 0;
+                    codepoint = 0;
+                    break;
+                default:
+                    break;
+                }
+            }
+            // The chunk goes away; hand over what is pending.
+            if (st == string_chars) {
+                flush_run(p);
+            } else if (in_number() && !number_continued) {
+                callbacks.on_begin_number();
+                for (; number_begin != p; ++number_begin) {
+                    callbacks.on_digit(
+                        encoding.to_internal_trivial(*number_begin));
+                }
+                number_continued = true;
+            }
+            return p;
+        }
+
+        Callbacks& callbacks;
+        Encoding& encoding;
+        std::string filename;
+        state st;
+        int line;
+        std::vector<level> levels;
+        // Code units at the end of a chunk that could not be consumed yet.
+        std::basic_string<code_unit> carry;
+        // Within the current chunk: where the string run or number began.
+        const code_unit* run_begin;
+        const code_unit* number_begin;
+        // The number started in an earlier chunk, and goes digit by digit.
+        bool number_continued;
+        bool in_key;
+        const encoding_predicate* literal_rest;
+        int literal_left;
+        const char* literal_message;
+        int literal_kind;
+        int hex_digits;
+        unsigned codepoint;
+        unsigned high;
+    };
+
+}}}}
+
+#endif
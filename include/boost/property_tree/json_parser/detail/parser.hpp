@@ -2,6 +2,7 @@
 #define BOOST_PROPERTY_TREE_DETAIL_JSON_PARSER_PARSER_HPP
 
 #include <boost/property_tree/json_parser/error.hpp>
+#include <boost/property_tree/json_parser/detail/scanner.hpp>
 
 #include <boost/core/ref.hpp>
 #include <boost/bind/bind.hpp>
@@ -36,24 +37,19 @@ namespace boost { namespace property_tree {
             // there's trouble.
             // However, no valid JSON file can start with a UTF-8 EF byte.
             encoding.skip_introduction(cur, end);
+            first = cur;
             line = 1;
-            offset = 0;
         }
 
         bool done() const { return cur == end; }
 
         void parse_error(const char* msg) {
             BOOST_PROPERTY_TREE_THROW(
-                json_parser_error(msg, filename, line));
+                json_parser_error(msg, filename, current_line(category())));
         }
 
         void next() {
-            if (encoding.is_nl(*cur)) {
-                ++line;
-                offset = 0;
-            } else {
-                ++offset;
-            }
+            count_line(category());
             ++cur;
         }
 
@@ -95,16 +91,40 @@ namespace boost { namespace property_tree {
         Sentinel raw_end() { return end; }
 
     private:
+        typedef typename std::iterator_traits<Iterator>::iterator_category
+            category;
+
         struct DoNothing {
             void operator ()(code_unit) const {}
         };
 
+        // Single-pass input has its lines counted as it goes. Other input
+        // is only counted when an error needs the line number, so that the
+        // parser may skip ahead without looking for newlines.
+        void count_line(std::input_iterator_tag) {
+            if (encoding.is_nl(*cur)) {
+                ++line;
+            }
+        }
+        void count_line(std::forward_iterator_tag) {}
+
+        int current_line(std::input_iterator_tag) const { return line; }
+        int current_line(std::forward_iterator_tag) const {
+            int n = 1;
+            for (Iterator it = first; it != cur; ++it) {
+                if (encoding.is_nl(*it)) {
+                    ++n;
+                }
+            }
+            return n;
+        }
+
         Encoding& encoding;
+        Iterator first;
         Iterator cur;
         Sentinel end;
         std::string filename;
         int line;
-        int offset;
     };
 
     template <typename Callbacks, typename Encoding, typename Iterator,
@@ -235,6 +255,7 @@ namespace boost { namespace property_tree {
         typedef detail::string_callback_adapter<Callbacks, Encoding, Iterator>
             string_adapter;
         typedef detail::source<Encoding, Iterator, Sentinel> source;
+        typedef detail::scanner<Encoding, Iterator> scanner;
         typedef typename source::code_unit code_unit;
 
     public:
@@ -325,6 +346,7 @@ namespace boost { namespace property_tree {
 
             callbacks.on_begin_string();
             string_adapter adapter(callbacks, encoding, src.raw_cur());
+            scanner::skip_string_chars(src.raw_cur(), src.raw_end());
             while (!encoding.is_quote(need_cur("unterminated string"))) {
                 if (encoding.is_backslash(*src.raw_cur())) {
                     adapter.finish_run();
@@ -333,9 +355,10 @@ namespace boost { namespace property_tree {
                     adapter.start_run();
                 } else {
                     adapter.process_codepoint(src.raw_end(),
-                        boost::bind(&parser::parse_error,
-                                    this, "invalid code sequence"));
+                        boost::bind(&parser::codepoint_error,
+                                    this, src.raw_cur()));
                 }
+                scanner::skip_string_chars(src.raw_cur(), src.raw_end());
             }
             adapter.finish_run();
             callbacks.on_end_string();
@@ -396,6 +419,12 @@ namespace boost { namespace property_tree {
         typedef typename source::encoding_predicate encoding_predicate;
 
         void parse_error(const char* msg) { src.parse_error(msg); }
+        // The encoding has moved on by the time it finds an error; report
+        // it where the code point started.
+        void codepoint_error(Iterator start) {
+            src.raw_cur() = start;
+            parse_error("invalid code sequence");
+        }
         void next() { src.next(); }
         template <typename Action>
         bool have(encoding_predicate p, Action& a) { return src.have(p, a); }
@@ -410,6 +439,7 @@ namespace boost { namespace property_tree {
         code_unit need_cur(const char* msg) { return src.need_cur(msg); }
 
         void skip_ws() {
+            scanner::skip_ws(src.raw_cur(), src.raw_end());
             while (have(&Encoding::is_ws)) {
             }
         }
@@ -442,6 +472,7 @@ namespace boost { namespace property_tree {
         }
 
         void parse_digits(number_adapter& action) {
+            scanner::skip_digits(src.raw_cur(), src.raw_end());
             while (have(&Encoding::is_digit, action)) {
             }
         }
@@ -14,12 +14,15 @@
 #include <boost/property_tree/json_parser/detail/narrow_encoding.hpp>
 #include <boost/property_tree/json_parser/detail/wide_encoding.hpp>
 #include <boost/property_tree/json_parser/detail/standard_callbacks.hpp>
+#include <boost/property_tree/detail/parser_io.hpp>
 
 #include <boost/static_assert.hpp>
 #include <boost/type_traits/is_same.hpp>
 
+#include <cstddef>
 #include <istream>
 #include <iterator>
+#include <streambuf>
 #include <string>
 
 namespace boost { namespace property_tree {
@@ -69,22 +72,43 @@ namespace boost { namespace property_tree {
     template <> struct encoding<char> : utf8_utf8_encoding {};
     template <> struct encoding<wchar_t> : wide_wide_encoding {};
 
+    // Parsing from contiguous memory lets the callbacks receive numbers and
+    // runs of string characters in one piece.
     template <typename Ptree>
     void read_json_internal(
-        std::basic_istream<typename Ptree::key_type::value_type> &stream,
+        const typename Ptree::key_type::value_type *first,
+        const typename Ptree::key_type::value_type *last,
         Ptree &pt, const std::string &filename)
     {
         typedef typename Ptree::key_type::value_type char_type;
         typedef standard_callbacks<Ptree> callbacks_type;
         typedef detail::encoding<char_type> encoding_type;
-        typedef std::istreambuf_iterator<char_type> iterator;
-        callbacks_type callbacks;
+        callbacks_type callbacks(pt.get_allocator());
         encoding_type encoding;
-        read_json_internal(iterator(stream), iterator(),
-            encoding, callbacks, filename);
+        read_json_internal(first, last, encoding, callbacks, filename);
         pt.swap(callbacks.output());
     }
 
+    // Read everything that is left in the stream's buffer.
+    template <typename Ch, typename Traits>
+    void read_remaining(std::basic_istream<Ch, Traits> &stream,
+                        std::basic_string<Ch> &buffer)
+    {
+        buffer.resize(property_tree::detail::read_stream(stream, buffer));
+    }
+
+    template <typename Ptree>
+    void read_json_internal(
+        std::basic_istream<typename Ptree::key_type::value_type> &stream,
+        Ptree &pt, const std::string &filename)
+    {
+        typedef typename Ptree::key_type::value_type char_type;
+        std::basic_string<char_type> buffer;
+        read_remaining(stream, buffer);
+        read_json_internal(buffer.data(), buffer.data() + buffer.size(),
+                           pt, filename);
+    }
+
 }}}}
 
 #endif
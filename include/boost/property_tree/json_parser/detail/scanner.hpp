@@ -0,0 +1,231 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_DETAIL_JSON_PARSER_SCANNER_HPP
+#define BOOST_PROPERTY_TREE_DETAIL_JSON_PARSER_SCANNER_HPP
+
+#include <boost/property_tree/json_parser/detail/narrow_encoding.hpp>
+
+#include <boost/config.hpp>
+#include <boost/type_traits/is_base_of.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <cstddef>
+
+// The scanner works through 16 (SSE2) or 32 (AVX2) bytes at a time where
+// the compiler targets those instruction sets. Define
+// BOOST_PROPERTY_TREE_JSON_NO_SIMD to use the scalar loops only.
+#if !defined(BOOST_PROPERTY_TREE_JSON_NO_SIMD)
+#if defined(__AVX2__)
+#define BOOST_PROPERTY_TREE_JSON_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOOST_PROPERTY_TREE_JSON_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+#if defined(BOOST_MSVC) && (defined(BOOST_PROPERTY_TREE_JSON_AVX2) || \
+                            defined(BOOST_PROPERTY_TREE_JSON_SSE2))
+#include <intrin.h>
+#endif
+
+namespace boost { namespace property_tree {
+    namespace json_parser { namespace detail
+{
+
+    // Bulk scanning of contiguous UTF-8 input. Each function returns the
+    // first code unit at or after cur that it does not accept; the parser
+    // takes it from there one code unit at a time.
+    namespace scan
+    {
+        inline bool is_ws(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+        inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+        // ASCII that a string may contain without escaping.
+        inline bool is_plain(char c) {
+            unsigned char u = static_cast<unsigned char>(c);
+            return u >= 0x20 && u < 0x80 && c != '"' && c != '\\';
+        }
+
+#if defined(BOOST_PROPERTY_TREE_JSON_AVX2) || \
+    defined(BOOST_PROPERTY_TREE_JSON_SSE2)
+        inline unsigned first_set(unsigned mask) {
+#if defined(BOOST_MSVC)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned>(index);
+#else
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
+#endif
+
+#if defined(BOOST_PROPERTY_TREE_JSON_AVX2)
+        typedef __m256i block;
+        const std::ptrdiff_t block_size = 32;
+        inline block load(const char *p) {
+            return _mm256_loadu_si256(reinterpret_cast<const block*>(p));
+        }
+        inline block splat(char c) { return _mm256_set1_epi8(c); }
+        inline block eq(block a, block b) { return _mm256_cmpeq_epi8(a, b); }
+        inline block lt(block a, block b) { return _mm256_cmpgt_epi8(b, a); }
+        inline block either(block a, block b) { return _mm256_or_si256(a, b); }
+        inline unsigned bits(block a) {
+            return static_cast<unsigned>(_mm256_movemask_epi8(a));
+        }
+        const unsigned all_bits = 0xffffffffu;
+#elif defined(BOOST_PROPERTY_TREE_JSON_SSE2)
+        typedef __m128i block;
+        const std::ptrdiff_t block_size = 16;
+        inline block load(const char *p) {
+            return _mm_loadu_si128(reinterpret_cast<const block*>(p));
+        }
+        inline block splat(char c) { return _mm_set1_epi8(c); }
+        inline block eq(block a, block b) { return _mm_cmpeq_epi8(a, b); }
+        inline block lt(block a, block b) { return _mm_cmplt_epi8(a, b); }
+        inline block either(block a, block b) { return _mm_or_si128(a, b); }
+        inline unsigned bits(block a) {
+            return static_cast<unsigned>(_mm_movemask_epi8(a));
+        }
+        const unsigned all_bits = 0xffffu;
+#endif
+
+        inline const char *skip_ws(const char *cur, const char *end) {
+            // Most values are preceded by no or a single space; only
+            // indentation is worth a vector.
+            if (cur == end || !is_ws(*cur)) {
+                return cur;
+            }
+            ++cur;
+#if defined(BOOST_PROPERTY_TREE_JSON_AVX2) || \
+    defined(BOOST_PROPERTY_TREE_JSON_SSE2)
+            const block space = splat(' '), tab = splat('\t'),
+                        nl = splat('\n'), cr = splat('\r');
+            while (end - cur >= block_size) {
+                const block v = load(cur);
+                const unsigned ws = bits(either(either(eq(v, space),
+                                                       eq(v, tab)),
+                                                either(eq(v, nl),
+                                                       eq(v, cr))));
+                if (ws != all_bits) {
+                    return cur + first_set(~ws & all_bits);
+                }
+                cur += block_size;
+            }
+#endif
+            while (cur != end && is_ws(*cur)) {
+                ++cur;
+            }
+            return cur;
+        }
+
+        inline const char *skip_digits(const char *cur, const char *end) {
+            while (cur != end && is_digit(*cur)) {
+                ++cur;
+            }
+            return cur;
+        }
+
+        // Mirrors utf8_utf8_encoding::transcode_codepoint: the number of
+        // trailing bytes after a lead byte, or -1 if it cannot lead.
+        inline int trailing_bytes(unsigned char c) {
+            if (c < 0xc0) return -1;
+            if (c < 0xe0) return 1;
+            if (c < 0xf0) return 2;
+            if (c < 0xf8) return 3;
+            return -1;
+        }
+
+        // Skips ASCII runs by the block, and well-formed multi-byte
+        // sequences one at a time. Stops at quotes, backslashes, control
+        // characters and anything the encoding would reject, so that the
+        // parser reports errors as before.
+        inline const char *skip_string_chars(const char *cur,
+                                             const char *end) {
+#if defined(BOOST_PROPERTY_TREE_JSON_AVX2) || \
+    defined(BOOST_PROPERTY_TREE_JSON_SSE2)
+            const block quote = splat('"'), backslash = splat('\\'),
+                        space = splat(' ');
+#endif
+            for (;;) {
+#if defined(BOOST_PROPERTY_TREE_JSON_AVX2) || \
+    defined(BOOST_PROPERTY_TREE_JSON_SSE2)
+                while (end - cur >= block_size) {
+                    const block v = load(cur);
+                    // Signed compare: bytes from 0x80 up are below ' ' too.
+                    const unsigned stop = bits(either(
+                        either(eq(v, quote), eq(v, backslash)),
+                        lt(v, space)));
+                    if (stop) {
+                        cur += first_set(stop);
+                        break;
+                    }
+                    cur += block_size;
+                }
+#endif
+                while (cur != end && is_plain(*cur)) {
+                    ++cur;
+                }
+                if (cur == end) {
+                    return cur;
+                }
+                const unsigned char c = static_cast<unsigned char>(*cur);
+                if (c < 0x80) {
+                    return cur;
+                }
+                const int trailing = trailing_bytes(c);
+                if (trailing < 0 || end - cur <= trailing) {
+                    return cur;
+                }
+                for (int i = 1; i <= trailing; ++i) {
+                    if ((static_cast<unsigned char>(cur[i]) & 0xc0) != 0x80) {
+                        return cur;
+                    }
+                }
+                cur += trailing + 1;
+            }
+        }
+    }
+
+    // Lets the parser skip over whitespace, digits and string contents in
+    // bulk. This does nothing unless the input is a range of narrow
+    // characters in memory, in the library's UTF-8 encoding.
+    template <typename Encoding, typename Iterator, typename Enabler = void>
+    struct scanner
+    {
+        template <typename Sentinel>
+        static void skip_ws(Iterator &, Sentinel) {}
+        template <typename Sentinel>
+        static void skip_digits(Iterator &, Sentinel) {}
+        template <typename Sentinel>
+        static void skip_string_chars(Iterator &, Sentinel) {}
+    };
+
+    template <typename Encoding, typename Ch>
+    struct scanner<Encoding, Ch*, typename boost::enable_if_c<
+        boost::is_base_of<utf8_utf8_encoding, Encoding>::value &&
+        boost::is_same<typename boost::remove_const<Ch>::type, char>::value
+    >::type>
+    {
+        static void skip_ws(Ch *&cur, const char *end) {
+            cur += scan::skip_ws(cur, end) - cur;
+        }
+        static void skip_digits(Ch *&cur, const char *end) {
+            cur += scan::skip_digits(cur, end) - cur;
+        }
+        static void skip_string_chars(Ch *&cur, const char *end) {
+            cur += scan::skip_string_chars(cur, end) - cur;
+        }
+    };
+
+}}}}
+
+#endif
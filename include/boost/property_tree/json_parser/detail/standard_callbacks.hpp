@@ -30,6 +30,13 @@ namespace boost { namespace property_tree {
         typedef typename Ptree::data_type string;
         typedef typename string::value_type char_type;
 
+        standard_callbacks() {}
+        // The tree is built with the given allocator, so that parsing
+        // into an arena-backed ptree keeps the whole document in there.
+        explicit standard_callbacks(
+                const typename Ptree::allocator_type &alloc)
+            : root(alloc) {}
+
         void on_null() {
             new_value() = constants::null_value<char_type>();
         }
@@ -98,10 +105,22 @@ namespace boost { namespace property_tree {
     private:
         Ptree root;
         string key_buffer;
+        property_tree::detail::key_maker<typename Ptree::key_type> keys;
         enum kind { array, object, key, leaf };
         struct layer { kind k; Ptree* t; };
         std::vector<layer> stack;
 
+        static void new_child(Ptree &parent,
+                              const typename Ptree::key_type &key) {
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && \
+    !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) && \
+    !defined(BOOST_NO_CXX11_HDR_TUPLE)
+            parent.emplace_back(key);
+#else
+            parent.push_back(std::make_pair(key, Ptree()));
+#endif
+        }
+
         Ptree& new_tree() {
             if (stack.empty()) {
                 layer l = {leaf, &root};
@@ -111,7 +130,7 @@ namespace boost { namespace property_tree {
             layer& l = stack.back();
             switch (l.k) {
             case array: {
-                l.t->push_back(std::make_pair(string(), Ptree()));
+                new_child(*l.t, typename Ptree::key_type());
                 layer nl = {leaf, &l.t->back().second};
                 stack.push_back(nl);
                 return *stack.back().t;
@@ -120,7 +139,7 @@ namespace boost { namespace property_tree {
             default:
                 BOOST_ASSERT(false); // must start with string, i.e. call new_value
             case key: {
-                l.t->push_back(std::make_pair(key_buffer, Ptree()));
+                new_child(*l.t, keys(key_buffer));
                 l.k = object;
                 layer nl = {leaf, &l.t->back().second};
                 stack.push_back(nl);
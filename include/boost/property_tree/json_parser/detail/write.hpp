@@ -11,8 +11,11 @@
 #define BOOST_PROPERTY_TREE_DETAIL_JSON_PARSER_WRITE_HPP_INCLUDED
 
 #include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/detail/parser_io.hpp>
 #include <boost/next_prior.hpp>
 #include <boost/type_traits/make_unsigned.hpp>
+#include <algorithm>
+#include <cstddef>
 #include <string>
 #include <ostream>
 #include <iomanip>
@@ -20,134 +23,227 @@
 namespace boost { namespace property_tree { namespace json_parser
 {
 
-    // Create necessary escape sequences from illegal characters
+    // Whether a character is written as it is. Everything else is escaped.
+    // This assumes an ASCII superset. But so does everything in PTree.
+    // We escape everything outside ASCII, because this code can't
+    // handle high unicode characters.
+    inline bool is_unescaped(char c)
+    {
+        // Indexed by the byte value; 0 means an escape is needed.
+        static const unsigned char table[256] = {
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+            1,1,0,1,1,1,1,1,1,1,1,1,1,1,1,0, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,0,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1
+        };
+        return table[static_cast<unsigned char>(c)] != 0;
+    }
+
+    template<class Ch>
+    bool is_unescaped(Ch ch)
+    {
+        typedef typename make_unsigned<Ch>::type UCh;
+        UCh c(ch);
+        return c == 0x20 || c == 0x21 || (c >= 0x23 && c <= 0x2E) ||
+               (c >= 0x30 && c <= 0x5B) || (c >= 0x5D && c <= 0xFF);
+    }
+
+    // Write the escape sequence for a character that needs one to out, and
+    // return its length.
     template<class Ch>
-    std::basic_string<Ch> create_escapes(const std::basic_string<Ch> &s)
+    std::size_t escape_sequence(Ch ch, Ch *out)
     {
-        std::basic_string<Ch> result;
-        typename std::basic_string<Ch>::const_iterator b = s.begin();
-        typename std::basic_string<Ch>::const_iterator e = s.end();
+        typedef typename make_unsigned<Ch>::type UCh;
+        out[0] = Ch('\\');
+        switch (ch)
+        {
+        case Ch('\b'): out[1] = Ch('b'); return 2;
+        case Ch('\f'): out[1] = Ch('f'); return 2;
+        case Ch('\n'): out[1] = Ch('n'); return 2;
+        case Ch('\r'): out[1] = Ch('r'); return 2;
+        case Ch('\t'): out[1] = Ch('t'); return 2;
+        case Ch('/'): out[1] = Ch('/'); return 2;
+        case Ch('"'): out[1] = Ch('"'); return 2;
+        case Ch('\\'): out[1] = Ch('\\'); return 2;
+        }
+        const char *hexdigits = "0123456789ABCDEF";
+        unsigned long u = (std::min)(static_cast<unsigned long>(
+                                         static_cast<UCh>(ch)),
+                                     0xFFFFul);
+        out[1] = Ch('u');
+        out[2] = Ch(hexdigits[(u >> 12) & 0xF]);
+        out[3] = Ch(hexdigits[(u >> 8) & 0xF]);
+        out[4] = Ch(hexdigits[(u >> 4) & 0xF]);
+        out[5] = Ch(hexdigits[u & 0xF]);
+        return 6;
+    }
+
+    // Create necessary escape sequences from illegal characters
+    template<class Ch, class Traits, class Alloc>
+    std::basic_string<Ch, Traits, Alloc>
+        create_escapes(const std::basic_string<Ch, Traits, Alloc> &s)
+    {
+        typedef std::basic_string<Ch, Traits, Alloc> Str;
+        Str result;
+        result.reserve(s.size());
+        const Ch *b = s.data();
+        const Ch *e = b + s.size();
         while (b != e)
         {
-            typedef typename make_unsigned<Ch>::type UCh;
-            UCh c(*b);
-            // This assumes an ASCII superset. But so does everything in PTree.
-            // We escape everything outside ASCII, because this code can't
-            // handle high unicode characters.
-            if (c == 0x20 || c == 0x21 || (c >= 0x23 && c <= 0x2E) ||
-                (c >= 0x30 && c <= 0x5B) || (c >= 0x5D && c <= 0xFF))
-                result += *b;
-            else if (*b == Ch('\b')) result += Ch('\\'), result += Ch('b');
-            else if (*b == Ch('\f')) result += Ch('\\'), result += Ch('f');
-            else if (*b == Ch('\n')) result += Ch('\\'), result += Ch('n');
-            else if (*b == Ch('\r')) result += Ch('\\'), result += Ch('r');
-            else if (*b == Ch('\t')) result += Ch('\\'), result += Ch('t');
-            else if (*b == Ch('/')) result += Ch('\\'), result += Ch('/');
-            else if (*b == Ch('"'))  result += Ch('\\'), result += Ch('"');
-            else if (*b == Ch('\\')) result += Ch('\\'), result += Ch('\\');
-            else
+            const Ch *run = b;
+            while (run != e && is_unescaped(*run))
+                ++run;
+            result.append(b, run);
+            if (run == e)
+                break;
+            Ch sequence[6];
+            result.append(sequence, escape_sequence(*run, sequence));
+            b = run + 1;
+        }
+        return result;
+    }
+
+    // Collects the output in a staging buffer, which is handed to the
+    // stream buffer in one block, bypassing the formatted output functions,
+    // or discarded if the tree turns out not to be representable.
+    template<class Ch>
+    class json_output : public property_tree::detail::staged_output<Ch>
+    {
+    public:
+        explicit json_output(std::basic_ostream<Ch> &stream)
+            : property_tree::detail::staged_output<Ch>(stream)
+        {
+        }
+
+        void put_spaces(std::size_t count)
+        {
+            this->put(count, Ch(' '));
+        }
+
+        // Write s with the necessary escape sequences. Runs of characters
+        // that need none are copied as a whole.
+        void put_escaped(const Ch *first, const Ch *last)
+        {
+            while (first != last)
             {
-                const char *hexdigits = "0123456789ABCDEF";
-                unsigned long u = (std::min)(static_cast<unsigned long>(
-                                                 static_cast<UCh>(*b)),
-                                             0xFFFFul);
-                unsigned long d1 = u / 4096; u -= d1 * 4096;
-                unsigned long d2 = u / 256; u -= d2 * 256;
-                unsigned long d3 = u / 16; u -= d3 * 16;
-                unsigned long d4 = u;
-                result += Ch('\\'); result += Ch('u');
-                result += Ch(hexdigits[d1]); result += Ch(hexdigits[d2]);
-                result += Ch(hexdigits[d3]); result += Ch(hexdigits[d4]);
+                const Ch *run = first;
+                while (run != last && is_unescaped(*run))
+                    ++run;
+                this->put(first, run);
+                if (run == last)
+                    break;
+                Ch sequence[6];
+                this->put(sequence, sequence + escape_sequence(*run, sequence));
+                first = run + 1;
             }
-            ++b;
         }
-        return result;
+    };
+
+    // The string type of keys and values.
+    template<class Ptree>
+    struct json_string
+    {
+        typedef typename property_tree::detail::key_string<
+            typename Ptree::key_type>::type type;
+    };
+
+    // Whether all children are unnamed, which makes the node an array.
+    template<class Ptree>
+    bool is_json_array(const Ptree &pt)
+    {
+        typename Ptree::const_iterator it = pt.begin();
+        for (; it != pt.end(); ++it)
+            if (!it->first.empty())
+                return false;
+        return true;
     }
 
+    // Write the tree, and return whether it can be represented in JSON:
+    // the root has no data, and no node has both data and children. The
+    // tree is written the same way regardless.
     template<class Ptree>
-    void write_json_helper(std::basic_ostream<typename Ptree::key_type::value_type> &stream, 
+    bool write_json_helper(json_output<typename Ptree::key_type::value_type> &out,
                            const Ptree &pt,
                            int indent, bool pretty)
     {
 
         typedef typename Ptree::key_type::value_type Ch;
-        typedef typename std::basic_string<Ch> Str;
+        typedef typename json_string<Ptree>::type Str;
 
         // Value or object or array
+        Str temp;
         if (indent > 0 && pt.empty())
         {
             // Write value
-            Str data = create_escapes(pt.template get_value<Str>());
-            stream << Ch('"') << data << Ch('"');
-
+            const Str &data = property_tree::detail::string_data(pt, temp);
+            out.put(Ch('"'));
+            out.put_escaped(data.data(), data.data() + data.size());
+            out.put(Ch('"'));
+            return true;
         }
-        else if (indent > 0 && pt.count(Str()) == pt.size())
+
+        bool valid = property_tree::detail::string_data(pt, temp).empty();
+        if (indent > 0 && is_json_array(pt))
         {
             // Write array
-            stream << Ch('[');
-            if (pretty) stream << Ch('\n');
+            out.put(Ch('['));
+            if (pretty) out.put(Ch('\n'));
             typename Ptree::const_iterator it = pt.begin();
             for (; it != pt.end(); ++it)
             {
-                if (pretty) stream << Str(4 * (indent + 1), Ch(' '));
-                write_json_helper(stream, it->second, indent + 1, pretty);
+                if (pretty) out.put_spaces(4 * (indent + 1));
+                if (!write_json_helper(out, it->second, indent + 1, pretty))
+                    valid = false;
                 if (boost::next(it) != pt.end())
-                    stream << Ch(',');
-                if (pretty) stream << Ch('\n');
+                    out.put(Ch(','));
+                if (pretty) out.put(Ch('\n'));
             }
-            if (pretty) stream << Str(4 * indent, Ch(' '));
-            stream << Ch(']');
+            if (pretty) out.put_spaces(4 * indent);
+            out.put(Ch(']'));
 
         }
         else
         {
             // Write object
-            stream << Ch('{');
-            if (pretty) stream << Ch('\n');
+            out.put(Ch('{'));
+            if (pretty) out.put(Ch('\n'));
             typename Ptree::const_iterator it = pt.begin();
             for (; it != pt.end(); ++it)
             {
-                if (pretty) stream << Str(4 * (indent + 1), Ch(' '));
-                stream << Ch('"') << create_escapes(it->first) << Ch('"') << Ch(':');
-                if (pretty) stream << Ch(' ');
-                write_json_helper(stream, it->second, indent + 1, pretty);
+                if (pretty) out.put_spaces(4 * (indent + 1));
+                out.put(Ch('"'));
+                out.put_escaped(it->first.data(),
+                                it->first.data() + it->first.size());
+                out.put(Ch('"'));
+                out.put(Ch(':'));
+                if (pretty) out.put(Ch(' '));
+                if (!write_json_helper(out, it->second, indent + 1, pretty))
+                    valid = false;
                 if (boost::next(it) != pt.end())
-                    stream << Ch(',');
-                if (pretty) stream << Ch('\n');
+                    out.put(Ch(','));
+                if (pretty) out.put(Ch('\n'));
             }
-            if (pretty) stream << Str(4 * indent, Ch(' '));
-            stream << Ch('}');
+            if (pretty) out.put_spaces(4 * indent);
+            out.put(Ch('}'));
         }
+        return valid;
 
     }
 
-    // Verify if ptree does not contain information that cannot be written to json
     template<class Ptree>
-    bool verify_json(const Ptree &pt, int depth)
+    void write_json_helper(std::basic_ostream<typename Ptree::key_type::value_type> &stream, 
+                           const Ptree &pt,
+                           int indent, bool pretty)
     {
-
-        typedef typename Ptree::key_type::value_type Ch;
-        typedef typename std::basic_string<Ch> Str;
-
-        // Root ptree cannot have data
-        if (depth == 0 && !pt.template get_value<Str>().empty())
-            return false;
-        
-        // Ptree cannot have both children and data
-        if (!pt.template get_value<Str>().empty() && !pt.empty())
-            return false;
-
-        // Check children
-        typename Ptree::const_iterator it = pt.begin();
-        for (; it != pt.end(); ++it)
-            if (!verify_json(it->second, depth + 1))
-                return false;
-
-        // Success
-        return true;
-
+        json_output<typename Ptree::key_type::value_type> out(stream);
+        write_json_helper(out, pt, indent, pretty);
+        out.flush();
     }
-    
+
     // Write ptree to json stream
     template<class Ptree>
     void write_json_internal(std::basic_ostream<typename Ptree::key_type::value_type> &stream, 
@@ -155,9 +251,13 @@ namespace boost { namespace property_tree { namespace json_parser
                              const std::string &filename,
                              bool pretty)
     {
-        if (!verify_json(pt, 0))
+        json_output<typename Ptree::key_type::value_type> out(stream);
+        if (!write_json_helper(out, pt, 0, pretty))
+        {
+            out.discard();
             BOOST_PROPERTY_TREE_THROW(json_parser_error("ptree contains data that cannot be represented in JSON format", filename, 0));
-        write_json_helper(stream, pt, 0, pretty);
+        }
+        out.flush();
         stream << std::endl;
         if (!stream.good())
             BOOST_PROPERTY_TREE_THROW(json_parser_error("write error", filename, 0));
@@ -0,0 +1,96 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_JSON_PARSER_INCREMENTAL_READER_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_JSON_PARSER_INCREMENTAL_READER_HPP_INCLUDED
+
+#include <boost/property_tree/json_parser/error.hpp>
+#include <boost/property_tree/json_parser/detail/read.hpp>
+#include <boost/property_tree/json_parser/detail/incremental_parser.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace boost { namespace property_tree { namespace json_parser
+{
+
+    /**
+     * Reads a JSON document that arrives in pieces, e.g. from a socket.
+     * Each piece is parsed as it is fed, and nothing but the tree being
+     * built and a few code units of an unfinished character is kept
+     * between pieces. The result is the same as read_json's on the whole
+     * text.
+     *
+     * @code
+     * json_parser::incremental_reader<ptree> reader;
+     * while (std::size_t n = receive(buffer, sizeof(buffer)))
+     *     reader.feed(buffer, n);
+     * ptree pt;
+     * reader.finish(pt);
+     * @endcode
+     */
+    template <class Ptree>
+    class incremental_reader
+    {
+    public:
+        typedef typename Ptree::key_type::value_type char_type;
+        typedef typename Ptree::allocator_type allocator_type;
+
+        /**
+         * @param alloc The allocator for the tree that is built.
+         * @param filename The file name to report in errors.
+         */
+        explicit incremental_reader(
+                const allocator_type &alloc = allocator_type(),
+                const std::string &filename = std::string())
+            : m_alloc(alloc), m_callbacks(alloc),
+              m_parser(m_callbacks, m_encoding, filename)
+        {}
+
+        /**
+         * Parse the next piece of the document.
+         * @throw json_parser_error In case of a syntax error. The reader
+         *                          must not be used afterwards, except to
+         *                          call reset().
+         */
+        void feed(const char_type *data, std::size_t size) {
+            m_parser.feed(data, data + size);
+        }
+
+        /**
+         * Signal the end of the document, and swap the tree read into
+         * @p pt. The reader is then ready for the next document.
+         * @throw json_parser_error If the document is incomplete.
+         */
+        void finish(Ptree &pt) {
+            m_parser.finish();
+            pt.swap(m_callbacks.output());
+            reset();
+        }
+
+        /// Drop what has been read, and start over with a new document.
+        void reset() {
+            m_parser.reset();
+            m_callbacks = callbacks_type(m_alloc);
+        }
+
+    private:
+        typedef detail::standard_callbacks<Ptree> callbacks_type;
+        typedef detail::encoding<char_type> encoding_type;
+
+        incremental_reader(const incremental_reader&);
+        incremental_reader& operator =(const incremental_reader&);
+
+        allocator_type m_alloc;
+        callbacks_type m_callbacks;
+        encoding_type m_encoding;
+        detail::incremental_parser<callbacks_type, encoding_type> m_parser;
+    };
+
+} } }
+
+#endif
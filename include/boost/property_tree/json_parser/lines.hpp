@@ -0,0 +1,457 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_JSON_PARSER_LINES_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_JSON_PARSER_LINES_HPP_INCLUDED
+
+#include <boost/property_tree/ptree_fwd.hpp>
+#include <boost/property_tree/json_parser/error.hpp>
+#include <boost/property_tree/json_parser/detail/read.hpp>
+
+#include <boost/config.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <locale>
+#include <string>
+#include <vector>
+
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && \
+    !defined(BOOST_NO_CXX11_HDR_MUTEX) && \
+    !defined(BOOST_NO_CXX11_HDR_CONDITION_VARIABLE) && \
+    !defined(BOOST_NO_CXX11_HDR_EXCEPTION)
+#define BOOST_PROPERTY_TREE_JSON_LINES_THREADS
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace boost { namespace property_tree { namespace json_parser
+{
+
+    namespace detail
+    {
+        // A run of whole lines of the input, and the records read from it.
+        template <typename Ptree>
+        struct lines_chunk
+        {
+            typedef typename Ptree::key_type::value_type char_type;
+
+            lines_chunk(const char_type *first, const char_type *last)
+                : first(first), last(last), failed(false), line(0)
+#if defined(BOOST_PROPERTY_TREE_JSON_LINES_THREADS)
+                , done(false)
+#endif
+            {}
+
+            const char_type *first, *last;
+            std::vector<Ptree> records;
+            // A syntax error ends the chunk; line counts from its start.
+            bool failed;
+            std::string message;
+            unsigned long line;
+#if defined(BOOST_PROPERTY_TREE_JSON_LINES_THREADS)
+            bool done;
+            std::exception_ptr exception;
+#endif
+        };
+
+        template <typename Ch>
+        bool is_blank_line(const Ch *first, const Ch *last)
+        {
+            for (; first != last; ++first) {
+                if (*first != Ch(' ') && *first != Ch('\t') &&
+                    *first != Ch('\r')) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename Ptree>
+        void parse_lines(lines_chunk<Ptree> &chunk,
+                         const std::string &filename)
+        {
+            typedef typename Ptree::key_type::value_type char_type;
+            const char_type *cur = chunk.first;
+            for (unsigned long line = 1; cur != chunk.last; ++line) {
+                const char_type *eol =
+                    std::find(cur, chunk.last, char_type('\n'));
+                if (!is_blank_line(cur, eol)) {
+                    chunk.records.push_back(Ptree());
+                    try {
+                        read_json_internal(cur, eol, chunk.records.back(),
+                                           filename);
+                    } catch (json_parser_error &e) {
+                        chunk.records.pop_back();
+                        chunk.failed = true;
+                        chunk.message = e.message();
+                        chunk.line = line;
+                        return;
+                    }
+                }
+                cur = eol == chunk.last ? eol : eol + 1;
+            }
+        }
+
+        // Splits [first, last) into chunks of whole lines, a few per thread
+        // so that a slow chunk does not hold the others up.
+        template <typename Ptree>
+        void split_lines(const typename Ptree::key_type::value_type *first,
+                         const typename Ptree::key_type::value_type *last,
+                         unsigned threads,
+                         std::vector<lines_chunk<Ptree> > &chunks)
+        {
+            typedef typename Ptree::key_type::value_type char_type;
+            const std::size_t min_size = 64 * 1024;
+            std::size_t size = static_cast<std::size_t>(last - first) /
+                               (threads * 8u);
+            size = (std::max)(size, min_size);
+            while (first != last) {
+                const char_type *split =
+                    static_cast<std::size_t>(last - first) > size ?
+                        std::find(first + size, last, char_type('\n')) :
+                        last;
+                if (split != last) {
+                    ++split;
+                }
+                chunks.push_back(lines_chunk<Ptree>(first, split));
+                first = split;
+            }
+        }
+
+        // Hands the records of a chunk to the consumer, or throws the error
+        // that ended it, with the line number counted from the start of the
+        // input.
+        template <typename Ptree, typename Consumer>
+        void deliver_lines(lines_chunk<Ptree> &chunk,
+                           const typename Ptree::key_type::value_type *first,
+                           Consumer &consume, const std::string &filename)
+        {
+            typedef typename Ptree::key_type::value_type char_type;
+            consume(chunk.records);
+            std::vector<Ptree>().swap(chunk.records);
+            if (chunk.failed) {
+                BOOST_PROPERTY_TREE_THROW(json_parser_error(chunk.message,
+                    filename, chunk.line + static_cast<unsigned long>(
+                        std::count(first, chunk.first, char_type('\n')))));
+            }
+        }
+
+#if defined(BOOST_PROPERTY_TREE_JSON_LINES_THREADS)
+        // Parses chunks on worker threads while the calling thread hands
+        // the results on. Workers stay a bounded number of chunks ahead of
+        // the consumer, so that memory use does not grow with the input.
+        template <typename Ptree>
+        class lines_pool
+        {
+        public:
+            lines_pool(std::vector<lines_chunk<Ptree> > &chunks,
+                       unsigned threads, const std::string &filename)
+                : chunks(chunks), filename(filename), next(0), consumed(0),
+                  window(threads * 2u), stop(false)
+            {
+                try {
+                    for (unsigned i = 0; i < threads; ++i) {
+                        workers.push_back(
+                            std::thread(&lines_pool::work, this));
+                    }
+                } catch (...) {
+                    shut_down();
+                    throw;
+                }
+            }
+
+            ~lines_pool() { shut_down(); }
+
+            // Waits for the chunk to be consumed next; in order, or else in
+            // whatever order the chunks are finished.
+            lines_chunk<Ptree> &wait(bool ordered) {
+                std::unique_lock<std::mutex> lock(mutex);
+                std::size_t index;
+                for (;;) {
+                    if (ordered && chunks[consumed].done) {
+                        index = consumed;
+                        break;
+                    }
+                    if (!ordered && finished.size() > consumed) {
+                        index = finished[consumed];
+                        break;
+                    }
+                    cv.wait(lock);
+                }
+                lines_chunk<Ptree> &chunk = chunks[index];
+                if (chunk.exception) {
+                    std::rethrow_exception(chunk.exception);
+                }
+                return chunk;
+            }
+
+            void consumed_one() {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++consumed;
+                cv.notify_all();
+            }
+
+        private:
+            void work() {
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;) {
+                    while (!stop && next < chunks.size() &&
+                           next >= consumed + window) {
+                        cv.wait(lock);
+                    }
+                    if (stop || next == chunks.size()) {
+                        return;
+                    }
+                    const std::size_t index = next++;
+                    lock.unlock();
+                    try {
+                        parse_lines(chunks[index], filename);
+                    } catch (...) {
+                        chunks[index].exception = std::current_exception();
+                    }
+                    lock.lock();
+                    chunks[index].done = true;
+                    finished.push_back(index);
+                    cv.notify_all();
+                }
+            }
+
+            void shut_down() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stop = true;
+                    cv.notify_all();
+                }
+                for (std::size_t i = 0; i < workers.size(); ++i) {
+                    workers[i].join();
+                }
+                workers.clear();
+            }
+
+            lines_pool(const lines_pool &);
+            lines_pool &operator=(const lines_pool &);
+
+            std::vector<lines_chunk<Ptree> > &chunks;
+            const std::string &filename;
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::vector<std::thread> workers;
+            std::vector<std::size_t> finished;
+            std::size_t next, consumed, window;
+            bool stop;
+        };
+#endif
+
+        template <typename Ptree, typename Consumer>
+        void read_json_lines_internal(
+            const typename Ptree::key_type::value_type *first,
+            const typename Ptree::key_type::value_type *last,
+            Consumer &consume, unsigned threads, bool ordered,
+            const std::string &filename)
+        {
+#if defined(BOOST_PROPERTY_TREE_JSON_LINES_THREADS)
+            if (threads == 0) {
+                threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+            }
+#else
+            threads = 1;
+            (void)ordered;
+#endif
+            std::vector<lines_chunk<Ptree> > chunks;
+            split_lines(first, last, threads, chunks);
+#if defined(BOOST_PROPERTY_TREE_JSON_LINES_THREADS)
+            if (threads > 1 && chunks.size() > 1) {
+                lines_pool<Ptree> pool(chunks,
+                    static_cast<unsigned>((std::min)(
+                        static_cast<std::size_t>(threads), chunks.size())),
+                    filename);
+                for (std::size_t i = 0; i < chunks.size(); ++i) {
+                    deliver_lines(pool.wait(ordered), first, consume,
+                                  filename);
+                    pool.consumed_one();
+                }
+                return;
+            }
+#endif
+            for (std::size_t i = 0; i < chunks.size(); ++i) {
+                parse_lines(chunks[i], filename);
+                deliver_lines(chunks[i], first, consume, filename);
+            }
+        }
+
+        template <typename Ptree>
+        struct append_records
+        {
+            explicit append_records(std::vector<Ptree> &out) : out(out) {}
+            void operator ()(std::vector<Ptree> &records) {
+                for (std::size_t i = 0; i < records.size(); ++i) {
+                    out.push_back(Ptree());
+                    out.back().swap(records[i]);
+                }
+            }
+            std::vector<Ptree> &out;
+        };
+
+        template <typename Ptree, typename Callback>
+        struct call_per_record
+        {
+            explicit call_per_record(Callback &callback)
+                : callback(callback) {}
+            void operator ()(std::vector<Ptree> &records) {
+                for (std::size_t i = 0; i < records.size(); ++i) {
+                    callback(records[i]);
+                }
+            }
+            Callback &callback;
+        };
+
+        template <typename Ptree>
+        void read_json_lines_internal(
+            const typename Ptree::key_type::value_type *first,
+            const typename Ptree::key_type::value_type *last,
+            std::vector<Ptree> &records, unsigned threads,
+            const std::string &filename)
+        {
+            std::vector<Ptree> result;
+            append_records<Ptree> consume(result);
+            read_json_lines_internal<Ptree>(first, last, consume, threads,
+                                            true, filename);
+            records.swap(result);
+        }
+
+        template <typename Ch>
+        void read_file(const std::string &filename, const std::locale &loc,
+                       std::basic_string<Ch> &buffer)
+        {
+            std::basic_ifstream<Ch> stream(filename.c_str());
+            if (!stream)
+                BOOST_PROPERTY_TREE_THROW(json_parser_error(
+                    "cannot open file", filename, 0));
+            stream.imbue(loc);
+            read_remaining(stream, buffer);
+        }
+    }
+
+    /**
+     * Read newline-delimited JSON, one document per line, from the
+     * characters in [first, last). Blank lines are skipped. The lines are
+     * parsed in parallel.
+     * @note Replaces the contents of @p records. In case of error
+     *       @p records is unmodified.
+     * @throw json_parser_error In case of a syntax error. The line number
+     *                          is counted from @p first.
+     * @param first, last The characters to parse.
+     * @param[out] records Receives the documents in input order.
+     * @param threads The number of threads to use; 0 for as many as the
+     *                hardware supports. Without thread support in the
+     *                standard library, everything is read on the calling
+     *                thread.
+     */
+    template <class Ptree>
+    void read_json_lines(const typename Ptree::key_type::value_type *first,
+                         const typename Ptree::key_type::value_type *last,
+                         std::vector<Ptree> &records, unsigned threads = 0)
+    {
+        detail::read_json_lines_internal(first, last, records, threads,
+                                         std::string());
+    }
+
+    /**
+     * Read newline-delimited JSON, one document per line, from the
+     * characters in [first, last), and pass each document to @p callback
+     * as soon as it is available. Blank lines are skipped. The lines are
+     * parsed in parallel, but @p callback is only called on the calling
+     * thread, so it need not be thread-safe.
+     * @throw json_parser_error In case of a syntax error. The line number
+     *                          is counted from @p first. When the records
+     *                          are delivered in order, all records before
+     *                          the bad line have been passed to
+     *                          @p callback.
+     * @param first, last The characters to parse.
+     * @param callback Called as @c callback(pt) with a non-const reference
+     *                 to each document, which may be swapped out.
+     * @param threads The number of threads to use; 0 for as many as the
+     *                hardware supports.
+     * @param ordered Whether to deliver the documents in input order. If
+     *                false, runs of lines are delivered as they are parsed,
+     *                which keeps fewer parsed documents waiting.
+     */
+    template <class Ptree, class Callback>
+    void read_json_lines(const typename Ptree::key_type::value_type *first,
+                         const typename Ptree::key_type::value_type *last,
+                         Callback callback, unsigned threads = 0,
+                         bool ordered = true)
+    {
+        detail::call_per_record<Ptree, Callback> consume(callback);
+        detail::read_json_lines_internal<Ptree>(first, last, consume,
+                                                threads, ordered,
+                                                std::string());
+    }
+
+    /**
+     * Read newline-delimited JSON, one document per line, from the given
+     * file. Blank lines are skipped. The lines are parsed in parallel.
+     * @note Replaces the contents of @p records. In case of error
+     *       @p records is unmodified.
+     * @throw json_parser_error In case of error reading the file or of a
+     *                          syntax error.
+     * @param filename Name of the file from which to read.
+     * @param[out] records Receives the documents in file order.
+     * @param threads The number of threads to use; 0 for as many as the
+     *                hardware supports.
+     * @param loc The locale to use when reading in the file contents.
+     */
+    template <class Ptree>
+    void read_json_lines(const std::string &filename,
+                         std::vector<Ptree> &records, unsigned threads = 0,
+                         const std::locale &loc = std::locale())
+    {
+        std::basic_string<typename Ptree::key_type::value_type> buffer;
+        detail::read_file(filename, loc, buffer);
+        detail::read_json_lines_internal(buffer.data(),
+                                         buffer.data() + buffer.size(),
+                                         records, threads, filename);
+    }
+
+    /**
+     * Read newline-delimited JSON, one document per line, from the given
+     * file, and pass each document to @p callback as soon as it is
+     * available. See the overload for a range of characters for details.
+     * @throw json_parser_error In case of error reading the file or of a
+     *                          syntax error.
+     * @param filename Name of the file from which to read.
+     * @param callback Called as @c callback(pt) with each document.
+     * @param threads The number of threads to use; 0 for as many as the
+     *                hardware supports.
+     * @param ordered Whether to deliver the documents in file order.
+     * @param loc The locale to use when reading in the file contents.
+     */
+    template <class Ptree, class Callback>
+    void read_json_lines(const std::string &filename, Callback callback,
+                         unsigned threads = 0, bool ordered = true,
+                         const std::locale &loc = std::locale())
+    {
+        std::basic_string<typename Ptree::key_type::value_type> buffer;
+        detail::read_file(filename, loc, buffer);
+        detail::call_per_record<Ptree, Callback> consume(callback);
+        detail::read_json_lines_internal<Ptree>(
+            buffer.data(), buffer.data() + buffer.size(), consume, threads,
+            ordered, filename);
+    }
+
+} } }
+
+namespace boost { namespace property_tree
+{
+    using json_parser::read_json_lines;
+} }
+
+#endif
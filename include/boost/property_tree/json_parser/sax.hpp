@@ -0,0 +1,198 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+#ifndef BOOST_PROPERTY_TREE_JSON_PARSER_SAX_HPP_INCLUDED
+#define BOOST_PROPERTY_TREE_JSON_PARSER_SAX_HPP_INCLUDED
+
+#include <boost/property_tree/json_parser/error.hpp>
+#include <boost/property_tree/json_parser/detail/read.hpp>
+
+#include <istream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace boost { namespace property_tree { namespace json_parser
+{
+
+    /**
+     * A handler that ignores all events. Derive from it and hide the
+     * members for the events of interest.
+     *
+     * A handler for parse() needs these members, which are called in
+     * document order:
+     * @code
+     * void on_null();
+     * void on_boolean(bool b);
+     * void on_number(const string_type &text);  // as written in the input
+     * void on_string(const string_type &value); // with escapes resolved
+     * void on_key(const string_type &key);      // before each member value
+     * void on_begin_object();
+     * void on_end_object();
+     * void on_begin_array();
+     * void on_end_array();
+     * @endcode
+     * The strings passed are only valid during the call.
+     */
+    template <typename Ch>
+    struct basic_handler
+    {
+        typedef std::basic_string<Ch> string_type;
+
+        void on_null() {}
+        void on_boolean(bool) {}
+        void on_number(const string_type &) {}
+        void on_string(const string_type &) {}
+        void on_key(const string_type &) {}
+        void on_begin_object() {}
+        void on_end_object() {}
+        void on_begin_array() {}
+        void on_end_array() {}
+    };
+
+    namespace detail
+    {
+        // Turns the parser's callbacks into handler events. Strings are
+        // collected in a single buffer, so memory use only depends on the
+        // longest string and the nesting depth.
+        template <typename Handler, typename Ch>
+        class sax_callbacks
+        {
+        public:
+            typedef Ch char_type;
+
+            explicit sax_callbacks(Handler &handler) : handler(handler) {}
+
+            void on_null() {
+                handler.on_null();
+                value_done();
+            }
+
+            void on_boolean(bool b) {
+                handler.on_boolean(b);
+                value_done();
+            }
+
+            template <typename Range>
+            void on_number(Range code_units) {
+                buffer.assign(code_units.begin(), code_units.end());
+                on_end_number();
+            }
+            void on_begin_number() {
+                buffer.clear();
+            }
+            void on_digit(char_type d) {
+                buffer += d;
+            }
+            void on_end_number() {
+                handler.on_number(buffer);
+                value_done();
+            }
+
+            void on_begin_string() {
+                buffer.clear();
+            }
+            template <typename Range>
+            void on_code_units(Range code_units) {
+                buffer.append(code_units.begin(), code_units.end());
+            }
+            void on_code_unit(char_type c) {
+                buffer += c;
+            }
+            void on_end_string() {
+                if (!levels.empty() && levels.back() == key) {
+                    levels.back() = value;
+                    handler.on_key(buffer);
+                } else {
+                    handler.on_string(buffer);
+                    value_done();
+                }
+            }
+
+            void on_begin_array() {
+                handler.on_begin_array();
+                levels.push_back(array);
+            }
+            void on_end_array() {
+                levels.pop_back();
+                handler.on_end_array();
+                value_done();
+            }
+
+            void on_begin_object() {
+                handler.on_begin_object();
+                levels.push_back(key);
+            }
+            void on_end_object() {
+                levels.pop_back();
+                handler.on_end_object();
+                value_done();
+            }
+
+        private:
+            // What the next string in each open container is.
+            enum level { array, key, value };
+
+            void value_done() {
+                if (!levels.empty() && levels.back() == value) {
+                    levels.back() = key;
+                }
+            }
+
+            Handler &handler;
+            std::basic_string<Ch> buffer;
+            std::vector<level> levels;
+        };
+
+        template <typename Iterator, typename Sentinel, typename Handler>
+        void parse_internal(Iterator first, Sentinel last, Handler &handler,
+                            const std::string &filename)
+        {
+            typedef typename std::iterator_traits<Iterator>::value_type
+                char_type;
+            typedef detail::encoding<char_type> encoding_type;
+            sax_callbacks<Handler, char_type> callbacks(handler);
+            encoding_type encoding;
+            read_json_internal(first, last, encoding, callbacks, filename);
+        }
+    }
+
+    /**
+     * Parse the JSON text in [first, last) and report what it contains to
+     * @p handler, without building a property tree.
+     * @throw json_parser_error In case of a syntax error. The events
+     *                          up to the error have been reported.
+     * @param first, last The text to parse; char or wchar_t.
+     * @param handler Receives the events; see basic_handler.
+     */
+    template <typename Iterator, typename Sentinel, typename Handler>
+    void parse(Iterator first, Sentinel last, Handler &handler)
+    {
+        detail::parse_internal(first, last, handler, std::string());
+    }
+
+    /**
+     * Parse JSON from the given stream and report what it contains to
+     * @p handler, without building a property tree. The stream is read as
+     * the parser goes, so that memory use does not depend on the size of
+     * the input.
+     * @throw json_parser_error In case of a syntax error. The events
+     *                          up to the error have been reported.
+     * @param stream Stream from which to read the JSON text.
+     * @param handler Receives the events; see basic_handler.
+     */
+    template <typename Ch, typename Handler>
+    void parse(std::basic_istream<Ch> &stream, Handler &handler)
+    {
+        typedef std::istreambuf_iterator<Ch> iterator;
+        detail::parse_internal(iterator(stream), iterator(), handler,
+                               std::string());
+    }
+
+} } }
+
+#endif
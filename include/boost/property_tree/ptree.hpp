@@ -14,19 +14,28 @@
 
 #include <boost/property_tree/ptree_fwd.hpp>
 #include <boost/property_tree/string_path.hpp>
+#include <boost/property_tree/compiled_path.hpp>
 #include <boost/property_tree/stream_translator.hpp>
 #include <boost/property_tree/exceptions.hpp>
 #include <boost/property_tree/detail/ptree_utils.hpp>
+#include <boost/property_tree/detail/ptree_inline_children.hpp>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/indexed_by.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/utility/enable_if.hpp>
+#include <boost/compressed_pair.hpp>
+#include <boost/core/allocator_access.hpp>
+#include <boost/type_traits/is_nothrow_move_constructible.hpp>
 #include <boost/throw_exception.hpp>
 #include <boost/optional.hpp>
-#include <utility>                  // for std::pair
+#include <utility>                  // for std::pair, std::move
+#if !defined(BOOST_NO_CXX11_HDR_TUPLE)
+#include <tuple>                    // for std::forward_as_tuple
+#endif
 
 namespace boost { namespace property_tree
 {
@@ -38,13 +47,24 @@ namespace boost { namespace property_tree
      * by a non-unique key of type @p Key.
      *
      * Key equivalency is defined by @p KeyCompare, a predicate defining a
-     * strict weak ordering.
+     * strict weak ordering. Alternatively, @p KeyCompare can be a
+     * hashed_key, which makes the children searchable by hash instead; the
+     * associative view is then in no particular order.
+     *
+     * All memory for the child containers comes from an instance of
+     * @p Alloc, rebound as necessary. Each node keeps the allocator it was
+     * constructed with and hands it to the children it stores. Allocators
+     * that do uses-allocator construction (e.g.
+     * @c std::pmr::polymorphic_allocator) pass themselves on to the keys,
+     * data and subtrees of inserted children as well, so that an entire tree
+     * can be placed in a single memory resource. The allocator must be
+     * default-constructible.
      *
      * Property tree defines a Container-like interface to the (key-node) pairs
      * of its direct sub-nodes. The iterators are bidirectional. The sequence
      * of nodes is held in insertion order, not key order.
      */
-    template<class Key, class Data, class KeyCompare>
+    template<class Key, class Data, class KeyCompare, class Alloc>
     class basic_ptree
     {
 #if defined(BOOST_PROPERTY_TREE_DOXYGEN_INVOKED)
@@ -55,13 +75,14 @@ namespace boost { namespace property_tree
          * Simpler way to refer to this basic_ptree\<C,K,P,A\> type.
          * Note that this is private, and made public only for doxygen.
          */
-        typedef basic_ptree<Key, Data, KeyCompare> self_type;
+        typedef basic_ptree<Key, Data, KeyCompare, Alloc> self_type;
 
     public:
         // Basic types
         typedef Key                                  key_type;
         typedef Data                                 data_type;
         typedef KeyCompare                           key_compare;
+        typedef Alloc                                allocator_type;
 
         // Container view types
         typedef std::pair<const Key, self_type>      value_type;
@@ -80,24 +101,64 @@ namespace boost { namespace property_tree
 
         // Property tree view types
         typedef typename path_of<Key>::type          path_type;
+        typedef compiled_path<Key>                   compiled_path_type;
+        typedef typename detail::path_chars<path_type>::type
+                                                     path_char_type;
 
 
         // The big five
 
         /** Creates a node with no children and default-constructed data. */
         basic_ptree();
+        /** Creates a node with no children and default-constructed data,
+         * which will use the given allocator.
+         */
+        explicit basic_ptree(const allocator_type &alloc);
         /** Creates a node with no children and a copy of the given data. */
         explicit basic_ptree(const data_type &data);
+        /** Creates a node with no children and a copy of the given data,
+         * which will use the given allocator.
+         */
+        basic_ptree(const data_type &data, const allocator_type &alloc);
         basic_ptree(const self_type &rhs);
+        /** Deep copy of @p rhs that uses the given allocator. */
+        basic_ptree(const self_type &rhs, const allocator_type &alloc);
         ~basic_ptree();
-        /** Basic guarantee only. */
+        /** Basic guarantee only. The tree keeps its allocator. */
         self_type &operator =(const self_type &rhs);
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+        /** Takes over the data and children of @p rhs, which is left
+         * without children. Nothrow if moving the data and the allocator
+         * is, so that standard containers move trees when they grow.
+         */
+        basic_ptree(self_type &&rhs) BOOST_NOEXCEPT_IF(
+            boost::is_nothrow_move_constructible<data_type>::value &&
+            boost::is_nothrow_move_constructible<allocator_type>::value);
+        /** Like the move constructor if @p alloc equals the allocator of
+         * @p rhs; otherwise a deep copy.
+         */
+        basic_ptree(self_type &&rhs, const allocator_type &alloc);
+        /** The tree keeps its allocator. The children are taken over if the
+         * allocators compare equal, and copied otherwise. Nothrow if
+         * allocators of this type always compare equal and moving the data
+         * and the allocator is nothrow.
+         */
+        self_type &operator =(self_type &&rhs) BOOST_NOEXCEPT_IF(
+            boost::is_nothrow_move_constructible<data_type>::value &&
+            boost::is_nothrow_move_constructible<allocator_type>::value &&
+            boost::allocator_is_always_equal<allocator_type>::type::value);
+#endif
 
         /** Swap with other tree. Only constant-time and nothrow if the
-         * data type's swap is.
+         * data type's swap is. As with the standard containers, the
+         * allocators are only swapped if they propagate on swap; otherwise
+         * they must compare equal.
          */
         void swap(self_type &rhs);
 
+        /** The allocator this node uses for its children. */
+        allocator_type get_allocator() const;
+
         // Container view functions
 
         /** The number of direct children of this node. */
@@ -121,10 +182,17 @@ namespace boost { namespace property_tree
         const value_type &back() const;
 
         /** Insert a copy of the given tree with its key just before the given
-         * position in this node. This operation invalidates no iterators.
+         * position in this node. This operation invalidates no iterators,
+         * except the end iterator of a node that had no children before.
          * @return An iterator to the newly created child.
          */
         iterator insert(iterator where, const value_type &value);
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+        /** Like insert(where, const value_type&), but moves the subtree
+         * instead of copying it.
+         */
+        iterator insert(iterator where, value_type &&value);
+#endif
 
         /** Range insert. Equivalent to:
          * @code
@@ -153,6 +221,26 @@ namespace boost { namespace property_tree
         /** Equivalent to insert(end(), value). */
         iterator push_back(const value_type &value);
 
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+        /** Equivalent to insert(begin(), std::move(value)). */
+        iterator push_front(value_type &&value);
+
+        /** Equivalent to insert(end(), std::move(value)). */
+        iterator push_back(value_type &&value);
+#endif
+
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && \
+    !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) && \
+    !defined(BOOST_NO_CXX11_HDR_TUPLE)
+        /** Construct a child at the end of this node in place. Its key is
+         * @p key, and its tree is constructed from @p args, e.g. from its
+         * data. Nothing is copied.
+         * @return An iterator to the newly created child.
+         */
+        template<class... Args>
+        iterator emplace_back(const key_type &key, Args&&... args);
+#endif
+
         /** Equivalent to erase(begin()). */
         void pop_front();
 
@@ -181,9 +269,16 @@ namespace boost { namespace property_tree
 
         // Associative view
 
-        /** Returns an iterator to the first child, in key order. */
+        /** Returns an iterator to the first child, in key order. For a
+         * hashed_key tree, the order is unspecified, except that children
+         * with equal keys are adjacent, and the iterator is only a forward
+         * iterator.
+         */
         assoc_iterator ordered_begin();
-        /** Returns an iterator to the first child, in key order. */
+        /** Returns an iterator to the first child, in key order. For a
+         * hashed_key tree, the order is unspecified, except that children
+         * with equal keys are adjacent.
+         */
         const_assoc_iterator ordered_begin() const;
 
         /** Returns the not-found iterator. Equivalent to end() in a real
@@ -277,6 +372,22 @@ namespace boost { namespace property_tree
         optional<const self_type &>
           get_child_optional(const path_type &path) const;
 
+        // Lookups by a literal path walk the characters in place, without
+        // copying them into a path_type first.
+
+        /** Get the child at the given path, or throw @c ptree_bad_path. */
+        self_type &get_child(const path_char_type *path);
+
+        /** Get the child at the given path, or throw @c ptree_bad_path. */
+        const self_type &get_child(const path_char_type *path) const;
+
+        /** Get the child at the given path, or return boost::null. */
+        optional<self_type &> get_child_optional(const path_char_type *path);
+
+        /** Get the child at the given path, or return boost::null. */
+        optional<const self_type &>
+          get_child_optional(const path_char_type *path) const;
+
         /** Set the node at the given path to the given value. Create any
          * missing parents. If the node at the path already exists, replace it.
          * @return A reference to the inserted subtree.
@@ -287,6 +398,13 @@ namespace boost { namespace property_tree
          */
         self_type &put_child(const path_type &path, const self_type &value);
 
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+        /** Like put_child(path, const self_type&), but moves the subtree
+         * into place instead of copying it.
+         */
+        self_type &put_child(const path_type &path, self_type &&value);
+#endif
+
         /** Add the node at the given path. Create any missing parents. If there
          * already is a node at the path, add another one with the same key.
          * @param path Path to the child. The last fragment must not have an
@@ -297,6 +415,13 @@ namespace boost { namespace property_tree
          */
         self_type &add_child(const path_type &path, const self_type &value);
 
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+        /** Like add_child(path, const self_type&), but moves the subtree
+         * into place instead of copying it.
+         */
+        self_type &add_child(const path_type &path, self_type &&value);
+#endif
+
         /** Take the value of this node and attempt to translate it to a
          * @c Type object using the supplied translator.
          * @throw ptree_bad_data if the conversion fails.
@@ -437,6 +562,14 @@ namespace boost { namespace property_tree
         template<class Type>
         optional<Type> get_optional(const path_type &path) const;
 
+        /** Shorthand for get_child(path).get_value\<Type\>(). */
+        template<class Type>
+        Type get(const path_char_type *path) const;
+
+        /** Shorthand for get_child_optional(path)->get_value_optional(). */
+        template<class Type>
+        optional<Type> get_optional(const path_char_type *path) const;
+
         /** Set the value of the node at the given path to the supplied value,
          * translated to the tree's data type. If the node doesn't exist, it is
          * created, including all its missing parents.
@@ -486,21 +619,128 @@ namespace boost { namespace property_tree
         template<class Type>
         self_type &add(const path_type &path, const Type &value);
 
+        // Property tree view, with compiled paths
+
+        /** Get the child at the given compiled path, or throw
+         * @c ptree_bad_path.
+         */
+        self_type &get_child(const compiled_path_type &path);
+
+        /** Get the child at the given compiled path, or throw
+         * @c ptree_bad_path.
+         */
+        const self_type &get_child(const compiled_path_type &path) const;
+
+        /** Get the child at the given compiled path, or return
+         * @p default_value.
+         */
+        self_type &get_child(const compiled_path_type &path,
+                             self_type &default_value);
+
+        /** Get the child at the given compiled path, or return
+         * @p default_value.
+         */
+        const self_type &get_child(const compiled_path_type &path,
+                                   const self_type &default_value) const;
+
+        /** Get the child at the given compiled path, or return boost::null. */
+        optional<self_type &>
+          get_child_optional(const compiled_path_type &path);
+
+        /** Get the child at the given compiled path, or return boost::null. */
+        optional<const self_type &>
+          get_child_optional(const compiled_path_type &path) const;
+
+        /** Like put_child(const path_type&, const self_type&), for a
+         * compiled path.
+         */
+        self_type &put_child(const compiled_path_type &path,
+                             const self_type &value);
+
+        /** Like add_child(const path_type&, const self_type&), for a
+         * compiled path.
+         */
+        self_type &add_child(const compiled_path_type &path,
+                             const self_type &value);
+
+        /** Shorthand for get_child(path).get_value\<Type\>(). */
+        template<class Type>
+        Type get(const compiled_path_type &path) const;
+
+        /** Shorthand for get_child(path, empty_ptree())
+         *                    .get_value(default_value).
+         */
+        template<class Type>
+        Type get(const compiled_path_type &path,
+                 const Type &default_value) const;
+
+        /** Make get do the right thing for string literals. */
+        template <class Ch>
+        typename boost::enable_if<
+            detail::is_character<Ch>,
+            std::basic_string<Ch>
+        >::type
+        get(const compiled_path_type &path, const Ch *default_value) const;
+
+        /** Like get_optional(const path_type&), for a compiled path. */
+        template<class Type>
+        optional<Type> get_optional(const compiled_path_type &path) const;
+
+        /** Like put(const path_type&, const Type&), for a compiled path. */
+        template<class Type>
+        self_type &put(const compiled_path_type &path, const Type &value);
+
+        /** Like add(const path_type&, const Type&), for a compiled path. */
+        template<class Type>
+        self_type &add(const compiled_path_type &path, const Type &value);
+
+        // Batched lookup
+
+        /** Look up several compiled paths in one go. For every path in
+         * [first, last), the result of get_child_optional(path) is written
+         * to @p out. Each path starts from the deepest node it shares with
+         * the one before it, so paths with common prefixes, listed next to
+         * each other, walk the common part only once.
+         * @param first, last A forward range of compiled_path_type.
+         * @return The output iterator past the last result written.
+         */
+        template<class ForwardIterator, class OutputIterator>
+        OutputIterator get_child_many(ForwardIterator first,
+                                      ForwardIterator last,
+                                      OutputIterator out);
+
+        /** Const version of get_child_many; writes
+         * optional\<const self_type&\>.
+         */
+        template<class ForwardIterator, class OutputIterator>
+        OutputIterator get_child_many(ForwardIterator first,
+                                      ForwardIterator last,
+                                      OutputIterator out) const;
+
+        /** Like get_child_many, but writes get_optional\<Type\>(path) for
+         * every path instead.
+         */
+        template<class Type, class ForwardIterator, class OutputIterator>
+        OutputIterator get_many(ForwardIterator first, ForwardIterator last,
+                                OutputIterator out) const;
+
     private:
         // Hold the data of this node
         data_type m_data;
         // Hold the children - this is a void* because we can't complete the
-        // container type within the class.
-        void* m_children;
+        // container type within the class. Null if the container has not
+        // been needed yet; see subs::grow(). The allocator for the container
+        // is stored alongside, taking no space if it is stateless.
+        boost::compressed_pair<void*, allocator_type> m_children;
 
         // Getter tree-walk. Not const-safe! Gets the node the path refers to,
-        // or null. Destroys p's value.
+        // or null. Consumes p.
         self_type* walk_path(path_type& p) const;
 
         // Modifer tree-walk. Gets the parent of the node referred to by the
-        // path, creating nodes as necessary. p is the path to the remaining
-        // child.
-        self_type& force_path(path_type& p);
+        // path, creating nodes as necessary. fragment receives the key of
+        // the remaining child. Consumes p.
+        self_type& force_path(path_type& p, key_type& fragment);
 
         // This struct contains typedefs for the concrete types.
         struct subs;
@@ -14,10 +14,21 @@
 #include <boost/config.hpp>
 #include <boost/optional/optional_fwd.hpp>
 #include <boost/throw_exception.hpp>
-#include <functional>           // for std::less
+#include <boost/functional/hash_fwd.hpp>
+#include <functional>           // for std::less, std::equal_to
+#include <cstddef>              // for std::size_t
 #include <memory>               // for std::allocator
 #include <string>
 
+#if !defined(BOOST_PROPERTY_TREE_NO_PMR) && defined(__has_include)
+#  if __has_include(<memory_resource>) && \
+      (__cplusplus >= 201703L || \
+       (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#    include <memory_resource>
+#    define BOOST_PROPERTY_TREE_HAS_PMR
+#  endif
+#endif
+
 namespace boost { namespace property_tree
 {
     namespace detail {
@@ -26,15 +37,39 @@ namespace boost { namespace property_tree
 
     // Classes
 
-    template < class Key, class Data, class KeyCompare = std::less<Key> >
+    template < class Key, class Data, class KeyCompare = std::less<Key>,
+               class Alloc = std::allocator<char> >
     class basic_ptree;
 
+    /**
+     * Pass this as the @c KeyCompare argument of basic_ptree to look up
+     * children through a hash index instead of an ordered index. @c Hash and
+     * @c Pred take the place of the comparison predicate; @c Pred must be
+     * consistent with @c Hash.
+     */
+    template <class Key, class Hash = boost::hash<Key>,
+              class Pred = std::equal_to<Key> >
+    struct hashed_key
+    {
+        typedef Hash hasher;
+        typedef Pred key_equal;
+    };
+
+    template <std::size_t N, class Alloc = std::allocator<char> >
+    class inline_children;
+
+    template <typename Ch, typename Traits = std::char_traits<Ch> >
+    class basic_interned_string;
+
     template <typename T>
     struct id_translator;
 
     template <typename String, typename Translator>
     class string_path;
 
+    template <typename Key>
+    class compiled_path;
+
     // Texas-style concepts for documentation only.
 #if 0
     concept PropertyTreePath<class Path> {
@@ -123,14 +158,63 @@ namespace boost { namespace property_tree
         wiptree;
 #endif
 
+    /**
+     * A property tree with std::string for key and data, and hashed lookup
+     * of children by key. Finding a child is constant time on average,
+     * which pays off for nodes with very many children. The associative
+     * view is not sorted: ordered_begin() visits the children in hash order,
+     * with equal keys adjacent.
+     */
+    typedef basic_ptree<std::string, std::string, hashed_key<std::string> >
+        hashed_ptree;
+
+#ifndef BOOST_NO_STD_WSTRING
+    /**
+     * Like hashed_ptree, but with std::wstring for key and data.
+     * @note The type only exists if the platform supports @c wchar_t.
+     */
+    typedef basic_ptree<std::wstring, std::wstring,
+                        hashed_key<std::wstring> >
+        hashed_wptree;
+#endif
+
+#if defined(BOOST_PROPERTY_TREE_HAS_PMR)
+    namespace pmr
+    {
+        /**
+         * A property tree with std::pmr::string for key and data, whose
+         * children, keys and data are all allocated from the memory
+         * resource of the allocator the tree was created with. Together
+         * with a @c std::pmr::monotonic_buffer_resource, a whole document
+         * can be built in one arena and released at once.
+         * @note The type only exists if the standard library provides
+         *       @c \<memory_resource\>.
+         */
+        typedef basic_ptree<std::pmr::string, std::pmr::string,
+                            std::less<std::pmr::string>,
+                            std::pmr::polymorphic_allocator<char> >
+            ptree;
+
+#ifndef BOOST_NO_STD_WSTRING
+        /**
+         * Like pmr::ptree, but with std::pmr::wstring for key and data.
+         */
+        typedef basic_ptree<std::pmr::wstring, std::pmr::wstring,
+                            std::less<std::pmr::wstring>,
+                            std::pmr::polymorphic_allocator<wchar_t> >
+            wptree;
+#endif
+    }
+#endif
+
     // Free functions
 
     /**
      * Swap two property tree instances.
      */
-    template<class K, class D, class C>
-    void swap(basic_ptree<K, D, C> &pt1,
-              basic_ptree<K, D, C> &pt2);
+    template<class K, class D, class C, class A>
+    void swap(basic_ptree<K, D, C, A> &pt1,
+              basic_ptree<K, D, C, A> &pt2);
 
 } }
 
@@ -38,26 +38,26 @@ namespace boost { namespace property_tree
      * @param file_version file_version for the archive.
      * @post @c ar will contain the serialized form of @c t.
      */
-    template<class Archive, class K, class D, class C>
+    template<class Archive, class K, class D, class C, class A>
     inline void save(Archive &ar,
-                     const basic_ptree<K, D, C> &t,
+                     const basic_ptree<K, D, C, A> &t,
                      const unsigned int file_version)
     {
         using namespace boost::serialization;
-        stl::save_collection<Archive, basic_ptree<K, D, C> >(ar, t);
+        stl::save_collection<Archive, basic_ptree<K, D, C, A> >(ar, t);
         ar << make_nvp("data", t.data());
     }
 
     namespace detail
     {
-        template <class Archive, class K, class D, class C>
+        template <class Archive, class K, class D, class C, class A>
         inline void load_children(Archive &ar,
-                                  basic_ptree<K, D, C> &t)
+                                  basic_ptree<K, D, C, A> &t)
         {
             namespace bsl = boost::serialization;
             namespace bsa = boost::archive;
 
-            typedef basic_ptree<K, D, C> tree;
+            typedef basic_ptree<K, D, C, A> tree;
             typedef typename tree::value_type value_type;
     
             bsl::collection_size_type count;
@@ -96,9 +96,9 @@ namespace boost { namespace property_tree
      * @param file_version file_version for the archive.
      * @post @c t will contain the de-serialized data from @c ar.
      */
-    template<class Archive, class K, class D, class C>
+    template<class Archive, class K, class D, class C, class A>
     inline void load(Archive &ar,
-                     basic_ptree<K, D, C> &t,
+                     basic_ptree<K, D, C, A> &t,
                      const unsigned int file_version)
     {
         namespace bsl = boost::serialization;
@@ -115,15 +115,47 @@ namespace boost { namespace property_tree
      * @param t The property tree to load or save.
      * @param file_version file_version for the archive.
      */
-    template<class Archive, class K, class D, class C>
+    template<class Archive, class K, class D, class C, class A>
     inline void serialize(Archive &ar,
-                          basic_ptree<K, D, C> &t,
+                          basic_ptree<K, D, C, A> &t,
                           const unsigned int file_version)
     {
         using namespace boost::serialization;
         split_free(ar, t, file_version);
     }
 
+    /**
+     * Save an interned string as the string it stands for.
+     */
+    template<class Archive, class Ch, class Traits>
+    inline void save(Archive &ar,
+                     const basic_interned_string<Ch, Traits> &s,
+                     const unsigned int)
+    {
+        ar << boost::serialization::make_nvp("string", s.str());
+    }
+
+    /**
+     * Load a string and intern it.
+     */
+    template<class Archive, class Ch, class Traits>
+    inline void load(Archive &ar,
+                     basic_interned_string<Ch, Traits> &s,
+                     const unsigned int)
+    {
+        std::basic_string<Ch, Traits> str;
+        ar >> boost::serialization::make_nvp("string", str);
+        s = basic_interned_string<Ch, Traits>(str);
+    }
+
+    template<class Archive, class Ch, class Traits>
+    inline void serialize(Archive &ar,
+                          basic_interned_string<Ch, Traits> &s,
+                          const unsigned int file_version)
+    {
+        boost::serialization::split_free(ar, s, file_version);
+    }
+
 } }
 
 #endif
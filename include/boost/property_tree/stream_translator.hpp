@@ -18,17 +18,41 @@
 #include <boost/utility/enable_if.hpp>
 #include <boost/type_traits/decay.hpp>
 #include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_same.hpp>
 #include <sstream>
 #include <string>
 #include <locale>
 #include <limits>
 
+// Arithmetic conversions with the classic locale bypass the streams where
+// <charconv> is available. Define BOOST_PROPERTY_TREE_NO_CHARCONV to
+// always use the streams.
+#if !defined(BOOST_PROPERTY_TREE_NO_CHARCONV) && \
+    !defined(BOOST_PROPERTY_TREE_USE_CHARCONV) && defined(__has_include)
+#if __has_include(<charconv>) && (__cplusplus >= 201703L || \
+    (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#define BOOST_PROPERTY_TREE_USE_CHARCONV
+#endif
+#endif
+
+#if defined(BOOST_PROPERTY_TREE_USE_CHARCONV)
+#include <boost/type_traits/is_floating_point.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <system_error>
+#endif
+
 namespace boost { namespace property_tree
 {
 
     template <typename Ch, typename Traits, typename E, typename Enabler = void>
     struct customize_stream
     {
+        // Marks the conversions that come with the library. Only these are
+        // replaced by the locale-free fast path of stream_translator.
+        typedef void library_conversion;
+
         static void insert(std::basic_ostream<Ch, Traits>& s, const E& e) {
             s << e;
         }
@@ -44,6 +68,8 @@ namespace boost { namespace property_tree
     template <typename Ch, typename Traits>
     struct customize_stream<Ch, Traits, Ch, void>
     {
+        typedef void library_conversion;
+
         static void insert(std::basic_ostream<Ch, Traits>& s, Ch e) {
             s << e;
         }
@@ -93,6 +119,8 @@ namespace boost { namespace property_tree
         typename boost::enable_if< detail::is_inexact<F> >::type
     >
     {
+        typedef void library_conversion;
+
         static void insert(std::basic_ostream<Ch, Traits>& s, const F& e) {
 #ifndef BOOST_NO_CXX11_NUMERIC_LIMITS 
             s.precision(std::numeric_limits<F>::max_digits10); 
@@ -112,6 +140,8 @@ namespace boost { namespace property_tree
     template <typename Ch, typename Traits>
     struct customize_stream<Ch, Traits, bool, void>
     {
+        typedef void library_conversion;
+
         static void insert(std::basic_ostream<Ch, Traits>& s, bool e) {
             s.setf(std::ios_base::boolalpha);
             s << e;
@@ -133,6 +163,8 @@ namespace boost { namespace property_tree
     template <typename Ch, typename Traits>
     struct customize_stream<Ch, Traits, signed char, void>
     {
+        typedef void library_conversion;
+
         static void insert(std::basic_ostream<Ch, Traits>& s, signed char e) {
             s << (int)e;
         }
@@ -158,6 +190,8 @@ namespace boost { namespace property_tree
     template <typename Ch, typename Traits>
     struct customize_stream<Ch, Traits, unsigned char, void>
     {
+        typedef void library_conversion;
+
         static void insert(std::basic_ostream<Ch, Traits>& s, unsigned char e) {
             s << (unsigned)e;
         }
@@ -178,20 +212,244 @@ namespace boost { namespace property_tree
         }
     };
 
+    namespace detail
+    {
+        // Locale-free conversions of arithmetic types, for narrow strings
+        // and the classic locale. Where they succeed, they give the same
+        // results as the library's customize_stream; anything else (a
+        // leading '+', overflow, "inf", ...) is left to the streams.
+        enum fast_result { fast_ok, fast_fail, fast_fallback };
+
+        template <typename E, typename Enabler = void>
+        struct fast_convert
+        {
+            static const bool enabled = false;
+        };
+
+#if defined(BOOST_PROPERTY_TREE_USE_CHARCONV)
+        // Whitespace as the classic locale defines it.
+        inline bool fast_is_space(char c) {
+            return c == ' ' || (c >= '\t' && c <= '\r');
+        }
+        inline const char *fast_skip_space(const char *p, const char *e) {
+            while (p != e && fast_is_space(*p)) {
+                ++p;
+            }
+            return p;
+        }
+
+        template <typename N>
+        fast_result fast_parse(const char *first, const char *last, N &n) {
+            first = fast_skip_space(first, last);
+            std::from_chars_result r = std::from_chars(first, last, n);
+            if (r.ec != std::errc() || fast_skip_space(r.ptr, last) != last) {
+                return fast_fallback;
+            }
+            return fast_ok;
+        }
+
+        template <typename E>
+        struct is_fast_integer : boost::false_type {};
+        template <> struct is_fast_integer<short> : boost::true_type {};
+        template <> struct is_fast_integer<unsigned short>
+            : boost::true_type {};
+        template <> struct is_fast_integer<int> : boost::true_type {};
+        template <> struct is_fast_integer<unsigned int>
+            : boost::true_type {};
+        template <> struct is_fast_integer<long> : boost::true_type {};
+        template <> struct is_fast_integer<unsigned long>
+            : boost::true_type {};
+        template <> struct is_fast_integer<long long> : boost::true_type {};
+        template <> struct is_fast_integer<unsigned long long>
+            : boost::true_type {};
+
+        template <typename I>
+        struct fast_convert<I,
+            typename boost::enable_if< is_fast_integer<I> >::type>
+        {
+            static const bool enabled = true;
+            static fast_result get(const char *first, const char *last,
+                                   I &i) {
+                return fast_parse(first, last, i);
+            }
+            static char *put(I i, char *first, char *last) {
+                std::to_chars_result r = std::to_chars(first, last, i);
+                return r.ec == std::errc() ? r.ptr : 0;
+            }
+        };
+
+        // Small integers are read as int or unsigned, then range checked.
+        template <typename C, typename Wide>
+        struct fast_convert_small
+        {
+            static const bool enabled = true;
+            static fast_result get(const char *first, const char *last,
+                                   C &c) {
+                Wide w;
+                fast_result r = fast_parse(first, last, w);
+                if (r != fast_ok) {
+                    return r;
+                }
+                if (w > (std::numeric_limits<C>::max)() ||
+                    w < (std::numeric_limits<C>::min)()) {
+                    return fast_fail;
+                }
+                c = static_cast<C>(w);
+                return fast_ok;
+            }
+            static char *put(C c, char *first, char *last) {
+                std::to_chars_result r =
+                    std::to_chars(first, last, static_cast<Wide>(c));
+                return r.ec == std::errc() ? r.ptr : 0;
+            }
+        };
+        template <>
+        struct fast_convert<signed char>
+            : fast_convert_small<signed char, int> {};
+        template <>
+        struct fast_convert<unsigned char>
+            : fast_convert_small<unsigned char, unsigned> {};
+
+        // 0 and 1, or the words.
+        template <>
+        struct fast_convert<bool>
+        {
+            static const bool enabled = true;
+            static fast_result get(const char *first, const char *last,
+                                   bool &b) {
+                first = fast_skip_space(first, last);
+                while (first != last && fast_is_space(last[-1])) {
+                    --last;
+                }
+                const std::size_t n = static_cast<std::size_t>(last - first);
+                if (n == 1 && (*first == '0' || *first == '1')) {
+                    b = *first == '1';
+                } else if (n == 4 && std::char_traits<char>::compare(
+                                        first, "true", 4) == 0) {
+                    b = true;
+                } else if (n == 5 && std::char_traits<char>::compare(
+                                        first, "false", 5) == 0) {
+                    b = false;
+                } else {
+                    return fast_fallback;
+                }
+                return fast_ok;
+            }
+            static char *put(bool b, char *first, char *last) {
+                const char *s = b ? "true" : "false";
+                const std::size_t n = b ? 4 : 5;
+                if (static_cast<std::size_t>(last - first) < n) {
+                    return 0;
+                }
+                return std::copy(s, s + n, first);
+            }
+        };
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        // Written like the streams do with max_digits10 precision, i.e.
+        // like printf's %g. Infinities and NaNs are left to the streams.
+        template <typename F>
+        struct fast_convert<F,
+            typename boost::enable_if< boost::is_floating_point<F> >::type>
+        {
+            static const bool enabled = true;
+            static fast_result get(const char *first, const char *last,
+                                   F &f) {
+                fast_result r = fast_parse(first, last, f);
+                if (r == fast_ok && !std::isfinite(f)) {
+                    return fast_fallback;
+                }
+                return r;
+            }
+            static char *put(F f, char *first, char *last) {
+                if (!std::isfinite(f)) {
+                    return 0;
+                }
+                std::to_chars_result r = std::to_chars(first, last, f,
+                    std::chars_format::general,
+                    std::numeric_limits<F>::max_digits10);
+                return r.ec == std::errc() ? r.ptr : 0;
+            }
+        };
+#endif
+#endif
+
+        template <typename C, typename Enabler = void>
+        struct is_library_conversion : boost::false_type {};
+        template <typename C>
+        struct is_library_conversion<C, typename C::library_conversion>
+            : boost::true_type {};
+
+        // Whether stream_translator<Ch, Traits, Alloc, E> can take the fast
+        // path: user customizations of customize_stream must still be used.
+        template <typename Ch, typename Traits, typename E>
+        struct has_fast_conversion
+        {
+            static const bool value = boost::is_same<Ch, char>::value &&
+                fast_convert<E>::enabled &&
+                is_library_conversion<
+                    customize_stream<Ch, Traits, E> >::value;
+        };
+
+        template <bool Enabled>
+        struct fast_translate
+        {
+            template <typename Str, typename E>
+            static fast_result get(const Str &, E &) {
+                return fast_fallback;
+            }
+            template <typename Str, typename E>
+            static bool put(const E &, Str &) {
+                return false;
+            }
+        };
+        template <>
+        struct fast_translate<true>
+        {
+            template <typename Str, typename E>
+            static fast_result get(const Str &s, E &e) {
+                return fast_convert<E>::get(s.data(), s.data() + s.size(), e);
+            }
+            template <typename Str, typename E>
+            static bool put(const E &e, Str &s) {
+                char buf[64];
+                char *end = fast_convert<E>::put(e, buf, buf + sizeof(buf));
+                if (!end) {
+                    return false;
+                }
+                s.assign(buf, end);
+                return true;
+            }
+        };
+    }
+
     /// Implementation of Translator that uses the stream overloads.
+    /// With the classic locale, arithmetic types that use the library's own
+    /// customize_stream are converted without a stream where possible.
     template <typename Ch, typename Traits, typename Alloc, typename E>
     class stream_translator
     {
         typedef customize_stream<Ch, Traits, E> customized;
+        typedef detail::has_fast_conversion<Ch, Traits, E> has_fast;
+        typedef detail::fast_translate<has_fast::value> fast;
     public:
         typedef std::basic_string<Ch, Traits, Alloc> internal_type;
         typedef E external_type;
 
         explicit stream_translator(std::locale loc = std::locale())
-            : m_loc(loc)
+            : m_loc(loc),
+              m_fast(has_fast::value && loc == std::locale::classic())
         {}
 
         boost::optional<E> get_value(const internal_type &v) {
+            if(m_fast) {
+                E e;
+                switch(fast::get(v, e)) {
+                case detail::fast_ok: return e;
+                case detail::fast_fail: return boost::optional<E>();
+                case detail::fast_fallback: break;
+                }
+            }
             std::basic_istringstream<Ch, Traits, Alloc> iss(v);
             iss.imbue(m_loc);
             E e;
@@ -202,6 +460,12 @@ namespace boost { namespace property_tree
             return e;
         }
         boost::optional<internal_type> put_value(const E &v) {
+            if(m_fast) {
+                internal_type s;
+                if(fast::put(v, s)) {
+                    return s;
+                }
+            }
             std::basic_ostringstream<Ch, Traits, Alloc> oss;
             oss.imbue(m_loc);
             customized::insert(oss, v);
@@ -213,6 +477,7 @@ namespace boost { namespace property_tree
 
     private:
         std::locale m_loc;
+        bool m_fast;
     };
 
     // This is the default translator when basic_string is the internal type.
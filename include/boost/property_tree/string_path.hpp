@@ -24,11 +24,19 @@
 #include <algorithm>
 #include <string>
 #include <iterator>
+#include <utility>
 
 namespace boost { namespace property_tree
 {
     namespace detail
     {
+        template <typename Ch, typename Traits, typename Alloc, typename Tr>
+        string_path<std::basic_string<Ch, Traits, Alloc>, Tr> walk_copy(
+            const string_path<std::basic_string<Ch, Traits, Alloc>, Tr> &p);
+
+        template <typename Path>
+        Path borrow_path(const typename Path::char_type *value);
+
         template <typename Sequence, typename Iterator>
         void append_and_preserve_iter(Sequence &s, const Sequence &r,
                                       Iterator &, std::forward_iterator_tag)
@@ -86,6 +94,7 @@ namespace boost { namespace property_tree
     public:
         typedef typename Translator::external_type key_type;
         typedef typename String::value_type char_type;
+        typedef Translator translator_type;
 
         /// Create an empty path.
         explicit string_path(char_type separator = char_type('.'));
@@ -112,10 +121,20 @@ namespace boost { namespace property_tree
         // Default copying doesn't do the right thing with the iterator
         string_path(const string_path &o);
         string_path& operator =(const string_path &o);
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+        // Moving keeps a borrowed array borrowed.
+        string_path(string_path &&o);
+#endif
 
         /// Take a single element off the path at the front and return it.
         key_type reduce();
 
+        /// Take a single element off the path at the front and return the
+        /// range of values it consists of, without translating it. The range
+        /// stays valid as long as the path's value does. Only available if
+        /// @c String stores its values contiguously, like std::basic_string.
+        std::pair<const char_type *, const char_type *> reduce_range();
+
         /// Test if the path is empty.
         bool empty() const;
 
@@ -126,6 +145,9 @@ namespace boost { namespace property_tree
         char_type separator() const { return m_separator; }
 
         std::string dump() const {
+            if(borrowed()) {
+                return detail::dump_sequence(String(m_first, m_last));
+            }
             return detail::dump_sequence(m_value);
         }
 
@@ -144,7 +166,12 @@ namespace boost { namespace property_tree
                 if(!this->empty()) {
                     sub.push_back(m_separator);
                 }
-                sub.insert(sub.end(), o.cstart(), o.m_value.end());
+                if(o.borrowed()) {
+                    sub.insert(sub.end(), o.m_cur, o.m_last);
+                } else {
+                    sub.insert(sub.end(), o.cstart(), o.m_value.end());
+                }
+                own();
                 detail::append_and_preserve_iter(m_value, sub, m_start,
                     typename std::iterator_traits<s_iter>::iterator_category());
             }
@@ -158,12 +185,34 @@ namespace boost { namespace property_tree
         char_type m_separator;
         Translator m_tr;
         s_iter m_start;
+        // A path created from an array only refers to it, in
+        // [m_first, m_last); m_cur is where the rest of the path starts.
+        // m_value is unused then.
+        const char_type *m_first;
+        const char_type *m_cur;
+        const char_type *m_last;
+
+        template <typename Ch, typename Traits, typename Alloc, typename Tr>
+        friend string_path<std::basic_string<Ch, Traits, Alloc>, Tr>
+            detail::walk_copy(const string_path<
+                std::basic_string<Ch, Traits, Alloc>, Tr> &p);
+        template <typename Path>
+        friend Path detail::borrow_path(const typename Path::char_type *value);
+        struct borrow_tag {};
+        string_path(const char_type *first, const char_type *cur,
+                    const char_type *last, char_type separator,
+                    const Translator &tr, borrow_tag);
+
+        bool borrowed() const { return m_first != 0; }
         s_c_iter cstart() const { return m_start; }
+        void own();
+        void copy_from(const string_path &o);
     };
 
     template <typename String, typename Translator> inline
     string_path<String, Translator>::string_path(char_type separator)
-        : m_separator(separator), m_start(m_value.begin())
+        : m_separator(separator), m_start(m_value.begin()),
+          m_first(0), m_cur(0), m_last(0)
     {}
 
     template <typename String, typename Translator> inline
@@ -171,7 +220,8 @@ namespace boost { namespace property_tree
                                                  char_type separator,
                                                  Translator tr)
         : m_value(value), m_separator(separator),
-          m_tr(tr), m_start(m_value.begin())
+          m_tr(tr), m_start(m_value.begin()),
+          m_first(0), m_cur(0), m_last(0)
     {}
 
     template <typename String, typename Translator> inline
@@ -179,34 +229,104 @@ namespace boost { namespace property_tree
                                                  char_type separator,
                                                  Translator tr)
         : m_value(value), m_separator(separator),
-          m_tr(tr), m_start(m_value.begin())
+          m_tr(tr), m_start(m_value.begin()),
+          m_first(0), m_cur(0), m_last(0)
+    {}
+
+    template <typename String, typename Translator> inline
+    string_path<String, Translator>::string_path(const char_type *first,
+                                                 const char_type *cur,
+                                                 const char_type *last,
+                                                 char_type separator,
+                                                 const Translator &tr,
+                                                 borrow_tag)
+        : m_separator(separator), m_tr(tr), m_start(m_value.begin()),
+          m_first(first), m_cur(cur), m_last(last)
     {}
 
     template <typename String, typename Translator> inline
     string_path<String, Translator>::string_path(const string_path &o)
-        : m_value(o.m_value), m_separator(o.m_separator),
-          m_tr(o.m_tr), m_start(m_value.begin())
+        : m_separator(o.m_separator), m_tr(o.m_tr),
+          m_first(0), m_cur(0), m_last(0)
+    {
+        copy_from(o);
+    }
+
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+    template <typename String, typename Translator> inline
+    string_path<String, Translator>::string_path(string_path &&o)
+        : m_separator(o.m_separator), m_tr(o.m_tr), m_start(m_value.begin()),
+          m_first(o.m_first), m_cur(o.m_cur), m_last(o.m_last)
     {
-        std::advance(m_start, std::distance(o.m_value.begin(), o.cstart()));
+        if(!borrowed()) {
+            typename std::iterator_traits<s_iter>::difference_type idx =
+                std::distance(o.m_value.begin(), o.m_start);
+            m_value.swap(o.m_value);
+            m_start = m_value.begin();
+            std::advance(m_start, idx);
+            o.m_start = o.m_value.begin();
+        }
     }
+#endif
 
     template <typename String, typename Translator> inline
     string_path<String, Translator>&
     string_path<String, Translator>::operator =(const string_path &o)
     {
-        m_value = o.m_value;
-        m_separator = o.m_separator;
-        m_tr = o.m_tr;
-        m_start = m_value.begin();
-        std::advance(m_start, std::distance(o.m_value.begin(), o.cstart()));
+        if(this != &o) {
+            m_separator = o.m_separator;
+            m_tr = o.m_tr;
+            m_first = m_cur = m_last = 0;
+            copy_from(o);
+        }
         return *this;
     }
 
+    template <typename String, typename Translator> inline
+    void string_path<String, Translator>::copy_from(const string_path &o)
+    {
+        if(o.borrowed()) {
+            m_value.assign(o.m_first, o.m_last);
+            m_start = m_value.begin();
+            std::advance(m_start, o.m_cur - o.m_first);
+        } else {
+            m_value = o.m_value;
+            m_start = m_value.begin();
+            std::advance(m_start,
+                         std::distance(o.m_value.begin(), o.cstart()));
+        }
+    }
+
+    template <typename String, typename Translator> inline
+    void string_path<String, Translator>::own()
+    {
+        if(borrowed()) {
+            m_value.assign(m_first, m_last);
+            m_start = m_value.begin();
+            std::advance(m_start, m_cur - m_first);
+            m_first = m_cur = m_last = 0;
+        }
+    }
+
     template <typename String, typename Translator>
     typename Translator::external_type string_path<String, Translator>::reduce()
     {
         BOOST_ASSERT(!empty() && "Reducing empty path");
 
+        if(borrowed()) {
+            const char_type *next_sep = std::find(m_cur, m_last, m_separator);
+            String part(m_cur, next_sep);
+            m_cur = next_sep;
+            if(!empty()) {
+              ++m_cur;
+            }
+            if(optional<key_type> key = m_tr.get_value(part)) {
+                return *key;
+            }
+            BOOST_PROPERTY_TREE_THROW(ptree_bad_path("Path syntax error",
+                                                     *this));
+        }
+
         s_iter next_sep = std::find(m_start, m_value.end(), m_separator);
         String part(m_start, next_sep);
         m_start = next_sep;
@@ -221,20 +341,117 @@ namespace boost { namespace property_tree
         BOOST_PROPERTY_TREE_THROW(ptree_bad_path("Path syntax error", *this));
     }
 
+    template <typename String, typename Translator>
+    std::pair<typename String::value_type const *,
+              typename String::value_type const *>
+    string_path<String, Translator>::reduce_range()
+    {
+        BOOST_ASSERT(!empty() && "Reducing empty path");
+
+        const char_type *cur, *last;
+        if(borrowed()) {
+            cur = m_cur;
+            last = m_last;
+        } else {
+            cur = m_value.data() + (m_start - m_value.begin());
+            last = m_value.data() + m_value.size();
+        }
+        const char_type *next_sep = std::find(cur, last, m_separator);
+        std::pair<const char_type *, const char_type *> part(cur, next_sep);
+        if(next_sep != last) {
+            // Unless we're at the end, skip the separator we found.
+            ++next_sep;
+        }
+        if(borrowed()) {
+            m_cur = next_sep;
+        } else {
+            m_start += next_sep - cur;
+        }
+        return part;
+    }
+
     template <typename String, typename Translator> inline
     bool string_path<String, Translator>::empty() const
     {
+        if(borrowed()) {
+            return m_cur == m_last;
+        }
         return m_start == m_value.end();
     }
 
     template <typename String, typename Translator> inline
     bool string_path<String, Translator>::single() const
     {
+        if(borrowed()) {
+            return std::find(m_cur, m_last, m_separator) == m_last;
+        }
         return std::find(static_cast<s_c_iter>(m_start),
                          m_value.end(), m_separator)
             == m_value.end();
     }
 
+    namespace detail
+    {
+        // A copy of the path for walking it, i.e. reducing it. Paths over
+        // std::basic_string just refer to the original's values.
+        template <typename Path> inline
+        const Path &walk_copy(const Path &p)
+        {
+            return p;
+        }
+        template <typename Ch, typename Traits, typename Alloc, typename Tr>
+        inline string_path<std::basic_string<Ch, Traits, Alloc>, Tr>
+        walk_copy(
+            const string_path<std::basic_string<Ch, Traits, Alloc>, Tr> &p)
+        {
+            typedef string_path<std::basic_string<Ch, Traits, Alloc>, Tr>
+                path_type;
+            if(p.borrowed()) {
+                return path_type(p.m_first, p.m_cur, p.m_last,
+                    p.m_separator, p.m_tr, typename path_type::borrow_tag());
+            }
+            const Ch *first = p.m_value.data();
+            return path_type(first,
+                first + (p.cstart() - p.m_value.begin()),
+                first + p.m_value.size(), p.m_separator, p.m_tr,
+                typename path_type::borrow_tag());
+        }
+    }
+
+    namespace detail
+    {
+        // A path with the default separator that refers to the
+        // zero-terminated array instead of copying it. basic_ptree uses it
+        // for the duration of a lookup by a literal path.
+        template <typename Path>
+        Path borrow_path(const typename Path::char_type *value)
+        {
+            const typename Path::char_type *last = value;
+            while(*last != typename Path::char_type()) {
+                ++last;
+            }
+            return Path(value, value, last,
+                typename Path::char_type('.'),
+                typename Path::translator_type(),
+                typename Path::borrow_tag());
+        }
+
+        // The character type of the paths that can be borrowed, or an
+        // unusable type for paths that cannot.
+        struct no_path_chars;
+        template <typename Path>
+        struct path_chars
+        {
+            typedef no_path_chars type;
+        };
+        template <typename Ch, typename Traits, typename Alloc, typename Tr>
+        struct path_chars<
+            string_path<std::basic_string<Ch, Traits, Alloc>, Tr> >
+        {
+            typedef Ch type;
+        };
+    }
+
     // By default, this is the path for strings. You can override this by
     // specializing path_of for a more specific form of std::basic_string.
     template <typename Ch, typename Traits, typename Alloc>
@@ -17,7 +17,9 @@
 #include <boost/property_tree/detail/xml_parser_writer_settings.hpp>
 #include <boost/property_tree/detail/xml_parser_flags.hpp>
 #include <boost/property_tree/detail/xml_parser_read_rapidxml.hpp>
+#include <boost/property_tree/detail/xml_parser_read_elements.hpp>
 
+#include <cstddef>
 #include <fstream>
 #include <string>
 #include <locale>
@@ -52,6 +54,85 @@ namespace boost { namespace property_tree { namespace xml_parser
         read_xml_internal(stream, pt, flags, std::string());
     }
 
+    /**
+     * Reads XML from a buffer owned by the caller and translates it to
+     * property tree. The text is parsed in place, without copying it first,
+     * which makes this the fastest way to read a document that is already
+     * in memory.
+     * @note Clears existing contents of property tree.  In case of error the
+     *       property tree unmodified.
+     * @note The parser modifies the buffer; its contents are unspecified
+     *       afterwards.
+     * @throw xml_parser_error In case of error deserializing the property tree.
+     * @param text The XML text, followed by a null character at
+     *             @c text[size]. Parsing stops at the first null character.
+     * @param size The length of the text.
+     * @param[out] pt The property tree to populate.
+     * @param flags Flags controlling the behaviour of the parser, as for
+     *              reading from a stream.
+     */
+    template<class Ptree>
+    void read_xml(typename Ptree::key_type::value_type *text,
+                  std::size_t size,
+                  Ptree &pt,
+                  int flags = 0)
+    {
+        BOOST_ASSERT(validate_flags(flags));
+        BOOST_ASSERT(text[size] == typename Ptree::key_type::value_type());
+        xml_reader_context<typename Ptree::key_type::value_type> context;
+        read_xml_internal(text, size, pt, flags, std::string(), context);
+    }
+
+    /**
+     * Reads XML from an input stream and translates it to property tree,
+     * reusing the memory held by @p context. See the overload without a
+     * context for details.
+     * @throw xml_parser_error In case of error deserializing the property tree.
+     * @param stream Stream from which to read in the property tree.
+     * @param[out] pt The property tree to populate.
+     * @param context Memory to reuse from earlier calls.
+     * @param flags Flags controlling the behaviour of the parser.
+     */
+    template<class Ptree>
+    void read_xml(std::basic_istream<
+                      typename Ptree::key_type::value_type
+                  > &stream,
+                  Ptree &pt,
+                  xml_reader_context<
+                      typename Ptree::key_type::value_type
+                  > &context,
+                  int flags = 0)
+    {
+        BOOST_ASSERT(validate_flags(flags));
+        read_xml_internal(stream, pt, flags, std::string(), context);
+    }
+
+    /**
+     * Reads XML in place from a buffer owned by the caller and translates
+     * it to property tree, reusing the memory held by @p context. See the
+     * overload without a context for details.
+     * @throw xml_parser_error In case of error deserializing the property tree.
+     * @param text The XML text, followed by a null character at
+     *             @c text[size].
+     * @param size The length of the text.
+     * @param[out] pt The property tree to populate.
+     * @param context Memory to reuse from earlier calls.
+     * @param flags Flags controlling the behaviour of the parser.
+     */
+    template<class Ptree>
+    void read_xml(typename Ptree::key_type::value_type *text,
+                  std::size_t size,
+                  Ptree &pt,
+                  xml_reader_context<
+                      typename Ptree::key_type::value_type
+                  > &context,
+                  int flags = 0)
+    {
+        BOOST_ASSERT(validate_flags(flags));
+        BOOST_ASSERT(text[size] == typename Ptree::key_type::value_type());
+        read_xml_internal(text, size, pt, flags, std::string(), context);
+    }
+
     /**
      * Reads XML from a file using the given locale and translates it to
      * property tree.
@@ -85,6 +166,65 @@ namespace boost { namespace property_tree { namespace xml_parser
         read_xml_internal(stream, pt, flags, filename);
     }
 
+    /**
+     * Reads the elements with the given name from an XML stream one at a
+     * time, and passes each to @p callback as a property tree, without
+     * holding the whole document in memory. See xml_element_reader.
+     * @throw xml_parser_error In case of error deserializing an element.
+     *                         The elements before it have been passed to
+     *                         @p callback.
+     * @param stream Stream from which to read the document.
+     * @param name The name of the elements to read.
+     * @param callback Called as @c callback(pt) with a non-const reference
+     *                 to each element's tree, in document order.
+     * @param flags Flags controlling the behaviour of the parser, as for
+     *              read_xml.
+     */
+    template<class Ptree, class Callback>
+    void read_xml_elements(std::basic_istream<
+                               typename Ptree::key_type::value_type
+                           > &stream,
+                           const typename Ptree::key_type &name,
+                           Callback callback,
+                           int flags = 0)
+    {
+        xml_element_reader<Ptree> reader(stream, name, flags);
+        Ptree element;
+        while (reader.next(element))
+            callback(element);
+    }
+
+    /**
+     * Reads the elements with the given name from an XML file one at a
+     * time, using the given locale, and passes each to @p callback as a
+     * property tree. See xml_element_reader.
+     * @throw xml_parser_error In case of error deserializing an element.
+     * @param filename The file from which to read the document.
+     * @param name The name of the elements to read.
+     * @param callback Called as @c callback(pt) with each element's tree.
+     * @param flags Flags controlling the behaviour of the parser, as for
+     *              read_xml.
+     * @param loc The locale to use when reading in the file contents.
+     */
+    template<class Ptree, class Callback>
+    void read_xml_elements(const std::string &filename,
+                           const typename Ptree::key_type &name,
+                           Callback callback,
+                           int flags = 0,
+                           const std::locale &loc = std::locale())
+    {
+        std::basic_ifstream<typename Ptree::key_type::value_type>
+            stream(filename.c_str());
+        if (!stream)
+            BOOST_PROPERTY_TREE_THROW(xml_parser_error(
+                "cannot open file", filename, 0));
+        stream.imbue(loc);
+        xml_element_reader<Ptree> reader(stream, name, flags, filename);
+        Ptree element;
+        while (reader.next(element))
+            callback(element);
+    }
+
     /**
      * Translates the property tree to XML and writes it the given output
      * stream.
@@ -142,8 +282,11 @@ namespace boost { namespace property_tree { namespace xml_parser
 namespace boost { namespace property_tree
 {
     using xml_parser::read_xml;
+    using xml_parser::read_xml_elements;
     using xml_parser::write_xml;
     using xml_parser::xml_parser_error;
+    using xml_parser::xml_reader_context;
+    using xml_parser::xml_element_reader;
 
     using xml_parser::xml_writer_settings;
     using xml_parser::xml_writer_make_settings;
@@ -0,0 +1,171 @@
+// ----------------------------------------------------------------------------
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// For more information, see www.boost.org
+// ----------------------------------------------------------------------------
+
+#include "test_utils.hpp"
+#include <boost/property_tree/binary_parser.hpp>
+#include <sstream>
+#include <string>
+
+using namespace boost::property_tree;
+
+template<class Ptree>
+Ptree get_binary_test_ptree()
+{
+    typedef typename Ptree::key_type Str;
+    Ptree pt = get_test_ptree<Ptree>();
+    pt.add(detail::widen<Str>("list.item"), detail::widen<Str>("b"));
+    pt.add(detail::widen<Str>("list.item"), detail::widen<Str>("a"));
+    pt.add(detail::widen<Str>("list.other"), detail::widen<Str>("c"));
+    pt.add(detail::widen<Str>("list.item"), detail::widen<Str>("d"));
+    pt.put(detail::widen<Str>("number"), 42);
+    pt.put(detail::widen<Str>("empty"), Str());
+    pt.put(detail::widen<Str>("deep.a.b.c.d"), detail::widen<Str>("leaf"));
+    return pt;
+}
+
+template<class Ptree>
+void test_round_trip()
+{
+    Ptree pt = get_binary_test_ptree<Ptree>();
+    std::stringstream stream;
+    write_binary(stream, pt);
+    BOOST_TEST(stream.good());
+
+    Ptree pt2;
+    read_binary(stream, pt2);
+    BOOST_TEST(pt == pt2);
+
+    // An empty tree has only its root.
+    std::stringstream empty_stream;
+    write_binary(empty_stream, Ptree());
+    pt2 = pt;
+    read_binary(empty_stream, pt2);
+    BOOST_TEST(pt2 == Ptree());
+}
+
+template<class Ptree>
+void test_view()
+{
+    typedef typename Ptree::key_type Str;
+    typedef typename Str::value_type Ch;
+    typedef basic_binary_view<Ch> view;
+    typedef typename view::string_view_type string_view;
+
+    Ptree pt = get_binary_test_ptree<Ptree>();
+    std::stringstream stream;
+    write_binary(stream, pt);
+    std::string bytes = stream.str();
+    // Characters wider than a byte need aligned data.
+    std::vector<boost::uint64_t> aligned(bytes.size() / 8 + 1);
+    memcpy(&aligned[0], bytes.data(), bytes.size());
+
+    view root(&aligned[0], bytes.size());
+    Str data0 = detail::widen<Str>("data0");
+    BOOST_TEST(root.data() == string_view(data0.data(), data0.size()));
+    BOOST_TEST_EQ(root.size(), pt.size());
+
+    // Iteration is in document order.
+    typename Ptree::const_iterator expected = pt.begin();
+    for (typename view::const_iterator it = root.begin(); it != root.end();
+         ++it, ++expected) {
+        BOOST_TEST(Str(it->key().begin(), it->key().end()) ==
+                   expected->first);
+    }
+    BOOST_TEST(expected == pt.end());
+
+    // find returns the first child with the key, in document order.
+    Str item = detail::widen<Str>("item");
+    view list = root.get_child(detail::widen<Str>("list"));
+    BOOST_TEST_EQ(list.size(), 4u);
+    BOOST_TEST_EQ(list.count(string_view(item.data(), item.size())), 3u);
+    typename view::const_iterator found =
+        list.find(string_view(item.data(), item.size()));
+    BOOST_TEST(found == list.begin());
+    BOOST_TEST(found->template get_value<Str>() == detail::widen<Str>("b"));
+    Str missing = detail::widen<Str>("missing");
+    BOOST_TEST(list.find(string_view(missing.data(), missing.size())) ==
+               list.end());
+
+    BOOST_TEST_EQ(root.template get<int>(detail::widen<Str>("number")), 42);
+    BOOST_TEST_EQ(root.get(detail::widen<Str>("missing"), 7), 7);
+    BOOST_TEST(root.template get<Str>(detail::widen<Str>("deep.a.b.c.d")) ==
+               detail::widen<Str>("leaf"));
+    BOOST_TEST(root.template get<Str>(detail::widen<Str>("key1.key")) ==
+               detail::widen<Str>("data2"));
+    BOOST_TEST(root.get_child(detail::widen<Str>("empty")).data().empty());
+    BOOST_TEST(!root.get_child_optional(detail::widen<Str>("key1.nope")));
+    BOOST_TEST_THROWS(root.get_child(detail::widen<Str>("nope")),
+                      ptree_bad_path);
+    BOOST_TEST_THROWS(root.template get<int>(detail::widen<Str>("key1")),
+                      ptree_bad_data);
+}
+
+void test_file_round_trip()
+{
+    ptree pt = get_binary_test_ptree<ptree>();
+    const char *filename = "testbinary.bin";
+    write_binary(filename, pt);
+    ptree pt2;
+    read_binary(filename, pt2);
+    BOOST_TEST(pt == pt2);
+    remove(filename);
+}
+
+void test_errors()
+{
+    ptree pt = get_binary_test_ptree<ptree>();
+    ptree original = pt;
+
+    std::istringstream not_binary("[Section]\nkey=value\n");
+    BOOST_TEST_THROWS(read_binary(not_binary, pt), binary_parser_error);
+    BOOST_TEST(pt == original);
+
+    std::stringstream stream;
+    write_binary(stream, pt);
+    std::string bytes = stream.str();
+
+    // Data cut short is refused, not read past its end.
+    std::vector<boost::uint64_t> aligned(bytes.size() / 8 + 1);
+    memcpy(&aligned[0], bytes.data(), bytes.size());
+    BOOST_TEST_THROWS(binary_view(&aligned[0], bytes.size() - 1),
+                      binary_parser_error);
+
+    // The character size must match.
+#ifndef BOOST_NO_CWCHAR
+    BOOST_TEST_THROWS(wbinary_view(&aligned[0], bytes.size()),
+                      binary_parser_error);
+#endif
+
+    // Children that do not come after their parent would make the tree
+    // infinite.
+    boost::uint64_t nodes;
+    memcpy(&nodes, &aligned[0] + 3, sizeof(nodes));
+    boost::uint32_t first = 0;
+    memcpy(reinterpret_cast<char *>(&aligned[0]) + nodes + 8, &first,
+           sizeof(first));
+    BOOST_TEST_THROWS(read_binary(&aligned[0], bytes.size(), pt),
+                      binary_parser_error);
+    BOOST_TEST(pt == original);
+
+    BOOST_TEST_THROWS(read_binary("nonexistent.bin", pt),
+                      binary_parser_error);
+}
+
+int main()
+{
+    test_round_trip<ptree>();
+    test_round_trip<iptree>();
+    test_view<ptree>();
+#ifndef BOOST_NO_CWCHAR
+    test_round_trip<wptree>();
+    test_view<wptree>();
+#endif
+    test_file_round_trip();
+    test_errors();
+    return boost::report_errors();
+}
@@ -236,6 +236,56 @@ void test_info_parser()
 
 }
 
+// Included files are parsed once through a cache, and again when they
+// change.
+template<class Ptree>
+void test_include_cache()
+{
+    using namespace boost::property_tree;
+    typedef typename Ptree::key_type Str;
+    test_file outer("key1 data1\n"
+                    "#include \"testcache_inc.info\"\n"
+                    "key2\n{\n#include \"testcache_inc.info\"\n}\n",
+                    "testcache.info");
+    test_file inc("inc_key inc_data\n"
+                  "#include \"testcache_inner.info\"\n",
+                  "testcache_inc.info");
+    info_include_cache<Ptree> cache;
+    Ptree pt;
+    {
+        test_file inner("inner \"value\"\n", "testcache_inner.info");
+        for (int i = 0; i < 3; ++i) {
+            Ptree expected;
+            read_info("testcache.info", expected);
+            read_info("testcache.info", pt, cache);
+            BOOST_TEST(pt == expected);
+            BOOST_TEST_EQ(cache.size(), 2u);
+        }
+    }
+
+    // A changed file deep down is read again.
+    {
+        test_file inner("inner \"changed value\"\n", "testcache_inner.info");
+        read_info("testcache.info", pt, cache);
+        BOOST_TEST(pt.template get<Str>(detail::widen<Str>("key2.inner")) ==
+                   detail::widen<Str>("changed value"));
+    }
+
+    // Errors are reported in the included file.
+    {
+        test_file inner("inner \"bad \\q\"\n", "testcache_inner.info");
+        try {
+            read_info("testcache.info", pt, cache);
+            BOOST_ERROR("No required exception thrown");
+        } catch (info_parser_error &e) {
+            BOOST_TEST(e.filename() == "testcache_inner.info");
+            BOOST_TEST_EQ(e.line(), 1u);
+        }
+    }
+    BOOST_TEST_THROWS(read_info("testcache.info", pt, cache),
+                      info_parser_error);
+}
+
 int main()
 {
     using namespace boost::property_tree;
@@ -244,6 +294,10 @@ int main()
 #ifndef BOOST_NO_CWCHAR
     test_info_parser<wptree>();
     test_info_parser<wiptree>();
+#endif
+    test_include_cache<ptree>();
+#ifndef BOOST_NO_CWCHAR
+    test_include_cache<wptree>();
 #endif
     return boost::report_errors();
 }
@@ -287,6 +287,84 @@ void test_duplicate_empty_name_section()
   BOOST_CHECK_THROW(read_ini(stringStreamInput, result), ini_parser_error);
 }
 
+// Reading text in memory gives the same tree and errors as reading a
+// stream, also with Windows line ends and no final line end.
+void test_read_from_memory()
+{
+    const char *docs[] = {
+        ok_data_1, ok_data_2, ok_data_3, ok_data_4, ok_data_5, ok_data_6,
+        ok_data_7, ok_data_8, error_data_1, error_data_2, error_data_3,
+        "# a\r\n# b\r\n[ S ]\r\n#k\r\nK = V \r\nx=\r\n[E]\r\n[F]\r\na=b"
+    };
+    for (std::size_t i = 0; i < sizeof(docs) / sizeof(*docs); ++i)
+    {
+        std::string text(docs[i]);
+        ptree expected, pt;
+        unsigned long line = 0;
+        try {
+            std::istringstream stream(text);
+            read_ini(stream, expected);
+        } catch (ini_parser_error &e) {
+            line = e.line();
+        }
+        try {
+            read_ini(text.data(), text.data() + text.size(), pt);
+            BOOST_TEST(line == 0);
+            BOOST_TEST(pt == expected);
+        } catch (ini_parser_error &e) {
+            BOOST_TEST_EQ(e.line(), line);
+        }
+    }
+
+    std::string crlf = docs[sizeof(docs) / sizeof(*docs) - 1];
+    ptree pt;
+    read_ini(crlf.data(), crlf.data() + crlf.size(), pt);
+    BOOST_TEST(pt.get("S.K", "bad") == "V");
+    BOOST_TEST(pt.get("S.K.inicomment", "bad") == "k");
+    BOOST_TEST(pt.get("S.K.inicomment_section", "bad") == " a\n b");
+    BOOST_TEST(pt.get("S.x", "bad") == "");
+    BOOST_TEST(pt.get("F.a", "bad") == "b");
+    BOOST_TEST(pt.count("E") == 0);
+
+    std::string error = "[S]\nK=1\n\nbroken\n";
+    try {
+        read_ini(error.data(), error.data() + error.size(), pt);
+        BOOST_ERROR("No required exception thrown");
+    } catch (ini_parser_error &e) {
+        BOOST_TEST_EQ(e.line(), 4u);
+    }
+}
+
+// The writer's exact output for comments, and no output for a tree that
+// cannot be written.
+void test_write_comments()
+{
+    ptree pt;
+    pt.put("top", "1");
+    pt.put("top.inicomment", "c1\n\nc2\r\n");
+    pt.put("s1.k", "v");
+    pt.put("s1.k.inicomment_section", "\nsec\r");
+    pt.put("s1.k.inicomment", "kc");
+    pt.put("s1.k2", "v2");
+    pt.put("s2.x", "");
+    std::stringstream stream;
+    write_ini(stream, pt);
+    BOOST_TEST(stream.str() ==
+        "#c1\n\n#c2\n\ntop = 1\n"
+        "\n\n#sec\n[s1]\n#kc\nk = v\nk2 = v2\n"
+        "\n[s2]\nx = \n");
+
+    ptree result;
+    read_ini(stream, result);
+    BOOST_TEST(result.get("s1.k2", "bad") == "v2");
+    BOOST_TEST(result.get("s1.k.inicomment", "bad") == "kc");
+
+    pt.put("s2.y.z", "too deep");
+    std::stringstream rejected;
+    BOOST_CHECK_THROW(write_ini(rejected, pt), ini_parser_error);
+    BOOST_TEST(rejected.str().empty());
+}
+
 int main()
 {
     test_ini_parser<ptree>();
@@ -300,6 +378,8 @@ int main()
     test_other_trees();
     test_empty_name_section();
     test_duplicate_empty_name_section();
+    test_read_from_memory();
+    test_write_comments();
     return boost::report_errors();
 
 }
@@ -10,6 +10,11 @@
 
 #include "test_utils.hpp"
 #include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/json_parser/lines.hpp>
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+#include <boost/property_tree/interned_string.hpp>
+#endif
+#include <algorithm>
 
 ///////////////////////////////////////////////////////////////////////////////
 // Test data
@@ -428,16 +433,482 @@ void test_escaping_wide()
         L"\\u043C\\u044B\\u043B\\u0430 \\u0440\\u0430\\u043C\\u0443");
 }
 
+void test_buffered_writing()
+{
+    using namespace boost::property_tree;
+    // Values longer than the writer's buffer, with escapes at the seams.
+    std::string big;
+    for (int i = 0; i < 5000; ++i) {
+        big += "abc\"de\\/\n\x01\xC3\xA9";
+    }
+    ptree pt;
+    ptree &deep = pt.put_child("a.b.c.d.e.f.g.h", ptree());
+    for (int i = 0; i < 100; ++i) {
+        deep.push_back(std::make_pair(std::string(), ptree(big)));
+    }
+    pt.put("key \"with\" escapes", "value");
+
+    for (int pretty = 0; pretty < 2; ++pretty) {
+        std::ostringstream out;
+        write_json(out, pt, pretty != 0);
+        std::istringstream in(out.str());
+        ptree back;
+        read_json(in, back);
+        BOOST_TEST(back == pt);
+    }
+
+    std::ostringstream value;
+    ptree single;
+    single.put("v", big);
+    write_json(value, single, false);
+    BOOST_TEST(value.str() ==
+               "{\"v\":\"" + json_parser::create_escapes(big) + "\"}\n");
+
+    // Nothing is written for a tree that cannot be represented, however
+    // late in the tree the problem is found.
+    ptree invalid = pt;
+    invalid.put("z.data", "x");
+    invalid.put("z.data.child", "y");
+    std::ostringstream staged;
+    staged << "prefix";
+    BOOST_TEST_THROWS(write_json(staged, invalid), json_parser_error);
+    BOOST_TEST(staged.str() == "prefix");
+    invalid.clear();
+    invalid.put_value("root data");
+    BOOST_TEST_THROWS(write_json(staged, invalid), json_parser_error);
+    BOOST_TEST(staged.str() == "prefix");
+
+    // Only nodes whose children are all unnamed are arrays.
+    ptree mixed;
+    mixed.push_back(std::make_pair(std::string(), ptree("1")));
+    mixed.push_back(std::make_pair(std::string("a"), ptree("2")));
+    ptree wrapped;
+    wrapped.add_child("m", mixed);
+    std::ostringstream object;
+    write_json(object, wrapped, false);
+    BOOST_TEST(object.str() == "{\"m\":{\"\":\"1\",\"a\":\"2\"}}\n");
+
+    // A stream that fails is reported.
+    std::ostringstream failed;
+    failed.setstate(std::ios_base::badbit);
+    BOOST_TEST_THROWS(write_json(failed, single), json_parser_error);
+}
+
+void test_pmr_tree()
+{
+#if defined(BOOST_PROPERTY_TREE_HAS_PMR)
+    // The whole document should end up in the target tree's resource.
+    std::pmr::monotonic_buffer_resource arena(
+        std::pmr::new_delete_resource());
+    boost::property_tree::pmr::ptree pt(&arena);
+    std::istringstream in(
+        "{\"a fairly long key name\": [1, 2, \"some long string value\"],"
+        " \"b\": {\"c\": true}}");
+    boost::property_tree::read_json(in, pt);
+    BOOST_TEST(pt.get_allocator().resource() == &arena);
+    const boost::property_tree::pmr::ptree &arr =
+        pt.get_child("a fairly long key name");
+    BOOST_TEST(arr.size() == 3u);
+    BOOST_TEST(arr.get_allocator().resource() == &arena);
+    BOOST_TEST(arr.back().second.data() == "some long string value");
+    BOOST_TEST(arr.back().second.data().get_allocator().resource() == &arena);
+    BOOST_TEST(pt.begin()->first.get_allocator().resource() == &arena);
+    BOOST_TEST(pt.get<bool>("b.c"));
+
+    std::ostringstream out;
+    boost::property_tree::write_json(out, pt, false);
+    BOOST_TEST(out.str() == "{\"a fairly long key name\":[\"1\",\"2\","
+                            "\"some long string value\"],"
+                            "\"b\":{\"c\":\"true\"}}\n");
+#endif
+}
+
+void test_read_from_memory()
+{
+    const char text[] = "{\"a\": {\"b\": [1, -2.5e3, \"c\\td\"]}, \"e\": null}";
+    boost::property_tree::ptree pt;
+    boost::property_tree::read_json(text, text + sizeof(text) - 1, pt);
+    BOOST_TEST(pt.get_child("a.b").size() == 3u);
+    BOOST_TEST(pt.get_child("a.b").front().second.data() == "1");
+    BOOST_TEST((++pt.get_child("a.b").begin())->second.get_value<double>() ==
+               -2500);
+    BOOST_TEST(pt.get_child("a.b").back().second.data() == "c\td");
+    BOOST_TEST(pt.get<std::string>("e") == "null");
+
+    // Only the given characters are parsed.
+    boost::property_tree::read_json(text + 12, text + 31, pt);
+    BOOST_TEST(pt.size() == 3u);
+    BOOST_TEST(pt.back().second.data() == "c\td");
+
+    try {
+        boost::property_tree::read_json(text, text + 10, pt);
+        BOOST_ERROR("No required exception thrown");
+    } catch (boost::property_tree::json_parser_error &) {
+    }
+}
+
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+void test_interned_keys()
+{
+    using namespace boost::property_tree;
+    const char text[] =
+        "{\"rows\": [{\"identifier\": 1, \"description\": \"first\"},"
+        " {\"identifier\": 2, \"description\": \"second\"}]}";
+    interned_ptree pt;
+    read_json(text, text + sizeof(text) - 1, pt);
+    const interned_ptree &rows = pt.get_child("rows");
+    BOOST_TEST_EQ(rows.size(), 2u);
+    BOOST_TEST_EQ(rows.back().second.get<int>("identifier"), 2);
+    BOOST_TEST(rows.back().second.get<std::string>("description") ==
+               "second");
+
+    // Equal keys share one string; values are not interned.
+    const interned_string &first = rows.front().second.front().first;
+    const interned_string &second = rows.back().second.front().first;
+    BOOST_TEST(first == second);
+    BOOST_TEST(first.data() == second.data());
+    BOOST_TEST(!interned_string::lookup("first", "first" + 5));
+
+    // Looking up a missing key does not add it to the pool.
+    const std::size_t pool = interned_string::pool_size();
+    BOOST_TEST(!pt.get_child_optional("rows.no_such_key"));
+    BOOST_TEST_EQ(interned_string::pool_size(), pool);
+
+    // The output is that of a tree with plain string keys.
+    ptree plain;
+    read_json(text, text + sizeof(text) - 1, plain);
+    std::ostringstream interned_out, plain_out;
+    write_json(interned_out, pt);
+    write_json(plain_out, plain);
+    BOOST_TEST(interned_out.str() == plain_out.str());
+}
+#endif
+
+void test_bulk_scanning()
+{
+    using boost::property_tree::ptree;
+    using boost::property_tree::json_parser_error;
+    // Long enough to span several vector blocks.
+    const std::string indent(70, ' ');
+    const std::string ascii(100, 'x');
+    const std::string utf8 = "\xD0\x9C\xD0\xB0 \xE2\x82\xAC \xF0\x9F\x98\x80";
+    const std::string text = "{" + indent + "\n\t\"a\"" + indent + ":" +
+        indent + "\"" + ascii + utf8 + ascii + "\\n" + ascii + "\"," +
+        indent + "\r\n\"b\": 12345678901234567890.25e-10" + indent + "}" +
+        indent;
+    ptree pt;
+    boost::property_tree::read_json(text.data(), text.data() + text.size(),
+                                    pt);
+    BOOST_TEST(pt.get<std::string>("a") == ascii + utf8 + ascii + "\n" + ascii);
+    BOOST_TEST(pt.get<std::string>("b") == "12345678901234567890.25e-10");
+
+    // Errors behind skipped input report the right line.
+    const char *const bad[] = {
+        "\"", "\"\x01\"", "\"\xC0\"", "\"\xE2\x82\"", "\"\x80\"",
+        "\"\xF8\x80\x80\x80\"", "1.", "\"\\q\""
+    };
+    for (std::size_t i = 0; i < sizeof(bad) / sizeof(*bad); ++i) {
+        const std::string doc = "[\n" + indent + "\n\"" + ascii + "\",\n" +
+            indent + bad[i] + "\n]";
+        try {
+            boost::property_tree::read_json(doc.data(),
+                                            doc.data() + doc.size(), pt);
+            BOOST_ERROR("No required exception thrown");
+        } catch (json_parser_error &e) {
+            BOOST_TEST(e.line() == 4u);
+        }
+    }
+}
+
+// Writes the events in a compact notation.
+template <typename Ch>
+struct recording_handler
+    : boost::property_tree::json_parser::basic_handler<Ch>
+{
+    typedef std::basic_string<Ch> string_type;
+    string_type events;
+
+    void on_null() { events += Ch('0'); }
+    void on_boolean(bool b) { events += b ? Ch('T') : Ch('F'); }
+    void on_number(const string_type &n) { events += Ch('#') + n; }
+    void on_string(const string_type &s) { events += Ch('"') + s; }
+    void on_key(const string_type &k) { events += Ch('.') + k; }
+    void on_begin_object() { events += Ch('{'); }
+    void on_end_object() { events += Ch('}'); }
+    void on_begin_array() { events += Ch('['); }
+    void on_end_array() { events += Ch(']'); }
+};
+
+// Only looks at some of the events.
+struct key_counter : boost::property_tree::json_parser::basic_handler<char>
+{
+    key_counter() : keys(0) {}
+    void on_key(const std::string &) { ++keys; }
+    int keys;
+};
+
+void test_sax()
+{
+    namespace json = boost::property_tree::json_parser;
+    const std::string text = "{\"a\": [1, -2.5e3, \"x\\ty\", {}, []],"
+        " \"b\": {\"c\": null, \"d\": true, \"e\": \"f\"}, \"g\": false}";
+    const std::string expected = "{.a[#1#-2.5e3\"x\ty{}[]].b{.c0.dT.e\"f}.gF}";
+
+    recording_handler<char> from_memory;
+    json::parse(text.data(), text.data() + text.size(), from_memory);
+    BOOST_TEST(from_memory.events == expected);
+
+    recording_handler<char> from_stream;
+    std::istringstream stream(text);
+    json::parse(stream, from_stream);
+    BOOST_TEST(from_stream.events == expected);
+
+    recording_handler<char> scalar;
+    const std::string number = " 42 ";
+    json::parse(number.begin(), number.end(), scalar);
+    BOOST_TEST(scalar.events == "#42");
+
+#ifndef BOOST_NO_CWCHAR
+    recording_handler<wchar_t> wide;
+    const std::wstring wtext = L"[{\"k\": \"v\"}, 7]";
+    json::parse(wtext.begin(), wtext.end(), wide);
+    BOOST_TEST(wide.events == L"[{.k\"v}#7]");
+#endif
+
+    key_counter counter;
+    json::parse(text.begin(), text.end(), counter);
+    BOOST_TEST(counter.keys == 6);
+
+    // The events before a syntax error have been reported.
+    recording_handler<char> partial;
+    const std::string bad = "[1, 2, x]";
+    try {
+        json::parse(bad.begin(), bad.end(), partial);
+        BOOST_ERROR("No required exception thrown");
+    } catch (json::json_parser_error &) {
+    }
+    BOOST_TEST(partial.events == "[#1#2");
+}
+
+// Feeds text to an incremental reader in pieces of the given size.
+template <class Ptree>
+void read_incrementally(const std::basic_string<
+                            typename Ptree::key_type::value_type> &text,
+                        std::size_t piece, Ptree &pt)
+{
+    boost::property_tree::json_parser::incremental_reader<Ptree> reader;
+    for (std::size_t i = 0; i < text.size(); i += piece) {
+        reader.feed(text.data() + i, (std::min)(piece, text.size() - i));
+    }
+    reader.finish(pt);
+}
+
+template <class Ptree>
+void test_incremental_reader(const typename Ptree::key_type::value_type
+                             *const *docs, std::size_t count)
+{
+    typedef typename Ptree::key_type::value_type char_type;
+    typedef std::basic_string<char_type> string;
+    const std::size_t pieces[] = { 1, 2, 3, 5, 7, 64, 4096 };
+    for (std::size_t d = 0; d < count; ++d) {
+        const string text(docs[d]);
+        Ptree expected;
+        std::string error;
+        unsigned long line = 0;
+        try {
+            boost::property_tree::read_json(text.data(),
+                text.data() + text.size(), expected);
+        } catch (boost::property_tree::json_parser_error &e) {
+            error = e.message();
+            line = e.line();
+        }
+        for (std::size_t p = 0; p < sizeof(pieces) / sizeof(*pieces); ++p) {
+            Ptree pt;
+            try {
+                read_incrementally(text, pieces[p], pt);
+                BOOST_TEST(error.empty());
+                BOOST_TEST(pt == expected);
+            } catch (boost::property_tree::json_parser_error &e) {
+                BOOST_TEST_EQ(e.message(), error);
+                BOOST_TEST_EQ(e.line(), line);
+            }
+        }
+    }
+}
+
+void test_incremental()
+{
+    using namespace boost::property_tree;
+    const char *const docs[] = {
+        "{\"a\": [1, -2.5e3, 0, 10E+2, 3.25e-1, -0.0], \"b\": {\"c\": null,"
+        " \"d\": true, \"e\": false}, \"\": \"\\\"\\\\\\/\\b\\f\\n\\r\\t\"}",
+        "\xEF\xBB\xBF [ \"\\u00e9\\uD83D\\uDE00 \xD0\x9C\xD0\xB0 \xE2\x82\xAC"
+        " \xF0\x9F\x98\x80\" ,{} , [], [[]], {\"x\":{}} ]\r\n",
+        "12345678901234567890", "  \"\"  ", "true", "null",
+        "\n\n{\"long key name\"  :  \"a long string value that spans pieces\"}",
+        // Errors
+        "", "   ", "nul", "tru", "fals", "truex", "-", "-a", "01", "1.", "1.e",
+        "1e", "1e+", "[", "[1", "[1,", "[1,]", "[1 2]", "{", "{1", "{\"a\"",
+        "{\"a\" 1", "{\"a\":", "{\"a\":1", "{\"a\":1,", "{\"a\":1 \"b\"}",
+        "\"abc", "\"\\", "\"\\q\"", "\"\\u12\"", "\"\\u12", "\"\\uDC00\"",
+        "\"\\uD800\"", "\"\\uD800\\", "\"\\uD800\\x", "\"\\uD800\\u0041\"",
+        "\"a\nb\"", "\"\x01\"", "\"\xC0\"", "\"\xE2\x82\"", "\"\xE2\x82",
+        "\"\x80\"", "\"\xF8\"", "[1]\n\n x", "\n[\n1,\n]", "+1", "[-]",
+    };
+    test_incremental_reader<ptree>(docs, sizeof(docs) / sizeof(*docs));
+    test_incremental_reader<iptree>(docs, sizeof(docs) / sizeof(*docs));
+
+#ifndef BOOST_NO_CWCHAR
+    const wchar_t *const wdocs[] = {
+        L"\xFEFF{\"a\": [1, -2.5e3], \"b\": \"\\u00e9\u00e9\\uD83D\\uDE00\"}",
+        L"[\"abc", L"\"\x01\"", L"{\"a\": tru}",
+    };
+    test_incremental_reader<wptree>(wdocs, sizeof(wdocs) / sizeof(*wdocs));
+#endif
+
+    // A reader can be used for one document after the other.
+    json_parser::incremental_reader<ptree> reader;
+    ptree first, second;
+    reader.feed("[1,", 3);
+    reader.feed(" 2]", 3);
+    reader.finish(first);
+    BOOST_TEST_EQ(first.size(), 2u);
+    reader.feed("{\"a\"", 4);
+    BOOST_TEST_THROWS(reader.finish(second), json_parser_error);
+    reader.reset();
+    reader.feed("{\"a\": 1}", 8);
+    reader.finish(second);
+    BOOST_TEST_EQ(second.get<int>("a"), 1);
+}
+
+struct collect_records
+{
+    explicit collect_records(std::vector<boost::property_tree::ptree> &out)
+        : out(&out) {}
+    void operator ()(boost::property_tree::ptree &pt) {
+        out->push_back(boost::property_tree::ptree());
+        out->back().swap(pt);
+    }
+    std::vector<boost::property_tree::ptree> *out;
+};
+
+bool by_index(const boost::property_tree::ptree &a,
+              const boost::property_tree::ptree &b)
+{
+    return a.get<int>("i") < b.get<int>("i");
+}
+
+void test_json_lines()
+{
+    using namespace boost::property_tree;
+    // Large enough to be split among threads.
+    std::string text;
+    std::vector<ptree> expected;
+    for (int i = 0; i < 3000; ++i) {
+        std::ostringstream line;
+        line << "{\"i\": " << i << ", \"name\": \"record " << i
+             << "\", \"tags\": [1, 2, 3]}";
+        if (i % 100 == 0) {
+            line << "\r";
+        }
+        text += line.str() + "\n";
+        if (i % 77 == 0) {
+            text += "  \n";
+        }
+        expected.push_back(ptree());
+        std::istringstream stream(line.str());
+        read_json(stream, expected.back());
+    }
+    const char *first = text.data(), *last = first + text.size();
+
+    for (unsigned threads = 0; threads <= 4; ++threads) {
+        std::vector<ptree> records(1);
+        read_json_lines(first, last, records, threads);
+        BOOST_TEST(records == expected);
+
+        std::vector<ptree> ordered;
+        read_json_lines<ptree>(first, last, collect_records(ordered),
+                               threads);
+        BOOST_TEST(ordered == expected);
+
+        std::vector<ptree> unordered;
+        read_json_lines<ptree>(first, last, collect_records(unordered),
+                               threads, false);
+        std::sort(unordered.begin(), unordered.end(), by_index);
+        BOOST_TEST(unordered == expected);
+    }
+
+    // A syntax error is reported with the line number in the whole input.
+    std::string bad = text;
+    std::string::size_type pos = 0;
+    std::size_t blank = 0;
+    for (int line = 1; line < 2000; ++line) {
+        if (bad[pos] == ' ') {
+            ++blank;
+        }
+        pos = bad.find('\n', pos) + 1;
+    }
+    bad.insert(pos, "{\"i\": 1,}\n");
+    for (unsigned threads = 1; threads <= 4; threads += 3) {
+        std::vector<ptree> records(1);
+        try {
+            read_json_lines(bad.data(), bad.data() + bad.size(), records,
+                            threads);
+            BOOST_ERROR("No required exception thrown");
+        } catch (json_parser_error &e) {
+            BOOST_TEST_EQ(e.line(), 2000u);
+            BOOST_TEST_EQ(e.message(), "expected key string");
+        }
+        BOOST_TEST_EQ(records.size(), 1u);
+
+        std::vector<ptree> delivered;
+        BOOST_TEST_THROWS(read_json_lines<ptree>(bad.data(),
+            bad.data() + bad.size(), collect_records(delivered), threads),
+            json_parser_error);
+        BOOST_TEST_EQ(delivered.size(), 1999u - blank);
+    }
+
+    {
+        test_file file("{\"a\": 1}\n\n[true]\n\"x\"", "testlines.json");
+        std::vector<ptree> records;
+        read_json_lines("testlines.json", records);
+        BOOST_TEST_EQ(records.size(), 3u);
+        BOOST_TEST_EQ(records[0].get<int>("a"), 1);
+        BOOST_TEST_EQ(records[1].front().second.data(), "true");
+        BOOST_TEST_EQ(records[2].data(), "x");
+    }
+    BOOST_TEST_THROWS(read_json_lines("nonexisting.json", expected),
+                      json_parser_error);
+
+#ifndef BOOST_NO_CWCHAR
+    const std::wstring wtext = L"{\"a\": \"\u00e9\"}\n[1, 2]\n";
+    std::vector<wptree> wrecords;
+    read_json_lines(wtext.data(), wtext.data() + wtext.size(), wrecords);
+    BOOST_TEST_EQ(wrecords.size(), 2u);
+    BOOST_TEST(wrecords[0].get<std::wstring>(L"a") == L"\u00e9");
+#endif
+}
+
 int main(int , char *[])
 {
     using namespace boost::property_tree;
     test_json_parser<ptree>();
     test_json_parser<iptree>();
     test_escaping_utf8();
+    test_read_from_memory();
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+    test_interned_keys();
+#endif
+    test_bulk_scanning();
+    test_sax();
+    test_incremental();
+    test_json_lines();
+    test_pmr_tree();
 #ifndef BOOST_NO_CWCHAR
     test_json_parser<wptree>();
     test_json_parser<wiptree>();
     test_escaping_wide();
+    test_buffered_writing();
 #endif
     return boost::report_errors();
 }
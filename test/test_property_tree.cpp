@@ -8,10 +8,17 @@
 // For more information, see www.boost.org
 // ----------------------------------------------------------------------------
 #include "test_utils.hpp"
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+#include <boost/property_tree/interned_string.hpp>
+#endif
 #include <boost/any.hpp>
 #include <boost/range.hpp>
 #include <list>
+#include <vector>
+#include <iterator>
 #include <cmath>
+#include <limits>
+#include <locale>
 
 // If using VC, disable some warnings that trip in boost::serialization bowels
 #ifdef BOOST_MSVC
@@ -26,6 +33,18 @@
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
 #include <boost/property_tree/ptree_serialization.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_nothrow_move_constructible.hpp>
+#include <boost/type_traits/declval.hpp>
+
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && !defined(BOOST_NO_CXX11_NOEXCEPT)
+// Standard containers only move their elements when they grow if moving
+// cannot throw; otherwise they copy whole trees.
+BOOST_STATIC_ASSERT(boost::is_nothrow_move_constructible<
+    boost::property_tree::ptree>::value);
+BOOST_STATIC_ASSERT(noexcept(boost::declval<boost::property_tree::ptree &>() =
+    boost::declval<boost::property_tree::ptree>()));
+#endif
 
 // Predicate for sorting keys
 template<class Ptree>
@@ -131,6 +150,353 @@ namespace boost { namespace property_tree {
 #   undef WIDECHAR
 #endif
 
+// Include char tests, case sensitive, hashed lookup
+#define CHTYPE char
+#define T(s) s
+#define PTREE boost::property_tree::hashed_ptree
+#define NOCASE 0
+#define WIDECHAR 0
+#   include "test_property_tree.hpp"
+#undef CHTYPE
+#undef T
+#undef PTREE
+#undef NOCASE
+#undef WIDECHAR
+
+// Include char tests, case sensitive, inline children
+typedef boost::property_tree::basic_ptree<std::string, std::string,
+    std::less<std::string>, boost::property_tree::inline_children<4> >
+    inline_ptree;
+#define CHTYPE char
+#define T(s) s
+#define PTREE inline_ptree
+#define NOCASE 0
+#define WIDECHAR 0
+#   include "test_property_tree.hpp"
+#undef CHTYPE
+#undef T
+#undef PTREE
+#undef NOCASE
+#undef WIDECHAR
+
+// Include char tests, case sensitive, interned keys
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+#define CHTYPE char
+#define T(s) s
+#define PTREE boost::property_tree::interned_ptree
+#define NOCASE 0
+#define WIDECHAR 0
+#   include "test_property_tree.hpp"
+#undef CHTYPE
+#undef T
+#undef PTREE
+#undef NOCASE
+#undef WIDECHAR
+#endif
+
+// Allocator that keeps track of the number of blocks it handed out
+struct allocation_counter
+{
+    static long live;
+    static long total;
+};
+long allocation_counter::live = 0;
+long allocation_counter::total = 0;
+
+template <typename T>
+struct counting_allocator : std::allocator<T>
+{
+    typedef typename std::allocator<T>::pointer pointer;
+    typedef typename std::allocator<T>::size_type size_type;
+    template <typename U> struct rebind { typedef counting_allocator<U> other; };
+
+    counting_allocator() {}
+    template <typename U>
+    counting_allocator(const counting_allocator<U> &) {}
+
+    pointer allocate(size_type n, const void * = 0)
+    {
+        pointer p = std::allocator<T>().allocate(n);
+        ++allocation_counter::live;
+        ++allocation_counter::total;
+        return p;
+    }
+    void deallocate(pointer p, size_type n)
+    {
+        --allocation_counter::live;
+        std::allocator<T>().deallocate(p, n);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const counting_allocator<T> &, const counting_allocator<U> &)
+{
+    return true;
+}
+template <typename T, typename U>
+bool operator!=(const counting_allocator<T> &, const counting_allocator<U> &)
+{
+    return false;
+}
+
+void test_allocator()
+{
+    using namespace boost::property_tree;
+    typedef basic_ptree<std::string, std::string, std::less<std::string>,
+                        counting_allocator<char> > counted_ptree;
+
+    // Leaves share a lazily allocated, empty child container.
+    const counted_ptree leaf;
+    BOOST_TEST(leaf.begin() == leaf.end());
+    const long live = allocation_counter::live;
+    const long total = allocation_counter::total;
+    {
+        counted_ptree pt;
+        BOOST_TEST(allocation_counter::total == total);
+        pt.put("a.b", 1);
+        pt.put("a.c", 2);
+        pt.add("d", 3);
+        BOOST_TEST(allocation_counter::total > total);
+        counted_ptree copy(pt);
+        BOOST_TEST(copy == pt);
+        counted_ptree other(copy, pt.get_allocator());
+        other.get_child("a").erase("b");
+        copy = other;
+        BOOST_TEST(copy.get<int>("a.c") == 2);
+        BOOST_TEST(!copy.get_optional<int>("a.b"));
+        copy.swap(pt);
+        BOOST_TEST(pt.get_child("a").size() == 1);
+    }
+    BOOST_TEST(allocation_counter::live == live);
+
+    // A narrow node is a single allocation; wider ones spill to the heap.
+    typedef basic_ptree<std::string, std::string, std::less<std::string>,
+        inline_children<3, counting_allocator<char> > > inline_counted_ptree;
+    const inline_counted_ptree inline_leaf;
+    BOOST_TEST(inline_leaf.begin() == inline_leaf.end());
+    const long inline_live = allocation_counter::live;
+    {
+        inline_counted_ptree pt;
+        const long before = allocation_counter::total;
+        pt.add("a", 1);
+        pt.add("b", 2);
+        pt.add("c", 3);
+        BOOST_TEST(allocation_counter::total == before + 1);
+        pt.add("d", 4);
+        BOOST_TEST(allocation_counter::total == before + 2);
+        pt.erase("a");
+        pt.add("e", 5);
+        BOOST_TEST(allocation_counter::total == before + 2);
+        inline_counted_ptree copy(pt);
+        BOOST_TEST(copy == pt);
+    }
+    BOOST_TEST(allocation_counter::live == inline_live);
+
+#if defined(BOOST_PROPERTY_TREE_HAS_PMR)
+    // A stateful allocator is propagated to keys, data and children.
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(
+        buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    pmr::ptree pt(&arena);
+    pt.put("first.long.path.component.name", "some value that is long enough");
+    pt.add("first.long.path.component.name", "another value, still long");
+    pmr::ptree &child = pt.get_child("first.long.path.component");
+    BOOST_TEST(child.get_allocator().resource() == &arena);
+    BOOST_TEST(child.begin()->first.get_allocator().resource() == &arena);
+    BOOST_TEST(child.begin()->second.data().get_allocator().resource() ==
+               &arena);
+    pmr::ptree copy(pt, &arena);
+    BOOST_TEST(copy == pt);
+    BOOST_TEST(copy.get_child("first").get_allocator().resource() == &arena);
+#endif
+}
+
+void test_path_allocations()
+{
+    using namespace boost::property_tree;
+    typedef std::basic_string<char, std::char_traits<char>,
+                              counting_allocator<char> > counted_string;
+    typedef basic_ptree<counted_string, counted_string> counted_string_ptree;
+
+    // Segments are longer than any small string buffer.
+    counted_string_ptree pt;
+    pt.put_child("first_long_segment_name.second_long_segment_name.third",
+                 counted_string_ptree(counted_string("data")));
+    const counted_string_ptree &cpt = pt;
+    const counted_string_ptree::path_type owned(
+        counted_string("first_long_segment_name.second_long_segment_name"));
+    const counted_string_ptree::path_type literal(
+        "first_long_segment_name.second_long_segment_name.third");
+
+    // Lookups neither copy the path nor create keys from it.
+    const long total = allocation_counter::total;
+    BOOST_TEST(cpt.get_child_optional(owned));
+    BOOST_TEST(cpt.get_child(literal).data() == "data");
+    BOOST_TEST(cpt.get_child_optional(
+        "first_long_segment_name.second_long_segment_name.third"));
+    BOOST_TEST(!cpt.get_child_optional(
+        "first_long_segment_name.missing_long_segment_name"));
+    BOOST_TEST(cpt.get<counted_string>(
+        "first_long_segment_name.second_long_segment_name.third") == "data");
+    BOOST_TEST(allocation_counter::total == total);
+
+    // A path made from a character array owns a copy of it.
+    std::string source("first_long_segment_name.second_long_segment_name");
+    const counted_string_ptree::path_type from_array(source.c_str());
+    source.assign(source.size(), 'x');
+    BOOST_TEST(cpt.get_child_optional(from_array));
+
+    // Nor do non-const accessors on a leaf, whose iterators all compare
+    // equal.
+    counted_string_ptree &leaf = pt.get_child(literal);
+    const counted_string_ptree &cleaf = leaf;
+    const long leaf_total = allocation_counter::total;
+    BOOST_TEST(leaf.begin() == cleaf.end());
+    BOOST_TEST(leaf.end() == cleaf.begin());
+    BOOST_TEST(leaf.find(counted_string("x")) == cleaf.not_found());
+    BOOST_TEST(leaf.to_iterator(leaf.not_found()) == leaf.end());
+    BOOST_TEST(leaf.equal_range(counted_string("x")).first ==
+               leaf.not_found());
+    BOOST_TEST(allocation_counter::total == leaf_total);
+    leaf.insert(leaf.end(), counted_string_ptree::value_type(
+        counted_string("x"), counted_string_ptree()));
+    BOOST_TEST(leaf.size() == 1u);
+    leaf.erase(leaf.begin());
+    BOOST_TEST(cpt.get_child(literal).data() == "data");
+
+    // Neither do lookups and updates along a compiled path.
+    const counted_string_ptree::compiled_path_type compiled(literal);
+    const long compiled_total = allocation_counter::total;
+    BOOST_TEST(cpt.get_child(compiled).data() == "data");
+    pt.get_child(compiled).data().clear();
+    BOOST_TEST(allocation_counter::total == compiled_total);
+
+    // Copies of a path own their values, and can be extended.
+    counted_string_ptree::path_type copy(literal);
+    copy /= "fourth_long_segment_name";
+    BOOST_TEST(!cpt.get_child_optional(copy));
+    pt.put_child(copy, counted_string_ptree(counted_string("more")));
+    BOOST_TEST(cpt.get_child("first_long_segment_name."
+        "second_long_segment_name.third.fourth_long_segment_name").data() ==
+        "more");
+}
+
+// Interned strings are archived as their text, and loading them back
+// yields the strings already in the pool.
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+void test_interned_serialization()
+{
+    using namespace boost::property_tree;
+    const interned_string key("interned_serialization_key"), none;
+    interned_ptree pt;
+    pt.put("interned_serialization_key.nested", "data");
+    pt.add("interned_serialization_key.nested", "more");
+
+    std::stringstream stream;
+    {
+        boost::archive::xml_oarchive oa(stream);
+        oa << boost::serialization::make_nvp("key", key);
+        oa << boost::serialization::make_nvp("empty", none);
+        oa << boost::serialization::make_nvp("pt", pt);
+    }
+    const std::size_t pool = interned_string::pool_size();
+    interned_string loaded, empty(key);
+    interned_ptree pt2;
+    {
+        boost::archive::xml_iarchive ia(stream);
+        ia >> boost::serialization::make_nvp("key", loaded);
+        ia >> boost::serialization::make_nvp("empty", empty);
+        ia >> boost::serialization::make_nvp("pt", pt2);
+    }
+    BOOST_TEST(loaded == key);
+    BOOST_TEST(empty.empty());
+    BOOST_TEST(pt2 == pt);
+    BOOST_TEST(pt2.front().first == key);
+    BOOST_TEST(interned_string::pool_size() == pool);
+}
+#endif
+
+// Converts every input with the default translator and with one that is
+// forced onto the streams, and expects the same results.
+template <typename E>
+void test_fast_translator(const char *const *inputs, std::size_t n,
+                          const E *values, std::size_t m)
+{
+    using namespace boost::property_tree;
+    typedef stream_translator<char, std::char_traits<char>,
+                              std::allocator<char>, E> translator;
+    // Behaves like the classic locale, but is not it.
+    const std::locale streams(std::locale::classic(),
+                              new std::numpunct<char>);
+    translator fast, slow(streams);
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::string in(inputs[i]);
+        BOOST_TEST(fast.get_value(in) == slow.get_value(in));
+    }
+    for (std::size_t i = 0; i < m; ++i) {
+        BOOST_TEST(fast.put_value(values[i]) == slow.put_value(values[i]));
+        BOOST_TEST(fast.get_value(*fast.put_value(values[i])) == values[i]);
+    }
+}
+
+void test_fast_translators()
+{
+    const char *const ints[] = { "0", "42", " 42", "42 ", "\t-7\n", "+5",
+        "-0", "007", "0x10", "12abc", "", " ", "1 2", "2147483647",
+        "2147483648", "-2147483648", "-2147483649", "1e3", "4.0" };
+    const std::size_t nints = sizeof(ints) / sizeof(*ints);
+    const int int_values[] = { 0, 1, -1, 123456,
+        (std::numeric_limits<int>::max)(), (std::numeric_limits<int>::min)() };
+    test_fast_translator(ints, nints, int_values,
+        sizeof(int_values) / sizeof(*int_values));
+    const unsigned uint_values[] = { 0, 1,
+        (std::numeric_limits<unsigned>::max)() };
+    test_fast_translator(ints, nints, uint_values,
+        sizeof(uint_values) / sizeof(*uint_values));
+    const long long ll_values[] = {
+        (std::numeric_limits<long long>::max)(),
+        (std::numeric_limits<long long>::min)() };
+    test_fast_translator(ints, nints, ll_values,
+        sizeof(ll_values) / sizeof(*ll_values));
+
+    const char *const smalls[] = { "0", "127", "128", "-128", "-129", "255",
+        "256", "-1", " 12 ", "a" };
+    const std::size_t nsmalls = sizeof(smalls) / sizeof(*smalls);
+    const signed char sc_values[] = { 0, -128, 127 };
+    test_fast_translator(smalls, nsmalls, sc_values,
+        sizeof(sc_values) / sizeof(*sc_values));
+    const unsigned char uc_values[] = { 0, 255 };
+    test_fast_translator(smalls, nsmalls, uc_values,
+        sizeof(uc_values) / sizeof(*uc_values));
+
+    const char *const bools[] = { "0", "1", "true", "false", " true ", "2",
+        "01", "TRUE", "yes", "", "truex" };
+    const bool bool_values[] = { true, false };
+    test_fast_translator(bools, sizeof(bools) / sizeof(*bools), bool_values,
+        sizeof(bool_values) / sizeof(*bool_values));
+
+    const char *const reals[] = { "0", "1.5", " -2.25e3 ", ".5", "1.",
+        "1e", "1e400", "-1e400", "1e-400", "inf", "nan", "0x1p3", "+1",
+        "3.14159265358979323846", "1,5" };
+    const std::size_t nreals = sizeof(reals) / sizeof(*reals);
+    const double double_values[] = { 0.0, -0.0, 0.1, 1.0 / 3, 1e300,
+        -4.9e-324, 123456789012345678.0,
+        (std::numeric_limits<double>::max)() };
+    test_fast_translator(reals, nreals, double_values,
+        sizeof(double_values) / sizeof(*double_values));
+    const float float_values[] = { 0.1f, 1.0f / 3, 3e38f };
+    test_fast_translator(reals, nreals, float_values,
+        sizeof(float_values) / sizeof(*float_values));
+    const long double ld_values[] = { 0.1L, 1.0L / 3 };
+    test_fast_translator(reals, nreals, ld_values,
+        sizeof(ld_values) / sizeof(*ld_values));
+
+    // Non-finite values are written by the streams.
+    boost::property_tree::ptree pt;
+    pt.put_value(std::numeric_limits<double>::infinity());
+    BOOST_TEST(pt.data() == "inf");
+}
+
 template <typename Ptree>
 void run_tests(Ptree* pt)
 {
@@ -142,6 +508,8 @@ void run_tests(Ptree* pt)
     test_pushpop(pt);
     test_container_iteration(pt);
     test_swap(pt);
+    test_leaf_nodes(pt);
+    test_move(pt);
     test_sort_reverse(pt);
     test_case(pt);
     test_comparison(pt);
@@ -151,6 +519,8 @@ void run_tests(Ptree* pt)
     test_equal_range(pt);
     test_path_separator(pt);
     test_path(pt);
+    test_compiled_path(pt);
+    test_get_many(pt);
     test_precision(pt);
     test_locale(pt);
     test_custom_data_type(pt);
@@ -198,5 +568,32 @@ int main(int, char *[])
     }
 #endif
 
+    // char tests, hashed lookup
+    {
+        hashed_ptree *pt = 0;
+        run_tests(pt);
+    }
+
+    // char tests, inline children
+    {
+        inline_ptree *pt = 0;
+        run_tests(pt);
+    }
+
+    // char tests, interned keys
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+    {
+        interned_ptree *pt = 0;
+        run_tests(pt);
+    }
+#endif
+
+    test_allocator();
+    test_path_allocations();
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+    test_interned_serialization();
+#endif
+    test_fast_translators();
+
     return boost::report_errors();
 }
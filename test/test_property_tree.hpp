@@ -342,6 +342,131 @@ void test_swap(PTREE *)
 
 }
 
+void test_leaf_nodes(PTREE *)
+{
+
+    // Leaves don't necessarily own a child container; everything must
+    // still behave as if they had an empty one.
+    const PTREE leaf(T("data"));
+    BOOST_TEST(leaf.empty());
+    BOOST_TEST(leaf.size() == 0);
+    BOOST_TEST(leaf.begin() == leaf.end());
+    BOOST_TEST(leaf.rbegin() == leaf.rend());
+    BOOST_TEST(leaf.ordered_begin() == leaf.not_found());
+    BOOST_TEST(leaf.find(T("key")) == leaf.not_found());
+    BOOST_TEST(leaf.count(T("key")) == 0);
+    BOOST_TEST(leaf.equal_range(T("key")).first ==
+               leaf.equal_range(T("key")).second);
+    BOOST_TEST(leaf.to_iterator(leaf.not_found()) == leaf.end());
+    BOOST_TEST(!leaf.get_child_optional(T("key")));
+    BOOST_TEST(leaf.get(T("key"), 5) == 5);
+
+    // Copies, comparison and swap
+    PTREE copy(leaf);
+    BOOST_TEST(copy == leaf);
+    PTREE parent;
+    parent.put(T("key"), T("value"));
+    BOOST_TEST(parent != copy);
+    copy.swap(parent);
+    BOOST_TEST(copy.size() == 1);
+    BOOST_TEST(parent.empty());
+    BOOST_TEST(parent == leaf);
+    parent = copy;
+    BOOST_TEST(parent == copy);
+    copy = leaf;
+    BOOST_TEST(copy.empty());
+    BOOST_TEST(copy == leaf);
+
+    // Mutating operations on a leaf
+    PTREE pt;
+    BOOST_TEST(pt.erase(T("key")) == 0);
+    pt.sort();
+    pt.reverse();
+    pt.clear();
+    BOOST_TEST(pt.empty());
+    PTREE::iterator end = pt.end();
+    BOOST_TEST(pt.begin() == end);
+    BOOST_TEST(pt.find(T("key")) == pt.not_found());
+    // The first child invalidates the leaf's end iterator.
+    PTREE::iterator it = pt.insert(end, std::make_pair(T("key"), leaf));
+    BOOST_TEST(pt.begin() == it);
+    BOOST_TEST(pt.size() == 1);
+    end = pt.end();
+    BOOST_TEST(pt.insert(end, std::make_pair(T("key"), leaf)) != end);
+    BOOST_TEST(pt.end() == end);
+    pt.pop_back();
+
+    // A node emptied again keeps working
+    pt.erase(it);
+    BOOST_TEST(pt.empty());
+    PTREE emptied(pt);
+    BOOST_TEST(emptied.empty());
+    BOOST_TEST(emptied == pt);
+
+}
+
+void test_move(PTREE *)
+{
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES)
+
+    PTREE src;
+    src.put(T("key1.key2"), T("data2"));
+    src.put(T("key1.key3"), T("data3"));
+    const PTREE orig(src);
+    const PTREE *inner = &src.get_child(T("key1"));
+
+    // Construction takes the children over, without copying them
+    PTREE moved(std::move(src));
+    BOOST_TEST(moved == orig);
+    BOOST_TEST(&moved.get_child(T("key1")) == inner);
+    BOOST_TEST(src.empty());
+
+    // Assignment, including from a descendant
+    PTREE target;
+    target.put(T("other"), T("data"));
+    target = std::move(moved);
+    BOOST_TEST(target == orig);
+    BOOST_TEST(&target.get_child(T("key1")) == inner);
+    target = std::move(target.get_child(T("key1")));
+    BOOST_TEST(target == orig.get_child(T("key1")));
+
+    // Insertion moves the subtree into place
+    PTREE sub(orig);
+    inner = &sub.get_child(T("key1"));
+    PTREE pt;
+    PTREE &added = pt.add_child(T("a.b"), std::move(sub));
+    BOOST_TEST(added == orig);
+    BOOST_TEST(&added.get_child(T("key1")) == inner);
+    PTREE &put = pt.put_child(T("a.b"), PTREE(T("data")));
+    BOOST_TEST(&put == &added);
+    BOOST_TEST(put.data() == T("data"));
+    BOOST_TEST(put.empty());
+    pt.push_back(std::make_pair(T("c"), PTREE(T("data1"))));
+    pt.push_front(std::make_pair(T("d"), PTREE(T("data2"))));
+    pt.insert(pt.begin(), std::make_pair(T("e"), PTREE(T("data3"))));
+    BOOST_TEST(pt.size() == 4);
+    BOOST_TEST(pt.front().first == T("e"));
+    BOOST_TEST(pt.get<std::basic_string<CHTYPE> >(T("c")) == T("data1"));
+#endif
+
+#if !defined(BOOST_NO_CXX11_RVALUE_REFERENCES) && \
+    !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES) && \
+    !defined(BOOST_NO_CXX11_HDR_TUPLE)
+    PTREE em;
+    PTREE::iterator it = em.emplace_back(T("key1"));
+    BOOST_TEST(it == em.begin());
+    BOOST_TEST(it->first == T("key1"));
+    BOOST_TEST(it->second.empty());
+    BOOST_TEST(it->second.data().empty());
+    em.emplace_back(T("key2"), T("data2"));
+    BOOST_TEST(em.get<std::basic_string<CHTYPE> >(T("key2")) == T("data2"));
+    em.emplace_back(T("key3"), em);
+    BOOST_TEST(em.size() == 3);
+    BOOST_TEST(em.back().second.size() == 2);
+#endif
+
+}
+
 void test_sort_reverse(PTREE *)
 {
     
@@ -1009,6 +1134,120 @@ void test_path(PTREE *)
 
 }
 
+void test_compiled_path(PTREE *)
+{
+
+    typedef PTREE::path_type path;
+    typedef PTREE::compiled_path_type compiled;
+
+    const compiled p1(T("key1.key2.key3"));
+    const compiled p2(path(T("key1/key4"), CHTYPE('/')));
+    const compiled p3(T("key1.key5"));
+    BOOST_TEST(p1.size() == 3);
+    BOOST_TEST(p2.size() == 2);
+
+    // Put creates the missing parents, and replaces existing values
+    PTREE pt;
+    pt.put(p1, 1);
+    pt.put(p2, 2);
+    BOOST_TEST(pt.size() == 1);
+    BOOST_TEST(pt.get<int>(T("key1.key2.key3")) == 1);
+    BOOST_TEST(pt.get<int>(T("key1.key4")) == 2);
+    pt.put(p1, 3);
+    BOOST_TEST(pt.count(T("key1")) == 1);
+    BOOST_TEST(pt.get<int>(p1) == 3);
+
+    // Add always adds a node
+    pt.add(p2, 4);
+    BOOST_TEST(pt.get_child(T("key1")).count(T("key4")) == 2);
+
+    // Get
+    BOOST_TEST(pt.get<int>(p1, 0) == 3);
+    BOOST_TEST(pt.get<int>(p3, 5) == 5);
+    BOOST_TEST(pt.get(p3, T("default")) == T("default"));
+    BOOST_TEST(pt.get_optional<int>(p1).get() == 3);
+    BOOST_TEST(!pt.get_optional<int>(p3));
+    BOOST_TEST(&pt.get_child(p1) == &pt.get_child(T("key1.key2.key3")));
+    BOOST_TEST(pt.get_child_optional(p1));
+    BOOST_TEST(!pt.get_child_optional(p3));
+    const PTREE &cpt = pt;
+    BOOST_TEST(&cpt.get_child(p1) == &pt.get_child(p1));
+    BOOST_TEST(&cpt.get_child(p3, cpt) == &cpt);
+
+    // Put and add children
+    PTREE &child = pt.put_child(p3, PTREE(T("data")));
+    BOOST_TEST(&pt.get_child(p3) == &child);
+    BOOST_TEST(&pt.put_child(p3, PTREE(T("data2"))) == &child);
+    BOOST_TEST(child.data() == T("data2"));
+    pt.add_child(p3, PTREE(T("data3")));
+    BOOST_TEST(pt.get_child(T("key1")).count(T("key5")) == 2);
+
+    // The empty path refers to the tree itself
+    BOOST_TEST(&pt.get_child(compiled(path())) == &pt);
+
+    // Bad path
+    try {
+        pt.get_child(compiled(T("key1.nonexistent")));
+        BOOST_ERROR("No required exception thrown");
+    } catch (boost::property_tree::ptree_bad_path &e) {
+        BOOST_TEST(e.path<compiled>().size() == 2);
+    } catch (...) {
+        BOOST_ERROR("Wrong exception type thrown");
+    }
+
+}
+
+void test_get_many(PTREE *)
+{
+
+    typedef PTREE::compiled_path_type compiled;
+
+    PTREE pt;
+    pt.put(T("server.http.port"), 80);
+    pt.put(T("server.http.host"), T("localhost"));
+    pt.put(T("server.name"), T("main"));
+    pt.put(T("client.retries"), 3);
+
+    std::vector<compiled> paths;
+    paths.push_back(compiled(T("server.http.port")));
+    paths.push_back(compiled(T("server.http.host")));
+    paths.push_back(compiled(T("server.http.missing.deeper")));
+    paths.push_back(compiled(T("server.http.port.deeper")));
+    paths.push_back(compiled(T("server.name")));
+    paths.push_back(compiled(T("client.retries")));
+    paths.push_back(compiled(T("client")));
+
+    // Children, in the order of the paths
+    std::vector<boost::optional<PTREE &> > children;
+    pt.get_child_many(paths.begin(), paths.end(),
+                      std::back_inserter(children));
+    BOOST_TEST(children.size() == paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        BOOST_TEST(!children[i] == !pt.get_child_optional(paths[i]));
+        if (children[i])
+            BOOST_TEST(&*children[i] == &pt.get_child(paths[i]));
+    }
+
+    // Values
+    const PTREE &cpt = pt;
+    std::vector<boost::optional<int> > values;
+    cpt.get_many<int>(paths.begin(), paths.end(),
+                      std::back_inserter(values));
+    BOOST_TEST(values.size() == paths.size());
+    BOOST_TEST(values[0].get() == 80);
+    BOOST_TEST(!values[1]);
+    BOOST_TEST(!values[2]);
+    BOOST_TEST(!values[3]);
+    BOOST_TEST(values[5].get() == 3);
+
+    // Nothing to look up
+    std::vector<boost::optional<const PTREE &> > none;
+    cpt.get_child_many(paths.begin(), paths.begin(),
+                       std::back_inserter(none));
+    BOOST_TEST(none.empty());
+
+}
+
 void test_precision(PTREE *)
 {
 
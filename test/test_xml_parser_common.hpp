@@ -12,6 +12,9 @@
 
 #include "test_utils.hpp"
 #include <boost/property_tree/xml_parser.hpp>
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+#include <boost/property_tree/interned_string.hpp>
+#endif
 #include "xml_parser_test_data.hpp"
 
 struct ReadFuncWS
@@ -57,6 +60,335 @@ template <typename Ch> int umlautsize();
 template <> inline int umlautsize<char>() { return 2; }
 template <> inline int umlautsize<wchar_t>() { return 1; }
 
+// Reading from a buffer in place gives the same tree as reading from a
+// stream.
+template<class Ptree>
+void test_xml_in_situ()
+{
+    using namespace boost::property_tree;
+    typedef typename Ptree::key_type Str;
+    typedef typename Str::value_type Ch;
+    const char *docs[] = {
+        ok_data_1, ok_data_2, ok_data_3, ok_data_4, ok_data_5,
+        bug_data_pr2855, bug_data_pr1678, bug_data_pr5203, bug_data_pr4840,
+        error_data_1, error_data_2
+    };
+    const int flag_sets[] = {
+        0, xml_parser::no_concat_text, xml_parser::no_comments,
+        xml_parser::trim_whitespace,
+        xml_parser::trim_whitespace | xml_parser::no_comments
+    };
+    for (std::size_t d = 0; d < sizeof(docs) / sizeof(*docs); ++d) {
+        for (std::size_t f = 0; f < sizeof(flag_sets) / sizeof(*flag_sets);
+             ++f) {
+            const Str text = detail::widen<Str>(docs[d]);
+            Ptree expected, pt;
+            unsigned long line = 0;
+            try {
+                std::basic_istringstream<Ch> stream(text);
+                read_xml(stream, expected, flag_sets[f]);
+            } catch (xml_parser_error &e) {
+                line = e.line();
+            }
+            std::vector<Ch> buffer(text.begin(), text.end());
+            buffer.push_back(Ch());
+            try {
+                read_xml(&buffer[0], text.size(), pt, flag_sets[f]);
+                BOOST_TEST(line == 0);
+                BOOST_TEST(pt == expected);
+            } catch (xml_parser_error &e) {
+                BOOST_TEST_EQ(e.line(), line);
+            }
+        }
+    }
+}
+
+// Counts the blocks that a reader context allocates.
+template<int N>
+struct counting_allocator
+{
+    static int allocated, live;
+    static void *allocate(std::size_t size)
+    {
+        ++allocated;
+        ++live;
+        return ::operator new(size);
+    }
+    static void free(void *p)
+    {
+        --live;
+        ::operator delete(p);
+    }
+};
+template<int N> int counting_allocator<N>::allocated = 0;
+template<int N> int counting_allocator<N>::live = 0;
+
+template<class Ptree>
+void test_xml_reader_context()
+{
+    using namespace boost::property_tree;
+    typedef typename Ptree::key_type Str;
+    typedef typename Str::value_type Ch;
+    typedef counting_allocator<0> counter;
+
+    // Too large for the pool's static memory.
+    std::string doc = "<root>";
+    for (int i = 0; i < 2000; ++i)
+        doc += "<item a=\"1\" b=\"2\">text<!-- c --></item>";
+    doc += "</root>";
+    const Str text = detail::widen<Str>(doc.c_str());
+    Ptree expected;
+    std::basic_istringstream<Ch> plain(text);
+    read_xml(plain, expected);
+
+    xml_reader_context<Ch> context;
+    context.set_allocator(&counter::allocate, &counter::free);
+    counter::allocated = 0;
+    int first = 0;
+    for (int i = 0; i < 3; ++i) {
+        Ptree pt;
+        std::basic_istringstream<Ch> stream(text);
+        read_xml(stream, pt, context);
+        BOOST_TEST(pt == expected);
+        if (i == 0)
+            first = counter::allocated;
+    }
+    // After the first document, the pool's blocks are merged into one at
+    // most, which is then reused as it is.
+    BOOST_TEST(first > 0);
+    BOOST_TEST(counter::allocated <= first + 1);
+    const int warm = counter::allocated;
+
+    std::vector<Ch> buffer(text.begin(), text.end());
+    buffer.push_back(Ch());
+    Ptree in_place;
+    read_xml(&buffer[0], text.size(), in_place, context);
+    BOOST_TEST(in_place == expected);
+    BOOST_TEST_EQ(counter::allocated, warm);
+
+    // Errors leave the context usable.
+    const Str bad = detail::widen<Str>("<a>\n<b></a>");
+    std::basic_istringstream<Ch> bad_stream(bad);
+    Ptree pt;
+    try {
+        read_xml(bad_stream, pt, context);
+        BOOST_ERROR("No required exception thrown");
+    } catch (xml_parser_error &e) {
+        BOOST_TEST_EQ(e.line(), 2ul);
+    }
+    std::basic_istringstream<Ch> again(text);
+    read_xml(again, pt, context);
+    BOOST_TEST(pt == expected);
+
+    context.release();
+    BOOST_TEST_EQ(counter::live, 0);
+
+    // Small blocks give the same result.
+    xml_reader_context<Ch> small_blocks;
+    small_blocks.set_allocator(&counter::allocate, &counter::free);
+    small_blocks.set_block_size(1024);
+    std::basic_istringstream<Ch> small(text);
+    read_xml(small, pt, small_blocks);
+    BOOST_TEST(pt == expected);
+    BOOST_TEST(counter::allocated > warm + 100);
+
+    // Blocks sized after the input hold the document's nodes at once.
+    xml_reader_context<Ch> sized;
+    sized.set_allocator(&counter::allocate, &counter::free);
+    sized.set_block_size(xml_reader_context<Ch>::input_sized);
+    const int unsized = counter::allocated;
+    std::basic_istringstream<Ch> whole(text);
+    read_xml(whole, pt, sized);
+    BOOST_TEST(pt == expected);
+    BOOST_TEST_EQ(counter::allocated, unsized + 1);
+}
+
+// The outermost elements with the given name, in document order.
+template<class Ptree>
+void collect_elements(const Ptree &pt, const typename Ptree::key_type &name,
+                      std::vector<Ptree> &elements)
+{
+    for (typename Ptree::const_iterator it = pt.begin(); it != pt.end(); ++it)
+    {
+        if (it->first == name)
+            elements.push_back(it->second);
+        else
+            collect_elements(it->second, name, elements);
+    }
+}
+
+template<class Ptree>
+struct collect_into
+{
+    explicit collect_into(std::vector<Ptree> &elements) : elements(&elements) {}
+    void operator()(Ptree &pt) const { elements->push_back(pt); }
+    std::vector<Ptree> *elements;
+};
+
+// Reading elements one at a time gives the same trees as reading the whole
+// document.
+template<class Ptree>
+void test_xml_element_reader()
+{
+    using namespace boost::property_tree;
+    typedef typename Ptree::key_type Str;
+    typedef typename Str::value_type Ch;
+
+    std::string doc =
+        "<?xml version=\"1.0\"?>\n"
+        "<!DOCTYPE export [ <!ELEMENT record ANY> ]>\n"
+        "<export>\n"
+        "  <!-- <record>not an element</record> -->\n"
+        "  <header><![CDATA[<record/>]]></header>\n";
+    for (int i = 0; i < 3000; ++i) {
+        std::ostringstream record;
+        record << "  <record id=\"" << i << "\" note='a > b'>\n"
+               << "    <name>item &amp; " << i << "</name><!-- c" << i
+               << " -->\n";
+        if (i % 7 == 0)
+            record << "    <record nested=\"1\"><x/></record>\n";
+        if (i % 11 == 0)
+            record << "    <?pi <record>?>\n";
+        record << "    text " << i << "  </record>\n";
+        if (i % 13 == 0)
+            record << "  <group><record id=\"g" << i << "\"/></group>\n";
+        doc += record.str();
+    }
+    doc += "</export>\n";
+    const Str text = detail::widen<Str>(doc.c_str());
+    const Str name = detail::widen<Str>("record");
+
+    const int flag_sets[] = {
+        0, xml_parser::no_concat_text, xml_parser::no_comments,
+        xml_parser::trim_whitespace
+    };
+    Ptree element;
+    for (std::size_t f = 0; f < sizeof(flag_sets) / sizeof(*flag_sets); ++f) {
+        std::basic_istringstream<Ch> whole(text);
+        Ptree pt;
+        read_xml(whole, pt, flag_sets[f]);
+        std::vector<Ptree> expected;
+        collect_elements(pt, name, expected);
+        BOOST_TEST_EQ(expected.size(), 3000u + 3000u / 13 + 1);
+
+        std::basic_istringstream<Ch> stream(text);
+        xml_element_reader<Ptree> reader(stream, name, flag_sets[f]);
+        std::vector<Ptree> elements;
+        while (reader.next(element))
+            elements.push_back(element);
+        BOOST_TEST(elements == expected);
+        BOOST_TEST(!reader.next(element));
+    }
+
+    std::basic_istringstream<Ch> stream(text);
+    std::vector<Ptree> elements;
+    read_xml_elements<Ptree>(stream, name, collect_into<Ptree>(elements));
+    BOOST_TEST_EQ(elements.size(), 3000u + 3000u / 13 + 1);
+    BOOST_TEST(elements.front().template get<int>(
+        detail::widen<Str>("<xmlattr>.id")) == 0);
+
+    // No matching elements.
+    std::basic_istringstream<Ch> none(text);
+    xml_element_reader<Ptree> other(none, detail::widen<Str>("missing"));
+    BOOST_TEST(!other.next(element));
+
+    // Errors inside an element are reported at the line of the document.
+    std::string bad = doc;
+    std::string::size_type pos = bad.find("<name>item &amp; 2000");
+    bad.replace(pos, 6, "<name =");
+    unsigned long line = 0;
+    try {
+        std::basic_istringstream<Ch> whole(detail::widen<Str>(bad.c_str()));
+        Ptree pt;
+        read_xml(whole, pt);
+    } catch (xml_parser_error &e) {
+        line = e.line();
+    }
+    BOOST_TEST(line > 1000);
+    std::basic_istringstream<Ch> bad_stream(detail::widen<Str>(bad.c_str()));
+    xml_element_reader<Ptree> bad_reader(bad_stream, name);
+    int read = 0;
+    try {
+        while (bad_reader.next(element))
+            ++read;
+        BOOST_ERROR("no error for a malformed element");
+    } catch (xml_parser_error &e) {
+        BOOST_TEST_EQ(e.line(), line);
+    }
+    BOOST_TEST_EQ(read, 2000 + 2000 / 13 + 1);
+
+    // An element cut short.
+    std::basic_istringstream<Ch> cut(detail::widen<Str>(
+        "<export><record><a>1</a>"));
+    xml_element_reader<Ptree> cut_reader(cut, name);
+    BOOST_TEST_THROWS(cut_reader.next(element), xml_parser_error);
+}
+
+// The writer's exact output for attributes, entities, comments and texts,
+// and a stream that fails.
+template<class Ptree>
+void test_xml_writer()
+{
+    using namespace boost::property_tree;
+    typedef typename Ptree::key_type Str;
+    typedef typename Str::value_type Ch;
+    Ptree pt;
+    pt.put(detail::widen<Str>("a.<xmlattr>.x"),
+           detail::widen<Str>("1 < 2 & \"3\""));
+    pt.put(detail::widen<Str>("a.<xmlattr>.y"), detail::widen<Str>("it's"));
+    pt.put(detail::widen<Str>("a"), detail::widen<Str>("   "));
+    pt.add(detail::widen<Str>("a.<xmlcomment>"), detail::widen<Str>("note"));
+    pt.add(detail::widen<Str>("a.b"), Str());
+    pt.add(detail::widen<Str>("a.<xmltext>"), detail::widen<Str>("x > y"));
+    pt.add(detail::widen<Str>("a.c.<xmlattr>.z"), Str());
+
+    std::basic_ostringstream<Ch> compact;
+    write_xml(compact, pt);
+    BOOST_TEST(compact.str() == detail::widen<Str>(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        "<a x=\"1 &lt; 2 &amp; &quot;3&quot;\" y=\"it&apos;s\">&#32;  "
+        "<!--note--><b/>x &gt; y<c z=\"\"/></a>"));
+
+    std::basic_ostringstream<Ch> pretty;
+    write_xml(pretty, pt, xml_writer_make_settings<Str>(Ch(' '), 2));
+    BOOST_TEST(pretty.str() == detail::widen<Str>(
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        "<a x=\"1 &lt; 2 &amp; &quot;3&quot;\" y=\"it&apos;s\">\n"
+        "  &#32;  \n"
+        "  <!--note-->\n"
+        "  <b/>\n"
+        "  x &gt; y\n"
+        "  <c z=\"\"/>\n"
+        "</a>\n"));
+
+    std::basic_ostringstream<Ch> failed;
+    failed.setstate(std::ios_base::badbit);
+    BOOST_TEST_THROWS(write_xml(failed, pt), xml_parser_error);
+}
+
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+void test_xml_interned_keys()
+{
+    using namespace boost::property_tree;
+    std::istringstream stream(
+        "<list><entry kind=\"alpha\">one</entry>"
+        "<entry kind=\"beta\">two<!--note--></entry></list>");
+    interned_ptree pt;
+    read_xml(stream, pt);
+    const interned_ptree &list = pt.get_child("list");
+    BOOST_TEST_EQ(list.count("entry"), 2u);
+    BOOST_TEST(list.back().second.get<std::string>("<xmlattr>.kind") ==
+               "beta");
+    BOOST_TEST(list.back().second.get<std::string>("<xmlcomment>") ==
+               "note");
+    BOOST_TEST(list.front().first.data() == list.back().first.data());
+
+    // Attribute values and text are data, and are not interned.
+    BOOST_TEST(!interned_string::lookup("alpha", "alpha" + 5));
+    BOOST_TEST(!interned_string::lookup("two", "two" + 3));
+}
+#endif
+
 template<class Ptree>
 void test_xml_parser()
 {
@@ -145,6 +477,11 @@ void test_xml_parser()
         4, 13, 15
     );
 
+    test_xml_in_situ<Ptree>();
+    test_xml_reader_context<Ptree>();
+    test_xml_element_reader<Ptree>();
+    test_xml_writer<Ptree>();
+
 }
 
 #endif
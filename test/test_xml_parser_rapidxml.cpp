@@ -22,6 +22,9 @@ int main(int , char *[])
     using namespace boost::property_tree;
     test_xml_parser<ptree>();
     test_xml_parser<iptree>();
+#ifndef BOOST_NO_CXX11_HDR_MUTEX
+    test_xml_interned_keys();
+#endif
 #ifndef BOOST_NO_CWCHAR
     using std::locale;
     // We need a UTF-8-aware global locale now.